@@ -0,0 +1,24 @@
+################################################################################
+# Automatically-generated file. Do not edit!
+################################################################################
+
+# Add inputs and outputs from these tool invocations to the build variables 
+CPP_SRCS += \
+../benchmarks/PaleoLatitudeBenchmark.cpp 
+
+OBJS += \
+./benchmarks/PaleoLatitudeBenchmark.o 
+
+CPP_DEPS += \
+./benchmarks/PaleoLatitudeBenchmark.d 
+
+
+# Each subdirectory must supply rules for building sources it contributes
+benchmarks/%.o: ../benchmarks/%.cpp
+	@echo 'Building file: $<'
+	@echo 'Invoking: GCC C++ Compiler'
+	g++ -O3 -Wall -c -fmessage-length=0  -std=gnu++17  -DNDEBUG -MMD -MP -MF"$(@:%.o=%.d)" -MT"$(@:%.o=%.d)" -o "$@" "$<"
+	@echo 'Finished building: $<'
+	@echo ' '
+
+
@@ -0,0 +1,5 @@
+#!/bin/bash
+# Runs all benchmarks (or those matching --benchmark_filter=...) and also writes the results in
+# JSON format to benchmark-results.json, which can be compared between releases using the
+# compare.py tool of Google Benchmark
+./PaleoLatitudeBenchmark --benchmark_out=benchmark-results.json --benchmark_out_format=json $@
@@ -4,5 +4,5 @@
 
 USER_OBJS :=
 
-LIBS := -lgtest -lpugixml -lpthread -lboost_program_options -lkmlengine -lkmlbase -lkmldom
+LIBS := -lgtest -lexpat -lpthread -lboost_program_options
 
@@ -7,26 +7,38 @@ CPP_SRCS += \
 ../src/util/Exception.cpp \
 ../src/util/LogStream.cpp \
 ../src/util/Logger.cpp \
-../src/util/Util.cpp 
+../src/util/MappedFile.cpp \
+../src/util/Stats.cpp \
+../src/util/ThreadPool.cpp \
+../src/util/Util.cpp \
+../src/util/XMLStreamParser.cpp 
 
 OBJS += \
 ./src/util/Exception.o \
 ./src/util/LogStream.o \
 ./src/util/Logger.o \
-./src/util/Util.o 
+./src/util/MappedFile.o \
+./src/util/Stats.o \
+./src/util/ThreadPool.o \
+./src/util/Util.o \
+./src/util/XMLStreamParser.o 
 
 CPP_DEPS += \
 ./src/util/Exception.d \
 ./src/util/LogStream.d \
 ./src/util/Logger.d \
-./src/util/Util.d 
+./src/util/MappedFile.d \
+./src/util/Stats.d \
+./src/util/ThreadPool.d \
+./src/util/Util.d \
+./src/util/XMLStreamParser.d 
 
 
 # Each subdirectory must supply rules for building sources it contributes
 src/util/%.o: ../src/util/%.cpp
 	@echo 'Building file: $<'
 	@echo 'Invoking: GCC C++ Compiler'
-	g++ -std=c++0x -O0 -g3 -Wall -c -fmessage-length=0 -MMD -MP -MF"$(@:%.o=%.d)" -MT"$(@)" -o "$@" "$<"
+	g++ -std=c++17 -O0 -g3 -Wall -c -fmessage-length=0 -MMD -MP -MF"$(@:%.o=%.d)" -MT"$(@)" -o "$@" "$<"
 	@echo 'Finished building: $<'
 	@echo ' '
 
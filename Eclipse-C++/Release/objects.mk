@@ -4,5 +4,5 @@
 
 USER_OBJS :=
 
-LIBS := -lboost_program_options -lkmlengine -lpugixml -lkmlbase -lkmldom
+LIBS := -lboost_program_options -lexpat -lpthread
 
@@ -4,27 +4,42 @@
 
 # Add inputs and outputs from these tool invocations to the build variables 
 CPP_SRCS += \
+../src/paleo_latitude/PLCrossingKernel.cpp \
+../src/paleo_latitude/PLDataset.cpp \
 ../src/paleo_latitude/PLEulerPolesReconstructions.cpp \
+../src/paleo_latitude/PLPaleolatitudeKernel.cpp \
 ../src/paleo_latitude/PLParameters.cpp \
 ../src/paleo_latitude/PLPlate.cpp \
 ../src/paleo_latitude/PLPlates.cpp \
 ../src/paleo_latitude/PLPolarWanderPaths.cpp \
+../src/paleo_latitude/PLServer.cpp \
+../src/paleo_latitude/PLSitesBatch.cpp \
 ../src/paleo_latitude/PaleoLatitude.cpp 
 
 OBJS += \
+./src/paleo_latitude/PLCrossingKernel.o \
+./src/paleo_latitude/PLDataset.o \
 ./src/paleo_latitude/PLEulerPolesReconstructions.o \
+./src/paleo_latitude/PLPaleolatitudeKernel.o \
 ./src/paleo_latitude/PLParameters.o \
 ./src/paleo_latitude/PLPlate.o \
 ./src/paleo_latitude/PLPlates.o \
 ./src/paleo_latitude/PLPolarWanderPaths.o \
+./src/paleo_latitude/PLServer.o \
+./src/paleo_latitude/PLSitesBatch.o \
 ./src/paleo_latitude/PaleoLatitude.o 
 
 CPP_DEPS += \
+./src/paleo_latitude/PLCrossingKernel.d \
+./src/paleo_latitude/PLDataset.d \
 ./src/paleo_latitude/PLEulerPolesReconstructions.d \
+./src/paleo_latitude/PLPaleolatitudeKernel.d \
 ./src/paleo_latitude/PLParameters.d \
 ./src/paleo_latitude/PLPlate.d \
 ./src/paleo_latitude/PLPlates.d \
 ./src/paleo_latitude/PLPolarWanderPaths.d \
+./src/paleo_latitude/PLServer.d \
+./src/paleo_latitude/PLSitesBatch.d \
 ./src/paleo_latitude/PaleoLatitude.d 
 
 
@@ -32,7 +47,7 @@ CPP_DEPS += \
 src/paleo_latitude/%.o: ../src/paleo_latitude/%.cpp
 	@echo 'Building file: $<'
 	@echo 'Invoking: GCC C++ Compiler'
-	g++ -O3 -Wall -c -fmessage-length=0  -std=gnu++11  -DNDEBUG -MMD -MP -MF"$(@:%.o=%.d)" -MT"$(@:%.o=%.d)" -o "$@" "$<"
+	g++ -O3 -Wall -c -fmessage-length=0  -std=gnu++17  -DNDEBUG -MMD -MP -MF"$(@:%.o=%.d)" -MT"$(@:%.o=%.d)" -o "$@" "$<"
 	@echo 'Finished building: $<'
 	@echo ' '
 
@@ -0,0 +1,285 @@
+/*
+ * PaleoLatitudeBenchmark.cpp
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: Sebastiaan J. van Schaik
+ */
+
+#include "PaleoLatitudeBenchmark.h"
+#include "../src/paleo_latitude/PLDataset.h"
+#include "../src/paleo_latitude/PLParameters.h"
+#include "../src/paleo_latitude/PLPlates.h"
+#include "../src/paleo_latitude/PLPolarWanderPaths.h"
+#include "../src/util/CSVFileData.h"
+#include "../src/util/Exception.h"
+#include "../src/util/Logger.h"
+
+#include <cmath>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <benchmark/benchmark.h>
+
+using namespace std;
+using namespace paleo_latitude;
+
+const unsigned int PaleoLatitudeBenchmark::NUM_SITES = 10000;
+const unsigned int PaleoLatitudeBenchmark::RANDOM_SEED = 20261017;
+
+// Building the raster takes a while, but the benchmarks only use it to look up plates
+static const double RASTER_RESOLUTION = 0.1;
+
+const PLDataset* PaleoLatitudeBenchmark::getDataset(bool with_raster) {
+	static unique_ptr<const PLDataset> datasets[2];
+
+	if (!datasets[with_raster]){
+		PLParameters params;
+		if (with_raster) params.plates_raster_resolution = RASTER_RESOLUTION;
+		datasets[with_raster].reset(PLDataset::readFromFiles(&params));
+	}
+
+	return datasets[with_raster].get();
+}
+
+const vector<Coordinate>& PaleoLatitudeBenchmark::getGlobalSites() {
+	static vector<Coordinate> sites;
+
+	if (sites.empty()){
+		mt19937 generator(RANDOM_SEED);
+		uniform_real_distribution<double> z(-1, 1);
+		uniform_real_distribution<double> lon(-180, 180);
+
+		// Uniform over the sphere, rather than over latitude
+		for (unsigned int i = 0; i < NUM_SITES; i++){
+			sites.push_back(Coordinate(asin(z(generator)) * 180 / M_PI, lon(generator)));
+		}
+	}
+
+	return sites;
+}
+
+const vector<Coordinate>& PaleoLatitudeBenchmark::getBoundarySites() {
+	static vector<Coordinate> sites;
+
+	if (sites.empty()){
+		vector<const Coordinate*> vertices;
+		for (const PLPlate* plate : getDataset(false)->getPlates()->getPlates()){
+			for (const Coordinate& vertex : *plate->getCoordinates()) vertices.push_back(&vertex);
+		}
+
+		mt19937 generator(RANDOM_SEED);
+		uniform_int_distribution<size_t> vertex(0, vertices.size() - 1);
+		uniform_real_distribution<double> offset(-0.01, 0.01);
+
+		for (unsigned int i = 0; i < NUM_SITES; i++){
+			const Coordinate& v = *vertices[vertex(generator)];
+			const double lat = max(-90.0, min(90.0, v.latitude + offset(generator)));
+			const double lon = max(-180.0, min(180.0, v.longitude + offset(generator)));
+			sites.push_back(Coordinate(lat, lon));
+		}
+	}
+
+	return sites;
+}
+
+PaleoLatitude::PaleoLatitudeEntry PaleoLatitudeBenchmark::calculatePaleolatitudeRange(const PaleoLatitude& pl, const Vector3& site, unsigned int age_myr, const PLEulerPolesReconstructions::EPEntry* euler_entry, const PLEulerPolesReconstructions::Paleopole& paleopole) {
+	return pl._calculatePaleolatitudeRange(site, age_myr, euler_entry, paleopole);
+}
+
+namespace {
+
+bool file_exists(const string& filename){
+	return ifstream(filename).good();
+}
+
+};
+
+static void BM_ReadPlates(benchmark::State& state, const string& filename){
+	if (!file_exists(filename)){
+		state.SkipWithError(("Input file not available: " + filename).c_str());
+		return;
+	}
+
+	for (auto _ : state){
+		unique_ptr<PLPlates> plates(PLPlates::readFromFile(filename));
+		benchmark::DoNotOptimize(plates.get());
+	}
+}
+BENCHMARK_CAPTURE(BM_ReadPlates, gpml, string("data/plates.gpml"))->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_ReadPlates, kml, string("data/plates.kml"))->Unit(benchmark::kMillisecond);
+
+namespace {
+
+template<class EntryType> void parse_csv(benchmark::State& state, const string& filename){
+	size_t num_entries = 0;
+
+	for (auto _ : state){
+		CSVFileData<EntryType> csv_data;
+		csv_data.parseFile(filename);
+		num_entries = csv_data.getEntries().size();
+		benchmark::DoNotOptimize(csv_data.getEntries().data());
+	}
+
+	state.SetItemsProcessed(state.iterations() * num_entries);
+}
+
+};
+
+static void BM_ParseEulerCSV(benchmark::State& state, const string& filename){
+	parse_csv<PLEulerPolesReconstructions::EPEntry>(state, filename);
+}
+BENCHMARK_CAPTURE(BM_ParseEulerCSV, torsvik, string("data/euler-torsvik-2012.csv"))->Unit(benchmark::kMicrosecond);
+BENCHMARK_CAPTURE(BM_ParseEulerCSV, besse_courtillot, string("data/euler-besse-courtillot-2002.csv"))->Unit(benchmark::kMicrosecond);
+BENCHMARK_CAPTURE(BM_ParseEulerCSV, kent_irving, string("data/euler-kent-irving-2010.csv"))->Unit(benchmark::kMicrosecond);
+
+static void BM_ParseAPWPCSV(benchmark::State& state, const string& filename){
+	parse_csv<PLPolarWanderPaths::PWPEntry>(state, filename);
+}
+BENCHMARK_CAPTURE(BM_ParseAPWPCSV, torsvik, string("data/apwp-torsvik-2012-vandervoo-2015.csv"))->Unit(benchmark::kMicrosecond);
+BENCHMARK_CAPTURE(BM_ParseAPWPCSV, besse_courtillot, string("data/apwp-besse-courtillot-2002-vandervoo-2015.csv"))->Unit(benchmark::kMicrosecond);
+BENCHMARK_CAPTURE(BM_ParseAPWPCSV, kent_irving, string("data/apwp-kent-irving-2010-vandervoo-2015.csv"))->Unit(benchmark::kMicrosecond);
+
+/**
+ * Looks up the plates of a fixed set of sites in turn, without (raster:0) or with (raster:1)
+ * plate raster. Sites that are not located on a (single) plate are counted as not_found.
+ */
+static void BM_FindPlate(benchmark::State& state, bool boundary_sites){
+	const PLPlates* plates = PaleoLatitudeBenchmark::getDataset(state.range(0) != 0)->getPlates();
+	const vector<Coordinate>& sites = boundary_sites ? PaleoLatitudeBenchmark::getBoundarySites() : PaleoLatitudeBenchmark::getGlobalSites();
+
+	size_t site_index = 0;
+	size_t not_found = 0;
+
+	for (auto _ : state){
+		try {
+			benchmark::DoNotOptimize(plates->findPlate(sites[site_index]));
+		} catch (const Exception&){
+			not_found++;
+		}
+
+		if (++site_index == sites.size()) site_index = 0;
+	}
+
+	state.SetItemsProcessed(state.iterations());
+	state.counters["not_found"] = benchmark::Counter(not_found, benchmark::Counter::kAvgIterations);
+}
+BENCHMARK_CAPTURE(BM_FindPlate, global, false)->ArgName("raster")->Arg(0)->Arg(1);
+BENCHMARK_CAPTURE(BM_FindPlate, boundary, true)->ArgName("raster")->Arg(0)->Arg(1);
+
+static void BM_CalculatePaleolatitudeRange(benchmark::State& state){
+	const unsigned int age_myr = 50;
+	const PLDataset* dataset = PaleoLatitudeBenchmark::getDataset(false);
+
+	PLParameters params;
+	params.site_latitude = 51.5;
+	params.site_longitude = -0.1;
+	params.age = age_myr;
+	params.age_pm = 0;
+
+	PaleoLatitude pl(&params, dataset);
+	if (!pl.compute()){
+		state.SkipWithError("Could not compute paleolatitude of benchmark site");
+		return;
+	}
+
+	const PLEulerPolesReconstructions* euler = dataset->getEulerPolesReconstructions();
+	const PLEulerPolesReconstructions::EPEntry* euler_entry = euler->getEntries(pl.getPlate(), age_myr)[0];
+	const PLEulerPolesReconstructions::Paleopole* paleopole = euler->getPaleopole(euler_entry);
+	if (paleopole == NULL){
+		state.SkipWithError("No reference pole available for benchmark site");
+		return;
+	}
+
+	const Vector3 site = Vector3::fromLatLon(params.site_latitude, params.site_longitude);
+	for (auto _ : state){
+		benchmark::DoNotOptimize(PaleoLatitudeBenchmark::calculatePaleolatitudeRange(pl, site, age_myr, euler_entry, *paleopole));
+	}
+
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_CalculatePaleolatitudeRange);
+
+/**
+ * Complete computation for a single site (plate lookup, Euler rotations, interpolation), using
+ * the same input data for every iteration
+ */
+static void BM_Compute(benchmark::State& state, const PLParameters& ages){
+	PLParameters params = ages;
+	params.site_latitude = 51.5;
+	params.site_longitude = -0.1;
+
+	for (auto _ : state){
+		PaleoLatitude pl(&params, PaleoLatitudeBenchmark::getDataset(false));
+		if (!pl.compute()){
+			state.SkipWithError("Could not compute paleolatitude of benchmark site");
+			break;
+		}
+		benchmark::DoNotOptimize(pl.getRelevantPaleolatitudeEntries());
+	}
+}
+
+namespace {
+
+PLParameters single_age(){
+	PLParameters params;
+	params.age = 55;
+	params.age_pm = 5;
+	return params;
+}
+
+PLParameters age_range(){
+	PLParameters params;
+	params.age_min = 40;
+	params.age_max = 120;
+	return params;
+}
+
+PLParameters all_ages(){
+	PLParameters params;
+	params.all_ages = true;
+	return params;
+}
+
+};
+
+BENCHMARK_CAPTURE(BM_Compute, single_age, single_age())->Unit(benchmark::kMicrosecond);
+BENCHMARK_CAPTURE(BM_Compute, age_range, age_range())->Unit(benchmark::kMicrosecond);
+BENCHMARK_CAPTURE(BM_Compute, all_ages, all_ages())->Unit(benchmark::kMicrosecond);
+
+/**
+ * Writes the result of a single site in the format of --machine-readable (i.e., CSV and KML)
+ */
+static void BM_WriteMachineReadable(benchmark::State& state){
+	PLParameters params = single_age();
+	params.site_latitude = 51.5;
+	params.site_longitude = -0.1;
+
+	PaleoLatitude pl(&params, PaleoLatitudeBenchmark::getDataset(false));
+	if (!pl.compute()){
+		state.SkipWithError("Could not compute paleolatitude of benchmark site");
+		return;
+	}
+
+	size_t num_bytes = 0;
+	for (auto _ : state){
+		stringstream output;
+		pl.writeMachineReadable(output, state.range(0) != 0);
+		num_bytes += output.tellp();
+	}
+
+	state.SetBytesProcessed(num_bytes);
+}
+BENCHMARK(BM_WriteMachineReadable)->ArgName("kml")->Arg(0)->Arg(1)->Unit(benchmark::kMicrosecond);
+
+int main(int argc, char** argv){
+	// Reading the input data and computing paleolatitudes would log every step
+	Logger::info.disable();
+
+	benchmark::Initialize(&argc, argv);
+	if (benchmark::ReportUnrecognizedArguments(argc, argv)) return 1;
+
+	benchmark::RunSpecifiedBenchmarks();
+	benchmark::Shutdown();
+	return 0;
+}
@@ -0,0 +1,56 @@
+/*
+ * PaleoLatitudeBenchmark.h
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: Sebastiaan J. van Schaik
+ */
+
+#ifndef PALEOLATITUDEBENCHMARK_H_
+#define PALEOLATITUDEBENCHMARK_H_
+
+#include <string>
+#include <vector>
+#include "../src/paleo_latitude/PaleoLatitude.h"
+#include "../src/paleo_latitude/PLEulerPolesReconstructions.h"
+#include "../src/paleo_latitude/PLPlate.h"
+
+using namespace std;
+
+namespace paleo_latitude {
+
+class PLDataset;
+class PLParameters;
+
+/**
+ * Shared input data of the benchmarks, which is read once (using the default input files)
+ */
+class PaleoLatitudeBenchmark {
+public:
+	/**
+	 * Returns the dataset of the default input files, with or without plate raster
+	 */
+	static const PLDataset* getDataset(bool with_raster);
+
+	/**
+	 * Pseudo-random sites, uniformly distributed over the globe (always the same sites)
+	 */
+	static const vector<Coordinate>& getGlobalSites();
+
+	/**
+	 * Sites within 0.01 degrees of the vertices of plate polygons: the worst case for plate
+	 * lookups (always the same sites)
+	 */
+	static const vector<Coordinate>& getBoundarySites();
+
+	/**
+	 * Calls the (private) PaleoLatitude::_calculatePaleolatitudeRange()
+	 */
+	static PaleoLatitude::PaleoLatitudeEntry calculatePaleolatitudeRange(const PaleoLatitude& pl, const Vector3& site, unsigned int age_myr, const PLEulerPolesReconstructions::EPEntry* euler_entry, const PLEulerPolesReconstructions::Paleopole& paleopole);
+
+	const static unsigned int NUM_SITES;
+	const static unsigned int RANDOM_SEED;
+};
+
+};
+
+#endif /* PALEOLATITUDEBENCHMARK_H_ */
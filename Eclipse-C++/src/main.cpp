@@ -18,15 +18,24 @@
 
 #include "paleo_latitude/PaleoLatitude.h"
 #include "paleo_latitude/PLParameters.h"
+#include "paleo_latitude/PLDataset.h"
+#include "paleo_latitude/PLPlates.h"
+#include "paleo_latitude/PLSitesBatch.h"
+#include "paleo_latitude/PLServer.h"
 
+#include <cstdlib>
 #include <iostream>
+#include <fstream>
 #include <string>
+#include <vector>
+#include <boost/algorithm/string.hpp>
 #include <boost/program_options.hpp>
 
 #include "util/Exception.h"
 #include "debugging-macros.h"
 #include "gtest-includes.h"
 #include "util/Logger.h"
+#include "util/Stats.h"
 
 using namespace std;
 using namespace paleo_latitude;
@@ -38,6 +47,10 @@ void print_usage(bpo::options_description& cmdline_options_spec){
 	cout << cmdline_options_spec << endl;
 }
 
+void print_stats(){
+	Stats::writeJSON(cerr);
+}
+
 int main(int argc, char* argv[]) {
 	// Parameters to Paleolatitude model implementation
 	PLParameters* pl_params = new PLParameters();
@@ -60,11 +73,22 @@ int main(int argc, char* argv[]) {
 		("input-apwp-csv", bpo::value<string>(&pl_params->input_apwp_csv)->default_value(pl_params->input_apwp_csv), "path to apparent polar wander paths specification of plates (in CSV format)")
 		("input-euler-rotation-csv", bpo::value<string>(&pl_params->input_euler_rotation_csv)->default_value(pl_params->input_euler_rotation_csv), "path to specification of Euler rotation parameters of polar wander path (in CSV format)")
 		("input-plates-file", bpo::value<string>(&pl_params->input_plates_file)->default_value(pl_params->input_plates_file), "path to specification of tectonic plates locations (GPML or KML format)")
+		("input-dataset-bundle", bpo::value<string>(&pl_params->input_dataset_bundle), "path to a dataset bundle (see --compile-dataset), which is read instead of the input CSV and plates files")
+		("compile-dataset", bpo::value<string>(), "reads the input files (and builds the plate raster if --plates-raster-resolution is given), writes all data to the specified dataset bundle file, and exits")
+		("plates-raster-resolution", bpo::value<double>(&pl_params->plates_raster_resolution), "enables a precomputed raster of plates with the given cell size (in degrees, e.g. 0.05) to speed up plate lookups")
+		("plates-raster-file", bpo::value<string>(&pl_params->plates_raster_file), "file to read the plate raster from, or to write it to if it does not exist yet (used with --plates-raster-resolution)")
+		("input-sites-csv", bpo::value<string>(), "computes the paleolatitude of all sites in the specified CSV file (columns: id, latitude, longitude, and either age or min-age and max-age), and writes one line per site to standard output (or --csv-output-file)")
+		("threads", bpo::value<unsigned int>()->default_value(0), "number of threads used to process the sites of --input-sites-csv or --stream, or the requests of --serve (0 = one per CPU core)")
+		("stream", "reads one request per line from standard input (a site as with --input-sites-csv, or a JSON object such as {\"id\":\"s1\",\"site-lat\":52.5,\"site-lon\":5.1,\"age\":50}), and writes one result line per request to standard output (one line per age for CSV requests with --all-ages)")
+		("stream-flush-interval", bpo::value<size_t>()->default_value(1), "maximum number of --stream requests that are processed together before the results are written and flushed (requests are only combined when they are already waiting on standard input)")
+		("serve", bpo::value<string>(), "loads the data once, and answers requests on the Unix domain socket with the specified path (one request per line, e.g. 'site-lat=52.5 site-lon=5.1 age=50 age-pm=5 model=default'; responses are formatted as with --machine-readable, followed by a line '#END')")
+		("serve-model", bpo::value<vector<string> >()->composing(), "adds a model to --serve, as NAME=BUNDLE (see --compile-dataset) or NAME=APWP_CSV,EULER_CSV (using --input-plates-file); the input files specified by the other options are served as model 'default'")
 		("csv-output-file", bpo::value<string>(), "enables detailed CSV output to specified file")
 		("kml-output-file", bpo::value<string>(), "enables KML output of tectonic plates and site to specified file")
 		("all-ages", "enable calculation of paleolatitude for all available ages (works best with --csv-output-file or --machine-readable)")
 		("machine-readable", "enable machine readable output on standard output (includes CSV and KML)")
 		("skip-about", "skips the header containing version and author information")
+		("stats", "records the number of calls to and the time spent in every stage of the computation (reading data, plate lookups, rotations, output, ...), and prints a summary in JSON format to standard error on exit")
 		("log-level", bpo::value<unsigned int>()->default_value(2), "sets the log level (0 = only errors, ..., 4 = debug. Default: 2)");
 
 #ifndef __OPTIMIZE__
@@ -99,6 +123,11 @@ int main(int argc, char* argv[]) {
 		__IF_DEBUG(if(disable_ll == 3) Logger::debug.disable();)
 	}
 
+	if (cmdline_params_values.count("stats") > 0){
+		Stats::enable();
+		atexit(print_stats);
+	}
+
 #ifndef __OPTIMIZE__
 	// Run unit tests if requested (only available in debug builds - Release builds do not depend on Google Test)
 	if (cmdline_params_values.count("run-tests")){
@@ -116,7 +145,9 @@ int main(int argc, char* argv[]) {
 		exit(0);
 	}
 
-	if (cmdline_params_values.count("skip-about") == 0) PaleoLatitude::printAbout();
+	// Standard output of --stream, and of a batch without an output file, only contains results
+	const bool results_on_stdout = cmdline_params_values.count("stream") > 0 || (cmdline_params_values.count("input-sites-csv") > 0 && cmdline_params_values.count("csv-output-file") == 0);
+	if (cmdline_params_values.count("skip-about") == 0 && !results_on_stdout) PaleoLatitude::printAbout();
 
 	if (cmdline_params_values.count("help") > 0){
 		// Print usage and exit
@@ -126,6 +157,154 @@ int main(int argc, char* argv[]) {
 
 	if (cmdline_params_values.count("about") > 0) exit(0);
 
+	// A raster resolution of 0 (the default) disables the raster
+	if (pl_params->plates_raster_resolution != 0){
+		try {
+			PLPlates::validateRasterResolution(pl_params->plates_raster_resolution);
+		} catch (exception& ex){
+			cerr << ex.what() << endl;
+			exit(1);
+		}
+	}
+
+	if (cmdline_params_values.count("compile-dataset") > 0){
+		// Read and preprocess the input data, and save everything in a single binary file that
+		// can be read without any parsing (--input-dataset-bundle)
+		try {
+			const PLDataset* dataset = PLDataset::readFromFiles(pl_params);
+			dataset->writeBundle(cmdline_params_values["compile-dataset"].as<string>());
+			delete dataset;
+		} catch (exception& ex){
+			cerr << "Error compiling dataset bundle: " << ex.what() << endl;
+			exit(1);
+		}
+
+		delete pl_params;
+		return 0;
+	}
+
+	if (cmdline_params_values.count("serve") > 0){
+		// Server mode: requests would drown in per-site information, so only warnings and
+		// errors are logged after the data has been read
+		try {
+			PLServer server(*pl_params, cmdline_params_values["threads"].as<unsigned int>());
+			server.addModel("default", PLDataset::readFromFiles(pl_params));
+
+			if (cmdline_params_values.count("serve-model") > 0){
+				for (const string& model : cmdline_params_values["serve-model"].as<vector<string> >()){
+					const size_t separator = model.find('=');
+					if (separator == string::npos || separator == 0){
+						cerr << "Invalid model specification '" << model << "' (expecting NAME=BUNDLE or NAME=APWP_CSV,EULER_CSV)" << endl;
+						exit(1);
+					}
+
+					PLParameters model_params = *pl_params;
+					vector<string> files;
+					boost::split(files, model.substr(separator + 1), boost::is_any_of(","));
+					if (files.size() == 1){
+						model_params.input_dataset_bundle = files[0];
+					} else if (files.size() == 2){
+						model_params.input_dataset_bundle = "";
+						model_params.input_apwp_csv = files[0];
+						model_params.input_euler_rotation_csv = files[1];
+					} else {
+						cerr << "Invalid model specification '" << model << "' (expecting NAME=BUNDLE or NAME=APWP_CSV,EULER_CSV)" << endl;
+						exit(1);
+					}
+
+					server.addModel(model.substr(0, separator), PLDataset::readFromFiles(&model_params));
+				}
+			}
+
+			Logger::logInfo("Serving requests on " + cmdline_params_values["serve"].as<string>() + " (stop the server using Ctrl-C)");
+			Logger::info.disable();
+			__IF_DEBUG(Logger::debug.disable();)
+
+			server.serve(cmdline_params_values["serve"].as<string>());
+		} catch (exception& ex){
+			cerr << "Error running server: " << ex.what() << endl;
+			exit(1);
+		}
+
+		delete pl_params;
+		return 0;
+	}
+
+	if (cmdline_params_values.count("stream") > 0){
+		// Streaming mode: standard output only contains results, so warnings are logged on
+		// standard error (like errors)
+		Logger::warning.setTarget(cerr);
+		Logger::info.disable();
+		__IF_DEBUG(Logger::debug.disable();)
+
+		// Allows checking whether more requests are waiting on standard input
+		ios::sync_with_stdio(false);
+
+		try {
+			const PLDataset* dataset = PLDataset::readFromFiles(pl_params);
+			const PLSitesBatch batch(dataset, *pl_params, cmdline_params_values["threads"].as<unsigned int>());
+
+			const unsigned int num_failed = batch.stream(cin, cout, cmdline_params_values["stream-flush-interval"].as<size_t>());
+			if (num_failed > 0) cerr << num_failed << " request(s) could not be processed - see the error codes in the output" << endl;
+			delete dataset;
+		} catch (exception& ex){
+			cerr << "Unexpected error processing requests: " << ex.what() << endl;
+			exit(1);
+		}
+
+		delete pl_params;
+		return 0;
+	}
+
+	if (cmdline_params_values.count("input-sites-csv") > 0){
+		// Batch mode: read the data once, and compute the paleolatitude of all sites in the
+		// input file. Per-site information would drown the results, so only warnings and
+		// errors are logged. Without an output file, standard output only contains results,
+		// so warnings are logged on standard error.
+		Logger::info.disable();
+		__IF_DEBUG(Logger::debug.disable();)
+		if (cmdline_params_values.count("csv-output-file") == 0) Logger::warning.setTarget(cerr);
+
+		if (cmdline_params_values.count("kml-output-file") > 0){
+			cerr << "KML output is not available when processing multiple sites (--input-sites-csv)" << endl;
+			exit(1);
+		}
+
+		try {
+			const PLDataset* dataset = PLDataset::readFromFiles(pl_params);
+			const PLSitesBatch batch(dataset, *pl_params, cmdline_params_values["threads"].as<unsigned int>());
+			const string input_file = cmdline_params_values["input-sites-csv"].as<string>();
+
+			unsigned int num_failed = 0;
+			if (cmdline_params_values.count("csv-output-file") > 0){
+				const string output_file = cmdline_params_values["csv-output-file"].as<string>();
+				ofstream out(output_file);
+				if (!out.is_open()){
+					cerr << "Error opening CSV output file '" << output_file << "'" << endl;
+					exit(1);
+				}
+
+				num_failed = batch.process(input_file, out);
+				out.close();
+				if (!out.good()){
+					cerr << "Error writing CSV output file '" << output_file << "'" << endl;
+					exit(1);
+				}
+			} else {
+				num_failed = batch.process(input_file, cout);
+			}
+
+			if (num_failed > 0) cerr << num_failed << " site(s) could not be processed - see the error codes in the output" << endl;
+			delete dataset;
+		} catch (exception& ex){
+			cerr << "Unexpected error processing sites: " << ex.what() << endl;
+			exit(1);
+		}
+
+		delete pl_params;
+		return 0;
+	}
+
 	// All logic related to the actual model parameters is located in PLParameters
 	string validate_error_msg;
 	if (!pl_params->validate(validate_error_msg)){
@@ -179,35 +358,13 @@ int main(int argc, char* argv[]) {
 		}
 	} else if (cmdline_params_values.count("machine-readable") > 0){
 		// Output should be machine readable. Write to stdout:
-
-		// #latitude:52.50
-		// #longitude:-35.5
-		// #plate_name:Eurasia
-		// #plate_id:201
-		// #CSV
-		// .....
-		//
-		// #KML
-		// .....
-
-		cout << "#latitude:" << pl_params->site_latitude << endl;
-		cout << "#longitude:" << pl_params->site_longitude << endl;
-
-		cout << "#plate_name:" << pl->getPlate()->getName() << endl;
-		cout << "#plate_id:" << pl->getPlate()->getId() << endl;
-
-		cout << "#CSV" << endl;
-		pl->writeCSV(cout);
-
-		cout << endl;
-		cout << "#KML" << endl;
-		pl->writeKML(cout);
+		pl->writeMachineReadable(cout);
 	}
 
 	if (cmdline_params_values.count("csv-output-file") > 0){
 		// Export CSV
 		try{
-			pl->writeCSV(cmdline_params_values["output-csv"].as<string>());
+			pl->writeCSV(cmdline_params_values["csv-output-file"].as<string>());
 		} catch (exception& ex){
 			cerr << "Error saving CSV file: " << ex.what() << endl;
 			exit(1);
@@ -217,7 +374,7 @@ int main(int argc, char* argv[]) {
 	if (cmdline_params_values.count("kml-output-file") > 0){
 		// Export KML
 		try{
-			pl->writeKML(cmdline_params_values["output-kml"].as<string>());
+			pl->writeKML(cmdline_params_values["kml-output-file"].as<string>());
 		} catch (exception& ex){
 			cerr << "Error saving KML file: " << ex.what() << endl;
 			exit(1);
@@ -0,0 +1,253 @@
+/*
+ * PLCrossingKernel.cpp
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: Sebastiaan J. van Schaik
+ */
+
+#include "PLCrossingKernel.h"
+
+#include <cassert>
+#include "../util/Exception.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define PL_CROSSING_KERNEL_X86
+#include <immintrin.h>
+#endif
+
+using namespace paleo_latitude;
+
+namespace {
+
+/**
+ * Whether the point (x,y,z) is on the positive side of the great circle with the given normal.
+ * Note that the order of operations matters: the vectorised kernels compute exactly the same
+ * expression. Builds that allow the compiler to fuse multiplications and additions (e.g. using
+ * -mfma) may break that equivalence.
+ */
+inline bool side(const Vector3& normal, double x, double y, double z){
+	return normal.x * x + normal.y * y + normal.z * z > 0;
+}
+
+/**
+ * Decides whether edge i is crossed by the arc, given that its end points are located on
+ * different sides of the great circle through the arc. The site and the reference point
+ * must be on different sides of the edge's great circle, and both great circles must
+ * intersect on the arc (rather than on the opposite side of the sphere).
+ */
+inline bool edgeCrossed(const PLCrossingKernel::Polygon& polygon, size_t i, const Vector3& site, const uint8_t* reference_sides, bool side_next){
+	const bool site_side = polygon.normal_x[i] * site.x + polygon.normal_y[i] * site.y + polygon.normal_z[i] * site.z > 0;
+	return site_side != (reference_sides[i] != 0) && site_side == side_next;
+}
+
+/**
+ * Processes the vertices from index first_vertex onwards, one at a time
+ */
+inline unsigned int countCrossingsTail(const PLCrossingKernel::Polygon& polygon, size_t first_vertex, bool side_prev, const Vector3& site, const Vector3& arc_normal, const uint8_t* reference_sides){
+	unsigned int crossings = 0;
+	for (size_t v = first_vertex; v < polygon.x.size(); v++){
+		const bool side_next = side(arc_normal, polygon.x[v], polygon.y[v], polygon.z[v]);
+		if (side_prev != side_next && edgeCrossed(polygon, v - 1, site, reference_sides, side_next)) crossings++;
+		side_prev = side_next;
+	}
+	return crossings;
+}
+
+/**
+ * Evaluates the edges ending at vertices first_vertex ... first_vertex+width-1, given a bit mask
+ * of the sides of these vertices and the side of the vertex preceding them
+ */
+inline unsigned int countCrossingsInBlock(const PLCrossingKernel::Polygon& polygon, size_t first_vertex, unsigned int width, unsigned int sides, bool side_prev, const Vector3& site, const uint8_t* reference_sides){
+	unsigned int crossings = 0;
+	unsigned int changes = (sides ^ ((sides << 1) | (side_prev ? 1 : 0))) & ((1u << width) - 1);
+
+	while (changes != 0){
+		const unsigned int j = __builtin_ctz(changes);
+		if (edgeCrossed(polygon, first_vertex + j - 1, site, reference_sides, (sides >> j) & 1)) crossings++;
+		changes &= changes - 1;
+	}
+	return crossings;
+}
+
+};
+
+PLCrossingKernel::Polygon PLCrossingKernel::Polygon::fromVertices(const vector<Vector3>& vertices) {
+	Polygon polygon;
+	if (vertices.empty()) return polygon;
+
+	vector<Vector3> closed_vertices = vertices;
+	if (vertices.front().cross(vertices.back()).norm() > 1e-15 || vertices.front().dot(vertices.back()) < 0){
+		closed_vertices.push_back(vertices.front());
+	}
+
+	for (size_t i = 0; i < closed_vertices.size(); i++){
+		polygon.x.push_back(closed_vertices[i].x);
+		polygon.y.push_back(closed_vertices[i].y);
+		polygon.z.push_back(closed_vertices[i].z);
+
+		if (i + 1 < closed_vertices.size()){
+			const Vector3 normal = closed_vertices[i].cross(closed_vertices[i + 1]);
+			polygon.normal_x.push_back(normal.x);
+			polygon.normal_y.push_back(normal.y);
+			polygon.normal_z.push_back(normal.z);
+		}
+	}
+
+	return polygon;
+}
+
+size_t PLCrossingKernel::Polygon::numEdges() const {
+	return normal_x.size();
+}
+
+Vector3 PLCrossingKernel::Polygon::vertex(size_t i) const {
+	return Vector3(x[i], y[i], z[i]);
+}
+
+Vector3 PLCrossingKernel::Polygon::edgeNormal(size_t i) const {
+	return Vector3(normal_x[i], normal_y[i], normal_z[i]);
+}
+
+vector<uint8_t> PLCrossingKernel::Polygon::edgeSides(const Vector3& point) const {
+	vector<uint8_t> sides(numEdges());
+	for (size_t i = 0; i < numEdges(); i++){
+		sides[i] = (normal_x[i] * point.x + normal_y[i] * point.y + normal_z[i] * point.z > 0) ? 1 : 0;
+	}
+	return sides;
+}
+
+unsigned int PLCrossingKernel::countCrossings(const Polygon& polygon, const Vector3& site, const Vector3& reference_point, const vector<uint8_t>& reference_sides) {
+	static const KernelFunction kernel = _getKernel(bestImplementation());
+
+	assert(reference_sides.size() == polygon.numEdges());
+	if (polygon.numEdges() == 0) return 0;
+
+	return kernel(polygon, site, site.cross(reference_point), reference_sides.data());
+}
+
+unsigned int PLCrossingKernel::countCrossings(Implementation implementation, const Polygon& polygon, const Vector3& site, const Vector3& reference_point, const vector<uint8_t>& reference_sides) {
+	assert(reference_sides.size() == polygon.numEdges());
+	if (polygon.numEdges() == 0) return 0;
+
+	return _getKernel(implementation)(polygon, site, site.cross(reference_point), reference_sides.data());
+}
+
+bool PLCrossingKernel::isAvailable(Implementation implementation) {
+	switch (implementation){
+	case SCALAR:
+		return true;
+#ifdef PL_CROSSING_KERNEL_X86
+	case SSE2:
+		return __builtin_cpu_supports("sse2");
+	case AVX2:
+		return __builtin_cpu_supports("avx2");
+#endif
+	default:
+		return false;
+	}
+}
+
+PLCrossingKernel::Implementation PLCrossingKernel::bestImplementation() {
+	if (isAvailable(AVX2)) return AVX2;
+	if (isAvailable(SSE2)) return SSE2;
+	return SCALAR;
+}
+
+string PLCrossingKernel::getImplementationName(Implementation implementation) {
+	switch (implementation){
+	case SCALAR: return "scalar";
+	case SSE2: return "SSE2";
+	case AVX2: return "AVX2";
+	}
+	return "unknown";
+}
+
+PLCrossingKernel::KernelFunction PLCrossingKernel::_getKernel(Implementation implementation) {
+	if (!isAvailable(implementation)){
+		Exception ex;
+		ex << "Point-in-polygon kernel '" << getImplementationName(implementation) << "' is not supported on this system";
+		throw ex;
+	}
+
+	switch (implementation){
+	case SSE2: return &PLCrossingKernel::_countCrossingsSSE2;
+	case AVX2: return &PLCrossingKernel::_countCrossingsAVX2;
+	default: return &PLCrossingKernel::_countCrossingsScalar;
+	}
+}
+
+unsigned int PLCrossingKernel::_countCrossingsScalar(const Polygon& polygon, const Vector3& site, const Vector3& arc_normal, const uint8_t* reference_sides) {
+	const bool side_first = side(arc_normal, polygon.x[0], polygon.y[0], polygon.z[0]);
+	return countCrossingsTail(polygon, 1, side_first, site, arc_normal, reference_sides);
+}
+
+#ifdef PL_CROSSING_KERNEL_X86
+
+__attribute__((target("sse2")))
+unsigned int PLCrossingKernel::_countCrossingsSSE2(const Polygon& polygon, const Vector3& site, const Vector3& arc_normal, const uint8_t* reference_sides) {
+	const size_t num_vertices = polygon.x.size();
+	const __m128d ax = _mm_set1_pd(arc_normal.x);
+	const __m128d ay = _mm_set1_pd(arc_normal.y);
+	const __m128d az = _mm_set1_pd(arc_normal.z);
+	const __m128d zero = _mm_setzero_pd();
+
+	unsigned int crossings = 0;
+	bool side_prev = side(arc_normal, polygon.x[0], polygon.y[0], polygon.z[0]);
+
+	size_t v = 1;
+	for (; v + 2 <= num_vertices; v += 2){
+		const __m128d dot = _mm_add_pd(_mm_add_pd(
+				_mm_mul_pd(ax, _mm_loadu_pd(&polygon.x[v])),
+				_mm_mul_pd(ay, _mm_loadu_pd(&polygon.y[v]))),
+				_mm_mul_pd(az, _mm_loadu_pd(&polygon.z[v])));
+		const unsigned int sides = _mm_movemask_pd(_mm_cmpgt_pd(dot, zero));
+
+		// Vast majority of edges are not crossed by the great circle through the arc
+		if (sides != (side_prev ? 0x3u : 0x0u)){
+			crossings += countCrossingsInBlock(polygon, v, 2, sides, side_prev, site, reference_sides);
+		}
+		side_prev = (sides >> 1) & 1;
+	}
+
+	return crossings + countCrossingsTail(polygon, v, side_prev, site, arc_normal, reference_sides);
+}
+
+__attribute__((target("avx2")))
+unsigned int PLCrossingKernel::_countCrossingsAVX2(const Polygon& polygon, const Vector3& site, const Vector3& arc_normal, const uint8_t* reference_sides) {
+	const size_t num_vertices = polygon.x.size();
+	const __m256d ax = _mm256_set1_pd(arc_normal.x);
+	const __m256d ay = _mm256_set1_pd(arc_normal.y);
+	const __m256d az = _mm256_set1_pd(arc_normal.z);
+	const __m256d zero = _mm256_setzero_pd();
+
+	unsigned int crossings = 0;
+	bool side_prev = side(arc_normal, polygon.x[0], polygon.y[0], polygon.z[0]);
+
+	size_t v = 1;
+	for (; v + 4 <= num_vertices; v += 4){
+		const __m256d dot = _mm256_add_pd(_mm256_add_pd(
+				_mm256_mul_pd(ax, _mm256_loadu_pd(&polygon.x[v])),
+				_mm256_mul_pd(ay, _mm256_loadu_pd(&polygon.y[v]))),
+				_mm256_mul_pd(az, _mm256_loadu_pd(&polygon.z[v])));
+		const unsigned int sides = _mm256_movemask_pd(_mm256_cmp_pd(dot, zero, _CMP_GT_OQ));
+
+		if (sides != (side_prev ? 0xFu : 0x0u)){
+			crossings += countCrossingsInBlock(polygon, v, 4, sides, side_prev, site, reference_sides);
+		}
+		side_prev = (sides >> 3) & 1;
+	}
+
+	return crossings + countCrossingsTail(polygon, v, side_prev, site, arc_normal, reference_sides);
+}
+
+#else
+
+unsigned int PLCrossingKernel::_countCrossingsSSE2(const Polygon& polygon, const Vector3& site, const Vector3& arc_normal, const uint8_t* reference_sides) {
+	return _countCrossingsScalar(polygon, site, arc_normal, reference_sides);
+}
+
+unsigned int PLCrossingKernel::_countCrossingsAVX2(const Polygon& polygon, const Vector3& site, const Vector3& arc_normal, const uint8_t* reference_sides) {
+	return _countCrossingsScalar(polygon, site, arc_normal, reference_sides);
+}
+
+#endif
@@ -0,0 +1,82 @@
+/*
+ * PLCrossingKernel.h
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: Sebastiaan J. van Schaik
+ */
+
+#ifndef PLCROSSINGKERNEL_H_
+#define PLCROSSINGKERNEL_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "../util/Vector3.h"
+
+using namespace std;
+
+namespace paleo_latitude {
+
+/**
+ * Counts the number of polygon edges crossed by a great circle arc, which is the core of the
+ * point-in-polygon test of PLPlate. Vectorised implementations (SSE2 and AVX2) are selected at
+ * runtime based on the capabilities of the CPU. All implementations evaluate the same floating
+ * point expressions in the same order, and hence yield identical results.
+ */
+class PLCrossingKernel {
+public:
+	enum Implementation { SCALAR, SSE2, AVX2 };
+
+	/**
+	 * Closed polygon on the unit sphere in structure-of-arrays layout: vertex i and i+1 are the
+	 * end points of edge i, so there is one vertex more than there are edges.
+	 */
+	struct Polygon {
+		vector<double> x, y, z;
+		vector<double> normal_x, normal_y, normal_z;
+
+		/**
+		 * Builds a polygon from its vertices (as unit vectors), closing it if necessary
+		 */
+		static Polygon fromVertices(const vector<Vector3>& vertices);
+
+		size_t numEdges() const;
+		Vector3 vertex(size_t i) const;
+		Vector3 edgeNormal(size_t i) const;
+
+		/**
+		 * Returns, for every edge, whether the point is on the positive side of the great
+		 * circle through that edge
+		 */
+		vector<uint8_t> edgeSides(const Vector3& point) const;
+	};
+
+	/**
+	 * Counts the edges of the polygon that are crossed by the great circle arc between site and
+	 * reference_point, using the fastest implementation available. The sides of the edges the
+	 * reference point is located on must be provided (see Polygon::edgeSides()).
+	 */
+	static unsigned int countCrossings(const Polygon& polygon, const Vector3& site, const Vector3& reference_point, const vector<uint8_t>& reference_sides);
+
+	/**
+	 * Same as above, but using a specific implementation (which must be available)
+	 */
+	static unsigned int countCrossings(Implementation implementation, const Polygon& polygon, const Vector3& site, const Vector3& reference_point, const vector<uint8_t>& reference_sides);
+
+	static bool isAvailable(Implementation implementation);
+	static Implementation bestImplementation();
+	static string getImplementationName(Implementation implementation);
+
+private:
+	typedef unsigned int (*KernelFunction)(const Polygon&, const Vector3&, const Vector3&, const uint8_t*);
+
+	static KernelFunction _getKernel(Implementation implementation);
+
+	static unsigned int _countCrossingsScalar(const Polygon& polygon, const Vector3& site, const Vector3& arc_normal, const uint8_t* reference_sides);
+	static unsigned int _countCrossingsSSE2(const Polygon& polygon, const Vector3& site, const Vector3& arc_normal, const uint8_t* reference_sides);
+	static unsigned int _countCrossingsAVX2(const Polygon& polygon, const Vector3& site, const Vector3& arc_normal, const uint8_t* reference_sides);
+};
+
+};
+
+#endif /* PLCROSSINGKERNEL_H_ */
@@ -0,0 +1,179 @@
+/*
+ * PLDataset.cpp
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: Sebastiaan J. van Schaik
+ */
+
+#include "PLDataset.h"
+
+#include "PLParameters.h"
+#include "PLPlates.h"
+#include "PLEulerPolesReconstructions.h"
+#include "PLPolarWanderPaths.h"
+#include "exceptions/PLFileParseException.h"
+
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include "../util/BinaryIO.h"
+#include "../util/Logger.h"
+#include "../util/MappedFile.h"
+#include "../util/Stats.h"
+
+using namespace paleo_latitude;
+
+// Identifies dataset bundles (see #writeBundle)
+static const char BUNDLE_FILE_MAGIC[8] = { 'P', 'L', 'B', 'U', 'N', 'D', 'L', 'E' };
+static const uint32_t BUNDLE_FILE_VERSION = 1;
+
+namespace {
+
+struct BundleHeader {
+	char magic[8];
+	uint32_t version;
+	uint32_t reserved;
+	uint64_t data_size;
+	uint64_t checksum;
+};
+
+};
+
+PLDataset::PLDataset() {
+
+}
+
+PLDataset::~PLDataset() {
+	delete _pwp;
+	delete _plates;
+	delete _euler;
+
+	_pwp = NULL;
+	_plates = NULL;
+	_euler = NULL;
+}
+
+PLDataset* PLDataset::readFromFiles(const PLParameters* params) {
+	const Stats::Timer timer(Stats::LOAD_DATASET);
+
+	if (!params->input_dataset_bundle.empty()){
+		PLDataset* res = readFromBundle(params->input_dataset_bundle);
+
+		try {
+			// Only builds the raster if the bundle does not contain one with this resolution
+			if (params->plates_raster_resolution != 0) res->_plates->enableRaster(params->plates_raster_resolution, params->plates_raster_file);
+		} catch (...){
+			delete res;
+			throw;
+		}
+
+		return res;
+	}
+
+	PLDataset* res = new PLDataset();
+
+	try {
+		res->_pwp = PLPolarWanderPaths::readFromFile(params->input_apwp_csv);
+		res->_plates = PLPlates::readFromFile(params->input_plates_file);
+		if (params->plates_raster_resolution != 0) res->_plates->enableRaster(params->plates_raster_resolution, params->plates_raster_file);
+		res->_euler = PLEulerPolesReconstructions::readFromFile(params->input_euler_rotation_csv);
+		res->_euler->buildPaleopoles(res->_pwp);
+	} catch (...){
+		delete res;
+		throw;
+	}
+
+	return res;
+}
+
+PLDataset* PLDataset::readFromBundle(const string& filename) {
+	Logger::logInfo("Reading dataset bundle " + filename + "...");
+
+	const MappedFile file(filename);
+	BundleHeader header;
+
+	if (file.size() < sizeof(header)){
+		throw PLFileParseException("Not a dataset bundle: " + filename);
+	}
+
+	memcpy(&header, file.data(), sizeof(header));
+	if (memcmp(header.magic, BUNDLE_FILE_MAGIC, sizeof(header.magic)) != 0){
+		throw PLFileParseException("Not a dataset bundle: " + filename);
+	}
+
+	if (header.version != BUNDLE_FILE_VERSION){
+		PLFileParseException ex;
+		ex << "Unsupported dataset bundle version " << header.version << " (expecting " << BUNDLE_FILE_VERSION << "): " << filename;
+		throw ex;
+	}
+
+	const char* data = file.data() + sizeof(header);
+	if (header.data_size != file.size() - sizeof(header) || BinaryIO::checksum(data, header.data_size) != header.checksum){
+		throw PLFileParseException("Dataset bundle is truncated or corrupt (checksum mismatch): " + filename);
+	}
+
+	PLDataset* res = new PLDataset();
+
+	try {
+		BinaryReader in(data, header.data_size, filename);
+		res->_pwp = PLPolarWanderPaths::readBinary(in);
+		res->_euler = PLEulerPolesReconstructions::readBinary(in);
+		res->_plates = PLPlates::readBinary(in);
+
+		if (!in.atEnd()) throw Exception("Unexpected data at end of dataset bundle '" + filename + "'");
+	} catch (const Exception& ex){
+		delete res;
+
+		PLFileParseException plfe;
+		plfe << "Error reading dataset bundle: " << ex.what();
+		throw plfe;
+	} catch (...){
+		delete res;
+		throw;
+	}
+
+	return res;
+}
+
+void PLDataset::writeBundle(const string& filename) const {
+	BinaryWriter out;
+	_pwp->writeBinary(out);
+	_euler->writeBinary(out);
+	_plates->writeBinary(out);
+
+	const vector<char>& data = out.getData();
+
+	BundleHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, BUNDLE_FILE_MAGIC, sizeof(header.magic));
+	header.version = BUNDLE_FILE_VERSION;
+	header.data_size = data.size();
+	header.checksum = BinaryIO::checksum(data.data(), data.size());
+
+	ofstream bundle(filename, ios::binary);
+	bundle.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	bundle.write(data.data(), data.size());
+	bundle.close();
+
+	if (!bundle.good()){
+		Exception ex;
+		ex << "Error writing dataset bundle to '" << filename << "'";
+		throw ex;
+	}
+
+	stringstream ss_info;
+	ss_info << "Wrote dataset bundle " << filename << " (" << (sizeof(header) + data.size()) << " bytes)";
+	Logger::logInfo(ss_info.str());
+}
+
+const PLPlates* PLDataset::getPlates() const {
+	return _plates;
+}
+
+const PLEulerPolesReconstructions* PLDataset::getEulerPolesReconstructions() const {
+	return _euler;
+}
+
+const PLPolarWanderPaths* PLDataset::getPolarWanderPaths() const {
+	return _pwp;
+}
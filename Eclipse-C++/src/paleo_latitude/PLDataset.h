@@ -0,0 +1,68 @@
+/*
+ * PLDataset.h
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: Sebastiaan J. van Schaik
+ */
+
+#ifndef PLDATASET_H_
+#define PLDATASET_H_
+
+#include <string>
+
+using namespace std;
+
+namespace paleo_latitude {
+
+class PLParameters;
+class PLPlates;
+class PLEulerPolesReconstructions;
+class PLPolarWanderPaths;
+
+/**
+ * The input data of the model: tectonic plates, Euler rotations and apparent polar wander
+ * paths. A dataset is read once and does not change afterwards, so it can be shared by any
+ * number of PaleoLatitude objects (also when these are used from multiple threads).
+ */
+class PLDataset {
+public:
+	PLDataset(const PLDataset& other) = delete;
+	virtual ~PLDataset();
+
+	const PLPlates* getPlates() const;
+	const PLEulerPolesReconstructions* getEulerPolesReconstructions() const;
+	const PLPolarWanderPaths* getPolarWanderPaths() const;
+
+	/**
+	 * Reads the input files (and, if configured, the plate raster) specified by the parameters,
+	 * or the dataset bundle if one is specified
+	 */
+	static PLDataset* readFromFiles(const PLParameters* params);
+
+	/**
+	 * Reads a dataset bundle written by #writeBundle. The file is memory-mapped, and the data
+	 * structures are restored from it without any parsing or (re)computation of derived data.
+	 */
+	static PLDataset* readFromBundle(const string& filename);
+
+	/**
+	 * Writes the dataset, including derived data (such as the containment data of the plates,
+	 * the paleopoles, and the plate raster if enabled), to a single binary file: the dataset
+	 * bundle. The file consists of a header (identifying the file format and version, and
+	 * containing the size and a checksum of the data) followed by the data of the polar wander
+	 * paths, Euler poles and plates. Like plate rasters, bundles are written in the byte order
+	 * of the machine.
+	 */
+	void writeBundle(const string& filename) const;
+
+private:
+	PLDataset();
+
+	PLPlates* _plates = NULL;
+	PLEulerPolesReconstructions* _euler = NULL;
+	PLPolarWanderPaths* _pwp = NULL;
+};
+
+};
+
+#endif /* PLDATASET_H_ */
@@ -8,12 +8,27 @@
 #include "PLEulerPolesReconstructions.h"
 
 #include "PLPlate.h"
+#include "../util/BinaryIO.h"
+#include "../util/Matrix3.h"
+#include "../util/Stats.h"
 #include <algorithm>
 #include <vector>
 #include <set>
 using namespace std;
 using namespace paleo_latitude;
 
+namespace {
+
+/**
+ * Compares entries by age, for binary searches in the (age-sorted) entries of a plate
+ */
+struct AgeComparator {
+	bool operator()(const PLEulerPolesReconstructions::EPEntry* entry, unsigned int age) const { return entry->age < age; }
+	bool operator()(unsigned int age, const PLEulerPolesReconstructions::EPEntry* entry) const { return age < entry->age; }
+};
+
+};
+
 
 PLEulerPolesReconstructions::PLEulerPolesReconstructions() {
 }
@@ -30,70 +45,170 @@ PLEulerPolesReconstructions* PLEulerPolesReconstructions::readFromFile(const str
 }
 
 void PLEulerPolesReconstructions::_readFromFile(const string& filename) {
+	const Stats::Timer timer(Stats::PARSE_CSV);
+
 	if (_csvdata != NULL) delete _csvdata;
 	_csvdata = new CSVFileData<EPEntry>();
 	_csvdata->parseFile(filename);
+	_paleopoles.clear();
+	_paleopoles_by_plate.clear();
+	_buildIndex();
 }
 
+void PLEulerPolesReconstructions::writeBinary(BinaryWriter& out) const {
+	vector<BinaryEntry> entries;
+	for (const EPEntry& entry : _csvdata->getEntries()){
+		entries.push_back(BinaryEntry{ entry.plate_id, entry.age, entry.rotation_rel_to_plate_id, entry.getLineNo(), entry.latitude, entry.longitude, entry.rotation });
+	}
 
-vector<unsigned int> PLEulerPolesReconstructions::getRelevantAges(const PLPlate* plate, unsigned int min, unsigned int max){
-	vector<unsigned int> res;
+	vector<BinaryPaleopole> paleopoles;
+	for (const Paleopole& paleopole : _paleopoles){
+		paleopoles.push_back(BinaryPaleopole{ paleopole.pole, paleopole.a95, (uint8_t) (paleopole.available ? 1 : 0), {} });
+	}
 
-	int left_outside_age = -1;
-	int right_outside_age = -1;
+	out.writeString(_csvdata->getFilename());
+	out.writeArray(entries);
+	out.writeArray(paleopoles);
+}
 
-	for (const EPEntry& entry : _csvdata->getEntries()){
-		if (entry.plate_id != plate->getId()) continue;
+PLEulerPolesReconstructions* PLEulerPolesReconstructions::readBinary(BinaryReader& in) {
+	const string filename = in.readString();
+	const ArrayView<BinaryEntry> entries = in.readArray<BinaryEntry>();
+	const ArrayView<BinaryPaleopole> paleopoles = in.readArray<BinaryPaleopole>();
 
+	if (!paleopoles.empty() && paleopoles.size() != entries.size()){
+		Exception ex;
+		ex << "Invalid Euler pole data in '" << in.getSource() << "'";
+		throw ex;
+	}
 
-		if (entry.age >= min && entry.age <= max){
-			if (!res.empty() && res.back() == entry.age){
-				// Duplicate age entry in CSV (possible for cross-over between relative plates)
-				continue;
-			}
+	PLEulerPolesReconstructions* res = new PLEulerPolesReconstructions();
+	res->_csvdata = new CSVFileData<EPEntry>();
+	res->_csvdata->reserve(entries.size());
+
+	for (const BinaryEntry& entry : entries){
+		EPEntry& ep_entry = res->_csvdata->addEntry(filename, entry.line_no);
+		ep_entry.plate_id = entry.plate_id;
+		ep_entry.age = entry.age;
+		ep_entry.rotation_rel_to_plate_id = entry.rotation_rel_to_plate_id;
+		ep_entry.latitude = entry.latitude;
+		ep_entry.longitude = entry.longitude;
+		ep_entry.rotation = entry.rotation;
+	}
 
-			// CSV entry falls in between the min/max: this age should be included
-			// in the ages.
-			res.push_back(entry.age);
-		}
+	res->_buildIndex();
+	res->_paleopoles.reserve(paleopoles.size());
+	for (const BinaryPaleopole& paleopole : paleopoles){
+		Paleopole& res_paleopole = res->_paleopoles.emplace_back();
+		res_paleopole.pole = paleopole.pole;
+		res_paleopole.a95 = paleopole.a95;
+		res_paleopole.available = (paleopole.available != 0);
+	}
+	if (!res->_paleopoles.empty()) res->_buildPaleopolesIndex();
 
-		if (entry.age <= min){
-			// Entry is on window border, or just outside window. Let's
-			// see whether we need it.
-			if (left_outside_age == -1 || (unsigned int) left_outside_age < entry.age){
-				// The previously found left-outside entry is less relevant than
-				// this entry
-				left_outside_age = entry.age;
-			}
-		}
+	return res;
+}
 
-		if (entry.age >= max){
-			// Entry is on/outside window border on right
-			if (right_outside_age == -1 || (unsigned int) right_outside_age > entry.age){
-				right_outside_age = entry.age;
-			}
+void PLEulerPolesReconstructions::_buildIndex() {
+	_entries_by_plate.clear();
+	_ages.clear();
+	_timelines.clear();
+	_plate_ids.clear();
+
+	for (const EPEntry& entry : _csvdata->getEntries()) _entries_by_plate.push_back(&entry);
+	stable_sort(_entries_by_plate.begin(), _entries_by_plate.end(), [](const EPEntry* a, const EPEntry* b){
+		return (a->plate_id != b->plate_id) ? (a->plate_id < b->plate_id) : (a->age < b->age);
+	});
+
+	for (size_t i = 0; i < _entries_by_plate.size(); i++){
+		const EPEntry* entry = _entries_by_plate[i];
+
+		if (i == 0 || _entries_by_plate[i - 1]->plate_id != entry->plate_id){
+			PlateTimeline& timeline = _timelines[entry->plate_id];
+			timeline.entries_begin = i;
+			timeline.ages_begin = _ages.size();
+			_plate_ids.insert(entry->plate_id);
 		}
+
+		PlateTimeline& timeline = _timelines[entry->plate_id];
+		if (_ages.size() == timeline.ages_begin || _ages.back() != entry->age) _ages.push_back(entry->age);
+		timeline.entries_end = i + 1;
+		timeline.ages_end = _ages.size();
+	}
+}
+
+const PLEulerPolesReconstructions::PlateTimeline* PLEulerPolesReconstructions::_getTimeline(unsigned int plate_id) const {
+	const auto it = _timelines.find(plate_id);
+	return (it != _timelines.end()) ? &it->second : NULL;
+}
+
+void PLEulerPolesReconstructions::buildPaleopoles(const PLPolarWanderPaths* pwp) {
+	const vector<EPEntry>& entries = _csvdata->getEntries();
+	_paleopoles.assign(entries.size(), Paleopole());
+
+	for (size_t i = 0; i < entries.size(); i++){
+		const PLPolarWanderPaths::PWPEntry* pwp_entry = pwp->findEntry(entries[i].rotation_rel_to_plate_id, entries[i].age);
+		if (pwp_entry != NULL) _paleopoles[i] = computePaleopole(entries[i], *pwp_entry);
 	}
 
-	if (left_outside_age >= 0 && (unsigned int) left_outside_age < min){
-		// Include left-outside
-		res.push_back(left_outside_age);
-	} // else: no left-outside, or left outside is on window border (and therefore already included)
+	_buildPaleopolesIndex();
+}
 
+void PLEulerPolesReconstructions::_buildPaleopolesIndex() {
+	const vector<EPEntry>& entries = _csvdata->getEntries();
 
-	if (right_outside_age >= 0 && (unsigned int) right_outside_age > max){
-		// Include left-outside
-		res.push_back(right_outside_age);
-	} // else: no right-outside, or is on window border (and therefore already included)
+	_paleopoles_by_plate.clear();
+	_paleopoles_by_plate.reserve(_entries_by_plate.size());
+	for (const EPEntry* entry : _entries_by_plate) _paleopoles_by_plate.push_back(_paleopoles[entry - entries.data()]);
+}
 
-	// Make sure the years are sorted from small (recent) to large (less recent)
-	sort(res.begin(), res.end());
+const PLEulerPolesReconstructions::Paleopole* PLEulerPolesReconstructions::getPaleopole(const EPEntry* entry) const {
+	if (_paleopoles.empty()) return NULL;
 
+	const size_t index = entry - _csvdata->getEntries().data();
+	if (index >= _paleopoles.size() || !_paleopoles[index].available) return NULL;
+	return &_paleopoles[index];
+}
+
+PLEulerPolesReconstructions::Paleopole PLEulerPolesReconstructions::computePaleopole(const EPEntry& euler_entry, const PLPolarWanderPaths::PWPEntry& pwp_entry) {
+	const double deg2rad = M_PI / 180.0;
+
+	// Rotation over -Ω around the Euler pole (L * R * L^T, with L the transformation matrix to
+	// the frame of the Euler pole)
+	const Matrix3 rotation = Matrix3::eulerRotation(euler_entry.latitude * deg2rad, euler_entry.longitude * deg2rad, -euler_entry.rotation * deg2rad);
+
+	Paleopole res;
+	res.pole = rotation * Vector3::fromLatLon(pwp_entry.latitude, pwp_entry.longitude);
+	res.a95 = pwp_entry.a95;
+	res.available = true;
 	return res;
 }
 
 
-void PLEulerPolesReconstructions::EPEntry::set(unsigned int col_index, const string value, const string filename, unsigned int lineno){
+ArrayView<unsigned int> PLEulerPolesReconstructions::getRelevantAges(const PLPlate* plate, unsigned int min, unsigned int max) const {
+	const Stats::Timer timer(Stats::EULER_LOOKUP);
+
+	const PlateTimeline* timeline = _getTimeline(plate->getId());
+	if (timeline == NULL || min > max) return ArrayView<unsigned int>();
+
+	const unsigned int* ages_begin = _ages.data() + timeline->ages_begin;
+	const unsigned int* ages_end = _ages.data() + timeline->ages_end;
+
+	// Ages within [min,max]
+	const unsigned int* first = lower_bound(ages_begin, ages_end, min);
+	const unsigned int* last = upper_bound(first, ages_end, max);
+
+	// Include the age just before min (unless min itself is available)...
+	if (first != ages_begin && (first == ages_end || *first != min)) first--;
+
+	// ...and the age just after max (unless max itself is available)
+	if (last != ages_end && (last == ages_begin || *(last - 1) != max)) last++;
+
+	return ArrayView<unsigned int>(first, last);
+}
+
+
+void PLEulerPolesReconstructions::EPEntry::set(unsigned int col_index, string_view value, const string& filename, unsigned int lineno){
 	// Column index 0: plate id (uint)
 	// Column index 1: age (uint)
 	// Column index 2: latitude (double)
@@ -120,42 +235,51 @@ bool PLEulerPolesReconstructions::EPEntry::compareByAge(const EPEntry* a, const
 
 
 vector<const PLEulerPolesReconstructions::EPEntry*> PLEulerPolesReconstructions::getEntries(unsigned int plate_id) const {
-	vector<const PLEulerPolesReconstructions::EPEntry*> res;
+	const PlateTimeline* timeline = _getTimeline(plate_id);
+	if (timeline == NULL) return vector<const EPEntry*>();
 
-	for (const EPEntry& entry : _csvdata->getEntries()){
-		if (entry.plate_id == plate_id) res.push_back(&entry);
-	}
-	return res;
+	return vector<const EPEntry*>(_entries_by_plate.begin() + timeline->entries_begin, _entries_by_plate.begin() + timeline->entries_end);
 }
 
-set<unsigned int> PLEulerPolesReconstructions::getPlateIds() const {
-	set<unsigned int> res;
-	for (const EPEntry& entry : _csvdata->getEntries()){
-		res.insert(entry.plate_id);
-	}
+const set<unsigned int>& PLEulerPolesReconstructions::getPlateIds() const {
+	return _plate_ids;
+}
+
+PLEulerPolesReconstructions::TimeSeries PLEulerPolesReconstructions::getTimeSeries(const PLPlate* plate) const {
+	const Stats::Timer timer(Stats::EULER_LOOKUP);
+
+	TimeSeries res;
+	const PlateTimeline* timeline = _getTimeline(plate->getId());
+	if (timeline == NULL) return res;
 
+	res.entries = ArrayView<const EPEntry*>(_entries_by_plate.data() + timeline->entries_begin, _entries_by_plate.data() + timeline->entries_end);
+	if (!_paleopoles_by_plate.empty()){
+		res.paleopoles = ArrayView<Paleopole>(_paleopoles_by_plate.data() + timeline->entries_begin, _paleopoles_by_plate.data() + timeline->entries_end);
+	}
 	return res;
 }
 
 
-vector<const PLEulerPolesReconstructions::EPEntry*> PLEulerPolesReconstructions::getEntries(const PLPlate* plate, unsigned int age) const {
+ArrayView<const PLEulerPolesReconstructions::EPEntry*> PLEulerPolesReconstructions::getEntries(const PLPlate* plate, unsigned int age) const {
 	return getEntries(plate->getId(), age);
 }
 
-vector<const PLEulerPolesReconstructions::EPEntry*> PLEulerPolesReconstructions::getEntries(unsigned int plate_id, unsigned int age) const {
-	vector<const PLEulerPolesReconstructions::EPEntry*> res;
+ArrayView<const PLEulerPolesReconstructions::EPEntry*> PLEulerPolesReconstructions::getEntries(unsigned int plate_id, unsigned int age) const {
+	const Stats::Timer timer(Stats::EULER_LOOKUP);
 
-	for (const EPEntry& entry : _csvdata->getEntries()){
-		if (entry.age == age && entry.plate_id == plate_id) res.push_back(&entry);
-	}
+	const PlateTimeline* timeline = _getTimeline(plate_id);
 
-	if (res.size() == 0){
-		Exception ex;
-		ex << "No entry for age=" << age << " and plate_id=" << plate_id << " found in Euler pole table?";
-		throw ex;
+	if (timeline != NULL){
+		const EPEntry* const* entries_begin = _entries_by_plate.data() + timeline->entries_begin;
+		const EPEntry* const* entries_end = _entries_by_plate.data() + timeline->entries_end;
+
+		const auto range = equal_range(entries_begin, entries_end, age, AgeComparator());
+		if (range.first != range.second) return ArrayView<const EPEntry*>(range.first, range.second);
 	}
 
-	return res;
+	Exception ex;
+	ex << "No entry for age=" << age << " and plate_id=" << plate_id << " found in Euler pole table?";
+	throw ex;
 }
 
 
@@ -7,9 +7,13 @@
 
 #ifndef PLEULERPOLESRECONSTRUCTIONS_H_
 #define PLEULERPOLESRECONSTRUCTIONS_H_
+#include <map>
 #include <set>
 #include <vector>
+#include "../util/ArrayView.h"
 #include "../util/CSVFileData.h"
+#include "../util/Vector3.h"
+#include "PLPolarWanderPaths.h"
 
 namespace paleo_latitude {
 
@@ -31,7 +35,7 @@ class PLEulerPolesReconstructions {
 public:
 	struct EPEntry : public CSVFileData<EPEntry>::StringEntry {
 		EPEntry(CSVFileData<EPEntry>* parent, unsigned int line_no) : CSVFileData<EPEntry>::StringEntry(parent, line_no){}
-		void set(unsigned int col_index, const string value, const string filename, unsigned int lineno) override;
+		void set(unsigned int col_index, string_view value, const string& filename, unsigned int lineno) override;
 		size_t numColumns() const override;
 
 		static bool compareByAge(const EPEntry* a, const EPEntry* b);
@@ -45,41 +49,137 @@ public:
 		double rotation = 0;
 	};
 
+	/**
+	 * Reference pole of an Euler entry: the pole of the apparent polar wander path of the plate
+	 * the rotation is relative to (at the same age), rotated using the Euler pole. It does not
+	 * depend on the site, so it is computed once per entry (see buildPaleopoles()).
+	 */
+	struct Paleopole {
+		Vector3 pole;		// unit vector
+		double a95 = 0;
+		bool available = false;
+	};
+
+	/**
+	 * All Euler entries of a plate (sorted by age) and their paleopoles, stored contiguously so
+	 * that a site can be evaluated for every age in a single pass. Both views have the same
+	 * length, except that the paleopoles view is empty if buildPaleopoles() was not called.
+	 */
+	struct TimeSeries {
+		ArrayView<const EPEntry*> entries;
+		ArrayView<Paleopole> paleopoles;
+	};
+
 	virtual ~PLEulerPolesReconstructions();
 
 	/**
-	 * Returns all ages relevant to a paleolatitude query from min to max.
+	 * Returns all ages relevant to a paleolatitude query from min to max (sorted, without
+	 * duplicates): the ages within [min,max], plus the nearest ages outside that window.
+	 * The view refers to the index of this object. Returns an empty view if min > max.
 	 */
-	vector<unsigned int> getRelevantAges(const PLPlate* plate, unsigned int min, unsigned int max);
+	ArrayView<unsigned int> getRelevantAges(const PLPlate* plate, unsigned int min, unsigned int max) const;
 
 	/**
 	 * Returns the Euler poles for a given plate and age. Often, the result will be a single
 	 * EPEntry, but in rare cases two entries will be returned. This happens at the cross-over
 	 * point at which rotation is expressed relative to two plates (e.g. plate 102 at 320 Ma in Torsvik).
 	 */
-	vector<const EPEntry*> getEntries(unsigned int plate_id, unsigned int age) const;
+	ArrayView<const EPEntry*> getEntries(unsigned int plate_id, unsigned int age) const;
 
 	/**
-	 * Returns all Euler poles for a given plate ID.
+	 * Returns all Euler poles for a given plate ID (sorted by age).
 	 */
 	vector<const EPEntry*> getEntries(unsigned int plate_id) const;
 
 	/**
 	 * Returns all plate IDs found in the Euler data
 	 */
-	set<unsigned int> getPlateIds() const;
+	const set<unsigned int>& getPlateIds() const;
 
-	vector<const EPEntry*> getEntries(const PLPlate* plate, unsigned int age) const;
+	/**
+	 * Returns the time series of a plate (empty if there are no Euler poles for the plate)
+	 */
+	TimeSeries getTimeSeries(const PLPlate* plate) const;
+
+	ArrayView<const EPEntry*> getEntries(const PLPlate* plate, unsigned int age) const;
 
 	const vector<EPEntry>& getAllEntries() const;
 
 	static PLEulerPolesReconstructions* readFromFile(const string& filename);
 
+	/**
+	 * Writes the entries and paleopoles in the binary format of dataset bundles
+	 */
+	void writeBinary(BinaryWriter& out) const;
+	static PLEulerPolesReconstructions* readBinary(BinaryReader& in);
+
+	/**
+	 * Computes the paleopole of every entry for which the apparent polar wander paths have data
+	 */
+	void buildPaleopoles(const PLPolarWanderPaths* pwp);
+
+	/**
+	 * Returns the precomputed paleopole of an entry, or NULL if it is not available (either
+	 * because buildPaleopoles() was not called, or because there is no APWP data for the entry)
+	 */
+	const Paleopole* getPaleopole(const EPEntry* entry) const;
+
+	static Paleopole computePaleopole(const EPEntry& euler_entry, const PLPolarWanderPaths::PWPEntry& pwp_entry);
+
 private:
+	/**
+	 * Entry as stored in dataset bundles
+	 */
+	struct BinaryEntry {
+		uint32_t plate_id;
+		uint32_t age;
+		uint32_t rotation_rel_to_plate_id;
+		uint32_t line_no;
+		double latitude;
+		double longitude;
+		double rotation;
+
+		static const bool BINARY_PACKED = true;
+	};
+	static_assert(sizeof(BinaryEntry) == 4 * sizeof(uint32_t) + 3 * sizeof(double), "BinaryEntry contains padding");
+
+	/**
+	 * Paleopole as stored in dataset bundles (with explicit padding, which must be zero)
+	 */
+	struct BinaryPaleopole {
+		Vector3 pole;
+		double a95;
+		uint8_t available;
+		uint8_t padding[7];
+
+		static const bool BINARY_PACKED = true;
+	};
+	static_assert(sizeof(BinaryPaleopole) == sizeof(Vector3) + sizeof(double) + 8, "BinaryPaleopole contains implicit padding");
+
+	/**
+	 * Location of the entries and (unique) ages of a single plate in the index
+	 */
+	struct PlateTimeline {
+		size_t entries_begin = 0, entries_end = 0;		// range in _entries_by_plate
+		size_t ages_begin = 0, ages_end = 0;			// range in _ages
+	};
+
 	PLEulerPolesReconstructions();
 	void _readFromFile(const string& filename);
+	void _buildIndex();
+	void _buildPaleopolesIndex();
+	const PlateTimeline* _getTimeline(unsigned int plate_id) const;
 
 	CSVFileData<EPEntry>* _csvdata = NULL;
+	vector<Paleopole> _paleopoles;		// same order as _csvdata->getEntries()
+
+	// Index: entries sorted by plate ID and age (retaining the order of the CSV file for entries
+	// with the same plate ID and age), and the sorted unique ages of every plate
+	vector<const EPEntry*> _entries_by_plate;
+	vector<Paleopole> _paleopoles_by_plate;		// same order as _entries_by_plate
+	vector<unsigned int> _ages;
+	map<unsigned int, PlateTimeline> _timelines;
+	set<unsigned int> _plate_ids;
 };
 
 };
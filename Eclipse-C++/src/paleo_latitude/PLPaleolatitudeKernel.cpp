@@ -0,0 +1,302 @@
+/*
+ * PLPaleolatitudeKernel.cpp
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: Sebastiaan J. van Schaik
+ */
+
+#include "PLPaleolatitudeKernel.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include "../util/Exception.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define PL_PALEOLATITUDE_KERNEL_X86
+#include <immintrin.h>
+#endif
+
+using namespace paleo_latitude;
+
+namespace {
+
+/**
+ * The kernels are written once using GCC vector extensions, for W lanes at a time (W = 1 for the
+ * scalar implementation). All helpers are forced inline, so that they are compiled using the
+ * instruction set of the (target-specific) kernel that calls them. Vectors are passed by
+ * reference to avoid ABI differences between instruction sets.
+ */
+template<unsigned int W> struct Lanes {
+	typedef double D __attribute__((vector_size(8 * W)));
+	typedef int64_t I __attribute__((vector_size(8 * W)));
+};
+
+/**
+ * Arc tangent, using the algorithm of the Cephes library (accurate to about 1e-16): the argument
+ * is reduced to [-0.66, 0.66] and a rational approximation is applied
+ */
+template<class V> __attribute__((always_inline)) inline void atanLanes(const V& x, V& res){
+	const double T3P8 = 2.41421356237309504880;		// tan(3π/8)
+	const double MOREBITS = 6.123233995736765886130E-17;
+
+	const V ax = (x < 0) ? -x : x;
+	const auto big = ax > T3P8;
+	const auto mid = ax > 0.66;
+
+	const V xr = big ? -1.0 / ax : (mid ? (ax - 1.0) / (ax + 1.0) : ax);
+	const V y0 = big ? (V() + M_PI_2) : (mid ? (V() + M_PI_4) : V());
+	const V more = big ? (V() + MOREBITS) : (mid ? (V() + 0.5 * MOREBITS) : V());
+
+	const V z = xr * xr;
+	const V p = (((-8.750608600031904122785E-1 * z - 1.615753718733365076637E1) * z - 7.500855792314704667340E1) * z - 1.228866684490136173410E2) * z - 6.485021904942025371773E1;
+	const V q = ((((z + 2.485846490142306297962E1) * z + 1.650270098316988542046E2) * z + 4.328810604912902668951E2) * z + 4.853903996359136964868E2) * z + 1.945506571482613964425E2;
+
+	const V r = y0 + ((xr * (z * p / q) + xr) + more);
+	res = (x < 0) ? -r : r;
+}
+
+/**
+ * Tangent of a non-negative argument, using the algorithm of the Cephes library: the argument
+ * is reduced to [-π/4, π/4] and a rational approximation is applied
+ */
+template<class V, class I> __attribute__((always_inline)) inline void tanLanes(const V& x, V& res){
+	const double DP1 = 7.853981554508209228515625E-1;	// π/4 in three parts
+	const double DP2 = 7.94662735614792836714E-9;
+	const double DP3 = 3.06161699786838294307E-17;
+
+	I j = __builtin_convertvector(x / M_PI_4, I);
+	j = j + (j & 1);
+	const V y = __builtin_convertvector(j, V);
+
+	const V z = ((x - y * DP1) - y * DP2) - y * DP3;
+	const V zz = z * z;
+	const V p = (-1.30936939181383777646E4 * zz + 1.15351664838587416140E6) * zz - 1.79565251976484877988E7;
+	const V q = (((zz + 1.36812963470692954678E4) * zz - 1.32089234440210967447E6) * zz + 2.50083801823357915839E7) * zz - 5.38695755929454629881E7;
+
+	const V r = (zz > 1e-14) ? z + z * (zz * p / q) : z;
+	res = ((j & 2) != 0) ? -1.0 / r : r;
+}
+
+/**
+ * Loads the sine of the paleolatitude of sites i ... i+W-1: the inner product of the sites and
+ * the paleopole (clamped to [-1,1] to guard against rounding errors)
+ */
+template<class V> __attribute__((always_inline)) inline void sinPaleolatitudeLanes(const Vector3& pole, const PLPaleolatitudeKernel::Sites& sites, size_t i, V& res){
+	V x, y, z;
+	memcpy(&x, &sites.x[i], sizeof(V));
+	memcpy(&y, &sites.y[i], sizeof(V));
+	memcpy(&z, &sites.z[i], sizeof(V));
+
+	const V s = pole.x * x + pole.y * y + pole.z * z;
+	res = (s > 1.0) ? (V() + 1.0) : ((s < -1.0) ? (V() - 1.0) : s);
+}
+
+/**
+ * Computes the paleolatitude and its bounds of sites i ... i+W-1, given the sine (s) and cosine
+ * (c) of their paleolatitude. As tan(I) = 2 s / c for the inclination I of the geomagnetic field,
+ * tan(I ± Δ_I) can be computed without evaluating I itself.
+ */
+template<class V, class I> __attribute__((always_inline)) inline void paleolatitudeLanes(const V& s, const V& c, double a95, PLPaleolatitudeKernel::Result& result, size_t i){
+	const double rad2deg = 180.0 / M_PI;
+
+	V lambda_rad;
+	atanLanes<V>(s / c, lambda_rad);
+	const V lambda = lambda_rad * rad2deg;
+	memcpy(&result.palat[i], &lambda, sizeof(V));
+
+	if (!(a95 > 0.0000001)){
+		const V unavailable = (V() - 99999);
+		memcpy(&result.palat_min[i], &unavailable, sizeof(V));
+		memcpy(&result.palat_max[i], &unavailable, sizeof(V));
+		return;
+	}
+
+	const V delta_i = (a95 * 2.0) / (1.0 + 3.0 * s * s);
+	const V delta_i_rad = (delta_i * M_PI) / 180.0;
+	V tan_delta_i;
+	tanLanes<V, I>(delta_i_rad, tan_delta_i);
+
+	const V two_s = 2.0 * s;
+	const V tan_incl_min = (two_s - c * tan_delta_i) / (c + two_s * tan_delta_i);
+	const V tan_incl_max = (two_s + c * tan_delta_i) / (c - two_s * tan_delta_i);
+
+	V lambda_min_rad, lambda_max_rad;
+	atanLanes<V>(0.5 * tan_incl_min, lambda_min_rad);
+	atanLanes<V>(0.5 * tan_incl_max, lambda_max_rad);
+
+	const V lambda_min = lambda_min_rad * rad2deg;
+	const V lambda_max = lambda_max_rad * rad2deg;
+	memcpy(&result.palat_min[i], &lambda_min, sizeof(V));
+	memcpy(&result.palat_max[i], &lambda_max, sizeof(V));
+}
+
+/**
+ * Processes the sites from index first onwards, one at a time
+ */
+void paleolatitudeTail(const Vector3& pole, double a95, const PLPaleolatitudeKernel::Sites& sites, PLPaleolatitudeKernel::Result& result, size_t first){
+	typedef Lanes<1>::D V;
+
+	for (size_t i = first; i < sites.size(); i++){
+		V s;
+		sinPaleolatitudeLanes<V>(pole, sites, i, s);
+		const V c = { sqrt((1.0 - s[0]) * (1.0 + s[0])) };
+		paleolatitudeLanes<V, Lanes<1>::I>(s, c, a95, result, i);
+	}
+}
+
+/**
+ * Same correction as in PaleoLatitude: bounds that moved over a pole end up on the wrong side
+ * of the paleolatitude, and are replaced by the pole
+ */
+void correctBoundsOverPole(double lambda, double& lambda_min, double& lambda_max){
+	if (lambda_max < lambda || lambda_min > lambda){
+		if (lambda < 0){
+			lambda_max = max(-abs(lambda_min), -abs(lambda_max));
+			lambda_min = -90;
+		} else {
+			lambda_min = min(abs(lambda_min), abs(lambda_max));
+			lambda_max = 90;
+		}
+	}
+}
+
+};
+
+void PLPaleolatitudeKernel::Sites::add(double latitude, double longitude) {
+	const Vector3 site = Vector3::fromLatLon(latitude, longitude);
+	x.push_back(site.x);
+	y.push_back(site.y);
+	z.push_back(site.z);
+}
+
+size_t PLPaleolatitudeKernel::Sites::size() const {
+	return x.size();
+}
+
+void PLPaleolatitudeKernel::Sites::clear() {
+	x.clear();
+	y.clear();
+	z.clear();
+}
+
+void PLPaleolatitudeKernel::compute(const PLEulerPolesReconstructions::Paleopole& paleopole, const Sites& sites, Result& result) {
+	static const KernelFunction kernel = _getKernel(bestImplementation());
+	_compute(kernel, paleopole, sites, result);
+}
+
+void PLPaleolatitudeKernel::compute(Implementation implementation, const PLEulerPolesReconstructions::Paleopole& paleopole, const Sites& sites, Result& result) {
+	_compute(_getKernel(implementation), paleopole, sites, result);
+}
+
+void PLPaleolatitudeKernel::_compute(KernelFunction kernel, const PLEulerPolesReconstructions::Paleopole& paleopole, const Sites& sites, Result& result) {
+	if (!paleopole.available){
+		Exception ex;
+		ex << "Cannot compute paleolatitudes: paleopole not available";
+		throw ex;
+	}
+
+	const size_t num_sites = sites.size();
+	result.palat.resize(num_sites);
+	result.palat_min.resize(num_sites);
+	result.palat_max.resize(num_sites);
+	if (num_sites == 0) return;
+
+	kernel(paleopole.pole, paleopole.a95, sites, result);
+
+	if (paleopole.a95 > 0.0000001){
+		for (size_t i = 0; i < num_sites; i++) correctBoundsOverPole(result.palat[i], result.palat_min[i], result.palat_max[i]);
+	}
+}
+
+bool PLPaleolatitudeKernel::isAvailable(Implementation implementation) {
+	switch (implementation){
+	case SCALAR:
+		return true;
+#ifdef PL_PALEOLATITUDE_KERNEL_X86
+	case SSE2:
+		return __builtin_cpu_supports("sse2");
+	case AVX2:
+		return __builtin_cpu_supports("avx2");
+#endif
+	default:
+		return false;
+	}
+}
+
+PLPaleolatitudeKernel::Implementation PLPaleolatitudeKernel::bestImplementation() {
+	if (isAvailable(AVX2)) return AVX2;
+	if (isAvailable(SSE2)) return SSE2;
+	return SCALAR;
+}
+
+string PLPaleolatitudeKernel::getImplementationName(Implementation implementation) {
+	switch (implementation){
+	case SCALAR: return "scalar";
+	case SSE2: return "SSE2";
+	case AVX2: return "AVX2";
+	}
+	return "unknown";
+}
+
+PLPaleolatitudeKernel::KernelFunction PLPaleolatitudeKernel::_getKernel(Implementation implementation) {
+	if (!isAvailable(implementation)){
+		Exception ex;
+		ex << "Paleolatitude kernel '" << getImplementationName(implementation) << "' is not supported on this system";
+		throw ex;
+	}
+
+	switch (implementation){
+	case SSE2: return &PLPaleolatitudeKernel::_computeSSE2;
+	case AVX2: return &PLPaleolatitudeKernel::_computeAVX2;
+	default: return &PLPaleolatitudeKernel::_computeScalar;
+	}
+}
+
+void PLPaleolatitudeKernel::_computeScalar(const Vector3& pole, double a95, const Sites& sites, Result& result) {
+	paleolatitudeTail(pole, a95, sites, result, 0);
+}
+
+#ifdef PL_PALEOLATITUDE_KERNEL_X86
+
+__attribute__((target("sse2")))
+void PLPaleolatitudeKernel::_computeSSE2(const Vector3& pole, double a95, const Sites& sites, Result& result) {
+	typedef Lanes<2>::D V;
+
+	size_t i = 0;
+	for (; i + 2 <= sites.size(); i += 2){
+		V s;
+		sinPaleolatitudeLanes<V>(pole, sites, i, s);
+		const V c = _mm_sqrt_pd((1.0 - s) * (1.0 + s));
+		paleolatitudeLanes<V, Lanes<2>::I>(s, c, a95, result, i);
+	}
+
+	paleolatitudeTail(pole, a95, sites, result, i);
+}
+
+__attribute__((target("avx2")))
+void PLPaleolatitudeKernel::_computeAVX2(const Vector3& pole, double a95, const Sites& sites, Result& result) {
+	typedef Lanes<4>::D V;
+
+	size_t i = 0;
+	for (; i + 4 <= sites.size(); i += 4){
+		V s;
+		sinPaleolatitudeLanes<V>(pole, sites, i, s);
+		const V c = _mm256_sqrt_pd((1.0 - s) * (1.0 + s));
+		paleolatitudeLanes<V, Lanes<4>::I>(s, c, a95, result, i);
+	}
+
+	paleolatitudeTail(pole, a95, sites, result, i);
+}
+
+#else
+
+void PLPaleolatitudeKernel::_computeSSE2(const Vector3& pole, double a95, const Sites& sites, Result& result) {
+	_computeScalar(pole, a95, sites, result);
+}
+
+void PLPaleolatitudeKernel::_computeAVX2(const Vector3& pole, double a95, const Sites& sites, Result& result) {
+	_computeScalar(pole, a95, sites, result);
+}
+
+#endif
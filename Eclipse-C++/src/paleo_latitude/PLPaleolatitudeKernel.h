@@ -0,0 +1,82 @@
+/*
+ * PLPaleolatitudeKernel.h
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: Sebastiaan J. van Schaik
+ */
+
+#ifndef PLPALEOLATITUDEKERNEL_H_
+#define PLPALEOLATITUDEKERNEL_H_
+
+#include <string>
+#include <vector>
+#include "PLEulerPolesReconstructions.h"
+#include "../util/Vector3.h"
+
+using namespace std;
+
+namespace paleo_latitude {
+
+/**
+ * Computes the paleolatitude (and its lower and upper bound) of many sites for a single Euler
+ * entry, i.e. for sites on the same plate at the same age. The computation is the same as in
+ * PaleoLatitude, but processes several sites at once using SIMD instructions (SSE2 or AVX2,
+ * selected at runtime). Results agree with those of PaleoLatitude to within about 1e-9 degrees.
+ *
+ * This class is part of the library API only: PLSitesBatch (and hence --input-sites-csv,
+ * --stream and --serve) computes every site using PaleoLatitude, so that a site in a batch
+ * always yields exactly the same output as the same site on its own. A difference of 1e-9
+ * degrees can change the last printed digit of a paleolatitude.
+ */
+class PLPaleolatitudeKernel {
+public:
+	enum Implementation { SCALAR, SSE2, AVX2 };
+
+	/**
+	 * Sites as unit vectors, in structure-of-arrays layout
+	 */
+	struct Sites {
+		vector<double> x, y, z;
+
+		void add(double latitude, double longitude);
+		size_t size() const;
+		void clear();
+	};
+
+	/**
+	 * Paleolatitudes and bounds (in degrees) per site. The bounds are -99999 when they cannot be
+	 * computed (i.e. no A95 is available for the paleopole)
+	 */
+	struct Result {
+		vector<double> palat, palat_min, palat_max;
+	};
+
+	/**
+	 * Computes the paleolatitude of all sites using the given (precomputed) paleopole, using the
+	 * fastest implementation available
+	 */
+	static void compute(const PLEulerPolesReconstructions::Paleopole& paleopole, const Sites& sites, Result& result);
+
+	/**
+	 * Same as above, but using a specific implementation (which must be available)
+	 */
+	static void compute(Implementation implementation, const PLEulerPolesReconstructions::Paleopole& paleopole, const Sites& sites, Result& result);
+
+	static bool isAvailable(Implementation implementation);
+	static Implementation bestImplementation();
+	static string getImplementationName(Implementation implementation);
+
+private:
+	typedef void (*KernelFunction)(const Vector3& pole, double a95, const Sites& sites, Result& result);
+
+	static KernelFunction _getKernel(Implementation implementation);
+	static void _compute(KernelFunction kernel, const PLEulerPolesReconstructions::Paleopole& paleopole, const Sites& sites, Result& result);
+
+	static void _computeScalar(const Vector3& pole, double a95, const Sites& sites, Result& result);
+	static void _computeSSE2(const Vector3& pole, double a95, const Sites& sites, Result& result);
+	static void _computeAVX2(const Vector3& pole, double a95, const Sites& sites, Result& result);
+};
+
+};
+
+#endif /* PLPALEOLATITUDEKERNEL_H_ */
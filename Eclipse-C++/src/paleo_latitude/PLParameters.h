@@ -32,6 +32,14 @@ public:
 	string input_euler_rotation_csv = "data/euler-torsvik-2012.csv";
 	string input_plates_file = "data/plates.gpml";
 
+	// Dataset bundle (see PLDataset::writeBundle) to read instead of the input files above (optional)
+	string input_dataset_bundle = "";
+
+	// Cell size (in degrees) of the plate raster used to speed up plate lookups (0 = disabled),
+	// and the file the raster is cached in (optional)
+	double plates_raster_resolution = 0;
+	string plates_raster_file = "";
+
 	// Initialise to default (invalid) values
 	double site_latitude = -9999;
 	double site_longitude = -9999;
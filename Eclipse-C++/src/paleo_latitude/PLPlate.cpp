@@ -1,30 +1,42 @@
 
 #include "PLPlate.h"
 
-#include "pugixml.hpp"
-
-#include <boost/geometry/geometries/point_xy.hpp>
-#include <boost/geometry/geometries/segment.hpp>
-#include <boost/geometry/algorithms/intersection.hpp>
 #include <boost/algorithm/string/case_conv.hpp>
 
 
+#include <locale>
 #include <random>
+#include <sstream>
 #include <vector>
+#include "../util/BinaryIO.h"
 #include "../util/Logger.h"
+#include "../util/Stats.h"
+#include "../util/TextBuffer.h"
 #include "../util/Util.h"
 #include "../util/Exception.h"
 
 
-namespace bg = boost::geometry;
 
 using namespace paleo_latitude;
-using pugi::xml_document;
+
+const unsigned int PLPlate::UNCONSTRAINED_PLATE_ID = 1001;
 
 PLPlate::PLPlate(unsigned int plate_id, string plate_name, vector<Coordinate>* polygon_coordinates) :
+				PLPlate(plate_id, plate_name, polygon_coordinates, true)
+{
+}
+
+PLPlate::PLPlate(unsigned int plate_id, string plate_name, vector<Coordinate>* polygon_coordinates, bool compute_containment_data) :
 				_id(plate_id), _name(PLPlate::_filterPlateName(plate_name)), _polygon_coordinates(polygon_coordinates)
 {
 	assert(_polygon_coordinates != NULL);
+	_serialiseKMLPlacemark();
+
+	if (!compute_containment_data) return; // restored by readBinary()
+
+	// The bounding box is used to validate the reference points of the containment data
+	_computeBoundingBox();
+	_computeContainmentData();
 }
 
 string PLPlate::_filterPlateName(const string plate_name){
@@ -45,13 +57,19 @@ string PLPlate::_filterPlateName(const string plate_name){
  */
 bool PLPlate::contains(const PLPlate& other_plate) const {
 	// Count number of coordinates of other_plate that sit within this plate
+	const size_t num_coordinates = other_plate._polygon_coordinates->size();
 	unsigned int poly_coordinates_in_this_plate = 0;
-	for (unsigned int i = 0; i < other_plate._polygon_coordinates->size(); i++){
+	for (unsigned int i = 0; i < num_coordinates; i++){
 		const Coordinate& other_poly_coord = (*other_plate._polygon_coordinates)[i];
 		poly_coordinates_in_this_plate += this->contains(other_poly_coord) ? 1 : 0;
+
+		// Stop as soon as the outcome is known
+		const unsigned int remaining = num_coordinates - i - 1;
+		if ((double)(poly_coordinates_in_this_plate + remaining) / num_coordinates <= 0.9) return false;
+		if ((double)poly_coordinates_in_this_plate / num_coordinates > 0.9) return true;
 	}
 
-	double fraction_in = (double)poly_coordinates_in_this_plate / other_plate._polygon_coordinates->size();
+	double fraction_in = (double)poly_coordinates_in_this_plate / num_coordinates;
 
 	// Assume the other plate is fully located within this plate if > 90% of its polygon
 	// coordinates fall within this plate.
@@ -59,90 +77,244 @@ bool PLPlate::contains(const PLPlate& other_plate) const {
 }
 
 bool PLPlate::contains(const Coordinate& site) const {
-	typedef boost::geometry::model::point<double, 2, boost::geometry::cs::geographic<boost::geometry::degree> > point_type;
-	typedef boost::geometry::model::segment<point_type> segment_type;
-
-	const point_type pnt_site(site.longitude, site.latitude);
-
-	// Shooting a ray to a fixed target causes all sorts of problems. So: shoot a series of rays to
-	// coordinates that are guaranteed to be in different plates.
-	// One of the ray targets might be on the same plate as the site_coord, which will render that
-	// ray. Also: the plates of the targets will cause a single false positive each.
-
-	vector<Coordinate> ray_targets = {
-			Coordinate(89, 0),					// north pole = North American plate
-			Coordinate(-89, 0),					// south pole = East Antarctic plate
-			Coordinate(-18.933333, 47.516667),	// Antananarivo = Madagascar plate
-			Coordinate(21.3, -157.816667),		// Honolulu, Hawaii = Pacific plate
-			Coordinate(64.175, -51.738889),		// Nuuk, Greenland = Greenland plate
-			Coordinate(9.06, 7.47),				// Abuja, Nigeria = African plate
-			Coordinate(51.5, -0.1),				// London = European plate
-			Coordinate(-33.8, 151.2),			// Sydney = Australian plate
-			Coordinate(45,-93.25),				// Minneapolis = North American plate
-			Coordinate(-22.9, -42.2),			// Rio de Janeiro = South American plate
-			Coordinate(14.75, -17.45),			// Dakar = NW African plate
-			Coordinate(22.3, 114.16)			// Hong Kong
-	};
-
-	vector<segment_type> rays;
-	for (const Coordinate& ray_target : ray_targets){
-		const point_type pnt_ray_target(ray_target.longitude, ray_target.latitude);
-		segment_type ray(pnt_site, pnt_ray_target);
-		rays.push_back(ray);
-	}
-
-	vector<unsigned int> ray_targets_intersection_counts(ray_targets.size(), 0);
-
-
-	for (unsigned int i = 0; i < _polygon_coordinates->size(); i++){
-		const Coordinate& curr = (*_polygon_coordinates)[i];
-		const Coordinate& next = (*_polygon_coordinates)[(i+1) % _polygon_coordinates->size()];
-
-		if (abs(curr.longitude - next.longitude) > 270){
-			// Line likely crosses date boundary on 180 degree meridian. Rather than
-			// drawing a very short line segment, Boost will draw one all the way
-			// around the sphere. Given that multiple rays are used, we can afford to
-			// skip this single segment.
-			continue;
-		}
+	const Stats::Timer timer(Stats::PLATE_CONTAINS);
 
-		const point_type pnt_curr(curr.longitude, curr.latitude);
-		const point_type pnt_next(next.longitude, next.latitude);
+	if (_polygon.numEdges() == 0) return false;
 
-		const segment_type plate_segment(pnt_curr, pnt_next);
+	const Vector3 site_vec = Vector3::fromLatLon(site.latitude, site.longitude);
 
-		for (unsigned int r = 0; r < rays.size(); r++){
-			bool intersects = bg::intersects(rays[r], plate_segment);
+	// The arc between the site and a reference point is ill-defined when the two are (nearly)
+	// antipodal, in which case the second reference point is used
+	const ReferencePoint& ref = (site_vec.cross(_reference_points[0].point).norm() > 0.01) ? _reference_points[0] : _reference_points[1];
 
-			if (intersects) ray_targets_intersection_counts[r]++;
-		}
+	const bool odd_crossings = (PLCrossingKernel::countCrossings(_polygon, site_vec, ref.point, ref.sides) % 2 == 1);
+	return odd_crossings != ref.inside;
+}
+
+/**
+ * Converts the polygon to unit vectors and computes the normals of the great circles through
+ * all edges, as well as two reference points with a known location (inside or outside) with
+ * respect to this plate. This allows #contains(const Coordinate&) to test a site by counting
+ * edge crossings, without any trigonometry or special treatment of the 180 degree meridian.
+ */
+void PLPlate::_computeContainmentData() {
+	vector<Vector3> vertices;
+	Vector3 sum_vertices;
+	for (const Coordinate& coord : *_polygon_coordinates){
+		vertices.push_back(Vector3::fromLatLon(coord.latitude, coord.longitude));
+		sum_vertices = sum_vertices + vertices.back();
 	}
 
-	// Each of the ray targets will have an intersection count that represents the number
-	// of polygon lines that ray intersected
-	unsigned int votes_inside = 0;
-	unsigned int votes_outside = 0;
-	for (unsigned int intersections : ray_targets_intersection_counts){
-		if (intersections % 2 == 0) votes_outside++;
-		else votes_inside++;
+	_polygon = PLCrossingKernel::Polygon::fromVertices(vertices);
+	if (vertices.empty()) return;
+
+	// Plates are normally far smaller than a hemisphere, so the point opposite to the centre
+	// of the vertices is outside the plate. The polar caps of North America and Antarctica
+	// are an exception, but their vertices surround the pole and are hence still
+	// located on the hemisphere of that pole.
+	const Vector3 centre = (sum_vertices.norm() > 1e-9) ? sum_vertices.normalised() : Vector3(0, 0, -1);
+	bool one_hemisphere = true;
+	for (const Vector3& vertex : vertices) one_hemisphere = one_hemisphere && (vertex.dot(centre) > 0);
+
+	_reference_points[0].point = _findReferencePoint(-centre);
+	_reference_points[0].inside = false;
+
+	// Anything outside the bounding box is outside the plate, which is not guaranteed for the
+	// opposite of the centre when the plate is larger than a hemisphere
+	const Vector3& first_point = _reference_points[0].point;
+	if (!one_hemisphere || _bounding_box.contains(Coordinate(first_point.latitude(), first_point.longitude()))){
+		_reference_points[0].point = _findReferencePoint(_findOutsidePoint());
+
+		stringstream msg;
+		msg << "Plate '" << _name << "' (" << _id << ") may be larger than a hemisphere: using "
+				<< _reference_points[0].point.latitude() << "," << _reference_points[0].point.longitude()
+				<< " (outside of its bounding box) as reference point";
+		Logger::logWarn(msg.str());
 	}
+	_reference_points[0].sides = _polygon.edgeSides(_reference_points[0].point);
+
+	// Second reference point, 90 degrees away from the first one. Whether it's located
+	// inside the plate is determined using the first reference point.
+	const Vector3& first = _reference_points[0].point;
+	const Vector3 axis = (abs(first.z) < 0.9) ? Vector3(0, 0, 1) : Vector3(1, 0, 0);
+	_reference_points[1].point = _findReferencePoint(first.cross(axis).normalised());
+	_reference_points[1].sides = _polygon.edgeSides(_reference_points[1].point);
+	_reference_points[1].inside = (PLCrossingKernel::countCrossings(_polygon, _reference_points[1].point, _reference_points[0].point, _reference_points[0].sides) % 2 == 1);
+}
+
+/**
+ * Returns a point halfway between the bounding box and a pole, or otherwise in the middle of the
+ * longitudes that are not covered by the bounding box. Such a point is outside this plate.
+ */
+Vector3 PLPlate::_findOutsidePoint() const {
+	const BoundingBox& box = _bounding_box;
+	if (box.min_latitude > -89) return Vector3::fromLatLon((box.min_latitude - 90) / 2, 0);
+	if (box.max_latitude < 89) return Vector3::fromLatLon((box.max_latitude + 90) / 2, 0);
+
+	double gap = box.min_longitude - box.max_longitude;
+	if (gap < 0) gap += 360;
+	if (gap > 1) return Vector3::fromLatLon(0, box.max_longitude + gap / 2);
 
-	assert(votes_inside + votes_outside == ray_targets.size());
+	Exception ex;
+	ex << "Could not find a reference point outside of plate '" << _name << "' (" << _id << "): its bounding box "
+			<< box.to_string() << " covers the entire globe";
+	throw ex;
+}
 
-	if (votes_inside > 2 * votes_outside){
-		// Point is inside plate
-		return true;
-	} else if (votes_outside > 2 * votes_inside){
-		// Point not in plate
-		return false;
+/**
+ * Returns a point close to the given candidate that is not located on (or very near) the great
+ * circle through any of the edges, which guarantees that the point is on a well-defined side of
+ * every edge.
+ */
+Vector3 PLPlate::_findReferencePoint(const Vector3& candidate) const {
+	Vector3 point = candidate;
+	mt19937 rng(_id);
+	uniform_real_distribution<double> dist(-1e-3, 1e-3);
+
+	for (unsigned int attempt = 0; attempt < 100; attempt++){
+		bool on_edge = false;
+		for (size_t i = 0; i < _polygon.numEdges(); i++){
+			const Vector3 normal = _polygon.edgeNormal(i);
+			const double normal_length = normal.norm();
+			if (normal_length > 0 && abs(normal.dot(point)) <= 1e-9 * normal_length){
+				on_edge = true;
+				break;
+			}
+		}
+		if (!on_edge) return point;
+
+		point = (point + Vector3(dist(rng), dist(rng), dist(rng))).normalised();
 	}
 
 	Exception ex;
-	ex << "Could not determine with sufficient certainty whether site (" << site.to_string() << ") is on plate '" << _name << "' (" << _id << "). Is the site on the border of two plates? (Details: in/out ray votes are " << votes_inside << " vs " << votes_outside << ")";
+	ex << "Could not find a reference point outside of the edges of plate '" << _name << "' (" << _id << ")";
 	throw ex;
 }
 
+/**
+ * Computes the latitude/longitude bounds of this plate. Polygon edges are great circle
+ * segments, which can bulge towards a pole beyond the latitude of their end points, so
+ * the latitude extremes of every edge are taken into account. Plates that wind around
+ * a pole span all longitudes and extend up to that pole.
+ */
+void PLPlate::_computeBoundingBox() {
+	_bounding_box = BoundingBox();
+	if (_polygon_coordinates->empty()) return;
+
+	// Margin (in degrees) to account for rounding errors in the great circle computations
+	// (both here and in #contains(const Coordinate&))
+	const double margin = 0.01;
+
+	const Vector3 north(0, 0, 1);
+	const size_t num_coords = _polygon_coordinates->size();
+
+	double min_lat = 90, max_lat = -90;
+	double unwrapped_lon = (*_polygon_coordinates)[0].longitude;
+	double min_unwrapped_lon = unwrapped_lon, max_unwrapped_lon = unwrapped_lon;
+	Vector3 sum_vertices;
+
+	for (unsigned int i = 0; i < num_coords; i++){
+		const Coordinate& curr = (*_polygon_coordinates)[i];
+		const Coordinate& next = (*_polygon_coordinates)[(i+1) % num_coords];
+
+		min_lat = min(min_lat, curr.latitude);
+		max_lat = max(max_lat, curr.latitude);
+
+		// Walk along the polygon without jumping at the 180 degree meridian
+		double delta_lon = next.longitude - curr.longitude;
+		if (delta_lon > 180) delta_lon -= 360;
+		if (delta_lon < -180) delta_lon += 360;
 
+		if (i + 1 < num_coords){
+			unwrapped_lon += delta_lon;
+			min_unwrapped_lon = min(min_unwrapped_lon, unwrapped_lon);
+			max_unwrapped_lon = max(max_unwrapped_lon, unwrapped_lon);
+		}
+
+		// Northernmost/southernmost points of the great circle through both end points,
+		// which are only relevant if they are located on the segment itself
+		const Vector3 a = Vector3::fromLatLon(curr.latitude, curr.longitude);
+		const Vector3 b = Vector3::fromLatLon(next.latitude, next.longitude);
+		const Vector3 normal = a.cross(b);
+		sum_vertices = sum_vertices + a;
+
+		if (normal.norm() < 1e-12) continue;
+		const Vector3 n = normal.normalised();
+		const Vector3 top = north - n * north.dot(n);
+		if (top.norm() < 1e-12) continue; // segment on equator
+
+		for (const Vector3& extreme : { top.normalised(), -top.normalised() }){
+			if (a.cross(extreme).dot(normal) > 0 && extreme.cross(b).dot(normal) > 0){
+				min_lat = min(min_lat, extreme.latitude());
+				max_lat = max(max_lat, extreme.latitude());
+			}
+		}
+	}
+
+	// Close the polygon: the total change in longitude reveals whether the polygon
+	// winds around a pole
+	double closing_delta_lon = (*_polygon_coordinates)[0].longitude - (*_polygon_coordinates)[num_coords - 1].longitude;
+	if (closing_delta_lon > 180) closing_delta_lon -= 360;
+	if (closing_delta_lon < -180) closing_delta_lon += 360;
+	const double winding = unwrapped_lon + closing_delta_lon - (*_polygon_coordinates)[0].longitude;
+
+	if (abs(winding) > 180){
+		// Plate contains a pole: the vertices are (on average) located on the hemisphere
+		// of that pole
+		if (sum_vertices.z > 0) max_lat = 90;
+		else min_lat = -90;
+
+		_bounding_box.min_longitude = -180;
+		_bounding_box.max_longitude = 180;
+	} else if (max_unwrapped_lon - min_unwrapped_lon + 2 * margin >= 360){
+		_bounding_box.min_longitude = -180;
+		_bounding_box.max_longitude = 180;
+	} else {
+		double min_lon = min_unwrapped_lon - margin;
+		double max_lon = max_unwrapped_lon + margin;
+		while (min_lon < -180){ min_lon += 360; max_lon += 360; }
+		while (min_lon >= 180){ min_lon -= 360; max_lon -= 360; }
+		if (max_lon > 180) max_lon -= 360; // crosses the 180 degree meridian
+
+		_bounding_box.min_longitude = min_lon;
+		_bounding_box.max_longitude = max_lon;
+	}
+
+	_bounding_box.min_latitude = max(-90.0, min_lat - margin);
+	_bounding_box.max_latitude = min(90.0, max_lat + margin);
+}
+
+const PLPlate::BoundingBox& PLPlate::getBoundingBox() const {
+	return _bounding_box;
+}
+
+bool PLPlate::isUnconstrained() const {
+	return (_id == UNCONSTRAINED_PLATE_ID);
+}
+
+bool PLPlate::BoundingBox::empty() const {
+	return min_latitude > max_latitude;
+}
+
+bool PLPlate::BoundingBox::crossesDateLine() const {
+	return min_longitude > max_longitude;
+}
+
+bool PLPlate::BoundingBox::contains(const Coordinate& site) const {
+	if (site.latitude < min_latitude || site.latitude > max_latitude) return false;
+
+	if (crossesDateLine()){
+		return site.longitude >= min_longitude || site.longitude <= max_longitude;
+	} else {
+		return site.longitude >= min_longitude && site.longitude <= max_longitude;
+	}
+}
+
+string PLPlate::BoundingBox::to_string() const {
+	stringstream ss;
+	ss << "[" << min_latitude << "," << max_latitude << "] x [" << min_longitude << "," << max_longitude << "]";
+	return ss.str();
+}
 
 PLPlate::~PLPlate() {
 	delete _polygon_coordinates;
@@ -178,7 +350,15 @@ string Coordinate::to_string() const {
 	return ss.str();
 }
 
-void paleo_latitude::PLPlate::writeKMLPlacemark(ostream& output_stream, string linecolor) const {
+void paleo_latitude::PLPlate::writeKMLPlacemark(ostream& output_stream, const string& linecolor) const {
+	const string* tail = _getKMLTail(output_stream);
+	if (tail != NULL){
+		output_stream.write(_kml_head.data(), _kml_head.size());
+		output_stream.write(linecolor.data(), linecolor.size());
+		output_stream.write(tail->data(), tail->size());
+		return;
+	}
+
 	output_stream << "<Placemark>" << endl
 		<< " <name>" << this->getName() << " (" << this->getId() << ")</name>" << endl
 		<< " <Style><LineStyle><color>" << linecolor << "</color></LineStyle><PolyStyle><fill>0</fill></PolyStyle></Style>" << endl
@@ -193,3 +373,127 @@ void paleo_latitude::PLPlate::writeKMLPlacemark(ostream& output_stream, string l
 	output_stream << " </coordinates></LinearRing></outerBoundaryIs></Polygon>" << endl;
 	output_stream << "</Placemark>" << endl;
 }
+
+void PLPlate::_serialiseKMLPlacemark() {
+	// Same output as writeKMLPlacemark() without a cached placemark
+	TextBuffer head;
+	head.append("<Placemark>\n <name>").append(_name).append(" (").appendInteger(_id).append(")</name>\n");
+	head.append(" <Style><LineStyle><color>");
+	_kml_head = head.str();
+
+	TextBuffer tail, tail_fixed;
+	for (TextBuffer* buffer : { &tail, &tail_fixed }){
+		buffer->append("</color></LineStyle><PolyStyle><fill>0</fill></PolyStyle></Style>\n");
+		buffer->append(" <Polygon><outerBoundaryIs><LinearRing><coordinates>\n");
+	}
+
+	for (const Coordinate& coord : *_polygon_coordinates){
+		tail.appendGeneral(coord.longitude).append(',').appendGeneral(coord.latitude).append(' ');
+		tail_fixed.appendFixed(coord.longitude, 5).append(',').appendFixed(coord.latitude, 5).append(' ');
+	}
+
+	for (TextBuffer* buffer : { &tail, &tail_fixed }){
+		buffer->append("\n </coordinates></LinearRing></outerBoundaryIs></Polygon>\n");
+		buffer->append("</Placemark>\n");
+	}
+
+	_kml_tail = tail.str();
+	_kml_tail_fixed = tail_fixed.str();
+}
+
+/**
+ * Returns the cached part of the placemark after the line colour that matches the format of the
+ * output stream, or NULL if there is none
+ */
+const string* PLPlate::_getKMLTail(const ostream& output_stream) const {
+	// Formatting also depends on the locale and field width of the stream
+	if (output_stream.width() != 0 || output_stream.getloc() != locale::classic()) return NULL;
+
+	// Skipping whitespace only affects input
+	const ios::fmtflags format = output_stream.flags() & ~ios::skipws;
+	if (format == ios::dec && output_stream.precision() == 6) return &_kml_tail;
+	if (format == (ios::dec | ios::fixed) && output_stream.precision() == 5) return &_kml_tail_fixed;
+
+	return NULL;
+}
+
+void paleo_latitude::PLPlate::writeBinary(BinaryWriter& out) const {
+	vector<double> coordinates;
+	coordinates.reserve(2 * _polygon_coordinates->size());
+	for (const Coordinate& coord : *_polygon_coordinates){
+		coordinates.push_back(coord.latitude);
+		coordinates.push_back(coord.longitude);
+	}
+
+	out.write<uint32_t>(_id);
+	out.writeString(_name);
+	out.writeArray(coordinates);
+	out.write(_bounding_box);
+
+	out.writeArray(_polygon.x);
+	out.writeArray(_polygon.y);
+	out.writeArray(_polygon.z);
+	out.writeArray(_polygon.normal_x);
+	out.writeArray(_polygon.normal_y);
+	out.writeArray(_polygon.normal_z);
+
+	for (const ReferencePoint& ref : _reference_points){
+		out.write(ref.point);
+		out.write<uint8_t>(ref.inside ? 1 : 0);
+		out.writeArray(ref.sides);
+	}
+}
+
+/**
+ * Restores a plate written by #writeBinary. The sizes of the arrays are checked, as the
+ * point-in-polygon kernel relies on them.
+ */
+PLPlate* paleo_latitude::PLPlate::readBinary(BinaryReader& in) {
+	const unsigned int plate_id = in.read<uint32_t>();
+	const string name = in.readString();
+	const ArrayView<double> coordinates = in.readArray<double>();
+
+	vector<Coordinate>* polygon_coordinates = new vector<Coordinate>();
+	polygon_coordinates->reserve(coordinates.size() / 2);
+	for (size_t i = 0; i + 1 < coordinates.size(); i += 2){
+		polygon_coordinates->emplace_back(coordinates[i], coordinates[i + 1]);
+	}
+
+	PLPlate* res = new PLPlate(plate_id, name, polygon_coordinates, false);
+
+	try {
+		res->_bounding_box = in.read<BoundingBox>();
+
+		PLCrossingKernel::Polygon& polygon = res->_polygon;
+		polygon.x = in.readArray<double>().to_vector();
+		polygon.y = in.readArray<double>().to_vector();
+		polygon.z = in.readArray<double>().to_vector();
+		polygon.normal_x = in.readArray<double>().to_vector();
+		polygon.normal_y = in.readArray<double>().to_vector();
+		polygon.normal_z = in.readArray<double>().to_vector();
+
+		const size_t num_edges = polygon.numEdges();
+		bool valid = (coordinates.size() % 2 == 0);
+		valid = valid && polygon.y.size() == polygon.x.size() && polygon.z.size() == polygon.x.size();
+		valid = valid && polygon.normal_y.size() == num_edges && polygon.normal_z.size() == num_edges;
+		valid = valid && (num_edges == 0 ? polygon.x.empty() : polygon.x.size() == num_edges + 1);
+
+		for (ReferencePoint& ref : res->_reference_points){
+			ref.point = in.read<Vector3>();
+			ref.inside = (in.read<uint8_t>() != 0);
+			ref.sides = in.readArray<uint8_t>().to_vector();
+			valid = valid && ref.sides.size() == num_edges;
+		}
+
+		if (!valid){
+			Exception ex;
+			ex << "Invalid data for plate " << plate_id << " in '" << in.getSource() << "'";
+			throw ex;
+		}
+	} catch (...){
+		delete res;
+		throw;
+	}
+
+	return res;
+}
@@ -11,10 +11,15 @@
 #include <string>
 #include <vector>
 #include <iostream>
+#include "PLCrossingKernel.h"
+#include "../util/Vector3.h"
 using namespace std;
 
 namespace paleo_latitude {
 
+class BinaryReader;
+class BinaryWriter;
+
 struct Coordinate {
 	Coordinate(double latitude_, double longitude_) : latitude(latitude_), longitude(longitude_){}
 
@@ -26,6 +31,27 @@ struct Coordinate {
 
 class PLPlate {
 public:
+	/**
+	 * Latitude/longitude bounds of a plate (part). For plates that cross the 180 degree
+	 * meridian, min_longitude will be larger than max_longitude.
+	 */
+	struct BoundingBox {
+		BoundingBox() : min_latitude(90), max_latitude(-90), min_longitude(-180), max_longitude(180) {}
+
+		bool empty() const;
+		bool crossesDateLine() const;
+		bool contains(const Coordinate& site) const;
+
+		string to_string() const;
+
+		double min_latitude, max_latitude;
+		double min_longitude, max_longitude;
+
+		// Written to dataset bundles as is (see IsBinaryPacked)
+		static const bool BINARY_PACKED = true;
+	};
+	static_assert(sizeof(BoundingBox) == 4 * sizeof(double), "Bounding box contains padding");
+
 	PLPlate(unsigned int plate_id, string plate_name, vector<Coordinate>* coordinates);
 	PLPlate() = delete;
 
@@ -34,18 +60,76 @@ public:
 	string getName() const;
 	unsigned int getId() const;
 	const vector<Coordinate>* getCoordinates() const;
+	const BoundingBox& getBoundingBox() const;
+
+	/**
+	 * Whether this is the unconstrained plate (mobile belts), for which no paleolatitude can
+	 * be computed
+	 */
+	bool isUnconstrained() const;
+
+	const static unsigned int UNCONSTRAINED_PLATE_ID;
 
 	bool contains(const PLPlate& other_plate) const;
 	bool contains(const Coordinate& some_point) const;
 
-	void writeKMLPlacemark(ostream& output_stream, string linecolor = "440000ff") const;
+	/**
+	 * Writes the plate as a KML placemark. The placemark is serialised when the plate is
+	 * created, for output streams in their default format and for fixed-point notation with
+	 * 5 decimals (used by PaleoLatitude::writeMachineReadable); streams in any other format
+	 * are written to directly.
+	 */
+	void writeKMLPlacemark(ostream& output_stream, const string& linecolor = "440000ff") const;
+
+	/**
+	 * Writes the plate (including the precomputed data used by #contains) in the binary format
+	 * of dataset bundles, so that it can be restored without recomputing anything
+	 */
+	void writeBinary(BinaryWriter& out) const;
+	static PLPlate* readBinary(BinaryReader& in);
 
 	string _ppCoordinates() const;
 
 private:
+	PLPlate(unsigned int plate_id, string plate_name, vector<Coordinate>* coordinates, bool compute_containment_data);
+
 	const unsigned int _id;
 	const string _name;
 	vector<Coordinate>* _polygon_coordinates;
+	BoundingBox _bounding_box;
+
+	/**
+	 * Point with a known location with respect to this plate, and the side of the great
+	 * circle through each polygon edge it is located on
+	 */
+	struct ReferencePoint {
+		Vector3 point;
+		bool inside = false;
+		vector<uint8_t> sides;
+	};
+
+	/**
+	 * Polygon as unit vectors and great circle edge normals, in the layout used by the
+	 * point-in-polygon kernel
+	 */
+	PLCrossingKernel::Polygon _polygon;
+	ReferencePoint _reference_points[2];
+
+	/**
+	 * Serialised KML placemark: the part before the line colour, and the part after it (with
+	 * the coordinates) in the default format and in fixed-point notation with 5 decimals
+	 */
+	string _kml_head;
+	string _kml_tail;
+	string _kml_tail_fixed;
+
+	void _serialiseKMLPlacemark();
+	const string* _getKMLTail(const ostream& output_stream) const;
+
+	void _computeContainmentData();
+	void _computeBoundingBox();
+	Vector3 _findOutsidePoint() const;
+	Vector3 _findReferencePoint(const Vector3& candidate) const;
 
 	static string _filterPlateName(const string plate_name);
 };
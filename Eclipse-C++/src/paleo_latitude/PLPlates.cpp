@@ -8,28 +8,521 @@
 #include "PLPlates.h"
 
 #include <algorithm>
+#include <array>
+#include <iterator>
 
+#include "../util/BinaryIO.h"
+#include "../util/MappedFile.h"
 #include "../util/Util.h"
 #include "../util/Logger.h"
+#include "../util/Stats.h"
 
-#include "kml/dom.h"
-#include "kml/base/file.h"
-#include "kml/engine.h"
+#include "../util/XMLStreamParser.h"
 
-#include "pugixml.hpp"
-
-#include <boost/algorithm/string.hpp>
+#include <boost/geometry.hpp>
 
 #include "../debugging-macros.h"
 #include "exceptions/PLFileParseException.h"
 #include <set>
+#include <fstream>
+#include <cstring>
+#include <cstdlib>
+#include <memory>
 
-using pugi::xml_document;
 using namespace paleo_latitude;
 using namespace std;
 
 
 const unsigned int PLPlates::PLATE_ID_AFRICA = 701;
+const uint16_t PLPlates::RASTER_EXACT = 0xFFFF;
+const uint16_t PLPlates::RASTER_UNASSIGNED = 0xFFFE;
+const size_t PLPlates::MAX_RASTER_CELLS = 200000000;
+
+// Identifies plate raster files (see #writeRaster)
+static const array<char, 8> RASTER_FILE_MAGIC = { 'P', 'L', 'R', 'A', 'S', 'T', 'E', 'R' };
+static const uint32_t RASTER_FILE_VERSION = 2;
+
+namespace {
+
+/**
+ * Splits character data, which may be reported in several parts, into whitespace-separated
+ * tokens. Tokens that lie within a single part are passed on without copying them.
+ */
+class TokenSplitter {
+public:
+	template<class Handler> void feed(const char* data, size_t length, Handler handle_token){
+		const char* pos = data;
+		const char* end = data + length;
+
+		while (pos < end){
+			if (_isSpace(*pos)){
+				if (!_partial.empty()){
+					handle_token(_partial.data(), _partial.size());
+					_partial.clear();
+				}
+				pos++;
+				continue;
+			}
+
+			const char* token_end = pos;
+			while (token_end < end && !_isSpace(*token_end)) token_end++;
+
+			if (token_end == end){
+				// Token might continue in the next part
+				_partial.append(pos, token_end);
+			} else if (_partial.empty()){
+				handle_token(pos, token_end - pos);
+			} else {
+				_partial.append(pos, token_end);
+				handle_token(_partial.data(), _partial.size());
+				_partial.clear();
+			}
+			pos = token_end;
+		}
+	}
+
+	template<class Handler> void finish(Handler handle_token){
+		if (!_partial.empty()) handle_token(_partial.data(), _partial.size());
+		_partial.clear();
+	}
+
+private:
+	static bool _isSpace(char c){
+		return (c == ' ' || c == '\t' || c == '\n' || c == '\r');
+	}
+
+	string _partial;
+};
+
+/**
+ * Reads plates from a GPML file in a single pass (see PLPlates::_readPlatesFromGPML() for the
+ * structure of the file). The name and polygon of a plate are taken from the first <gml:name>
+ * and <gml:posList> elements of the feature that holds its plate ID. Plates are added when the
+ * feature is closed, as these elements may appear before or after the plate ID.
+ */
+class GPMLPlatesReader : public XMLStreamParser {
+public:
+	GPMLPlatesReader(vector<const PLPlate*>& plates) : _plates(plates) {}
+
+protected:
+	void startElement(const char* name, const char** attributes) override {
+		const Tag tag = _getTag(name);
+		const Tag parent = _parentTag(0);
+		const Tag grandparent = _parentTag(1);
+		_tags.push_back(tag);
+
+		switch (tag){
+		case UNCLASSIFIED_FEATURE:
+		case CONTINENTAL_FRAGMENT:
+		case DISPLACEMENT_POINT:
+			_features.push_back(Feature());
+			_features.back().type = tag;
+			break;
+
+		case CONSTANT_VALUE:
+			if (parent == RECONSTRUCTION_PLATE_ID){
+				// <gpml:reconstructionPlateId><gpml:ConstantValue>
+				_in_plate_id = true;
+				_plate_id_has_value = false;
+				_plate_id_is_plate_id = false;
+				_plate_id_value.clear();
+			}
+			break;
+
+		case VALUE:
+		case VALUE_TYPE:
+			if (_in_plate_id && parent == CONSTANT_VALUE && grandparent == RECONSTRUCTION_PLATE_ID) _captureText();
+			break;
+
+		case NAME:
+			if (_featureWithout(&Feature::has_name)) _captureText();
+			break;
+
+		case POS_LIST:
+			if (_featureWithout(&Feature::has_pos_list)){
+				_pos_list.reset(new vector<Coordinate>());
+				_pos_list_has_latitude = false;
+				_parsing_pos_list = true;
+			}
+			break;
+
+		default:
+			break;
+		}
+	}
+
+	void endElement(const char* name) override {
+		const Tag tag = _tags.back();
+		const bool captured = (_capture_depth == _tags.size());
+		_tags.pop_back();
+		if (captured) _capture_depth = 0;
+
+		switch (tag){
+		case UNCLASSIFIED_FEATURE:
+		case CONTINENTAL_FRAGMENT:
+		case DISPLACEMENT_POINT:
+			_addPlates(_features.back());
+			_features.pop_back();
+			break;
+
+		case CONSTANT_VALUE:
+			if (_in_plate_id && _parentTag(0) == RECONSTRUCTION_PLATE_ID){
+				_in_plate_id = false;
+				if (_plate_id_is_plate_id) _addPlateId(_plate_id_value);
+			}
+			break;
+
+		case VALUE:
+			if (captured && !_plate_id_has_value){
+				_plate_id_value = _text;
+				_plate_id_has_value = true;
+			}
+			break;
+
+		case VALUE_TYPE:
+			if (captured && _text == "gpml:plateId") _plate_id_is_plate_id = true;
+			break;
+
+		case NAME:
+			if (captured){
+				for (Feature& feature : _features){
+					if (feature.has_name) continue;
+					feature.name = _text;
+					feature.has_name = true;
+				}
+			}
+			break;
+
+		case POS_LIST:
+			if (_parsing_pos_list){
+				_splitter.finish([this](const char* token, size_t length){ _addPosListToken(token, length); });
+				_parsing_pos_list = false;
+
+				// Usually a single feature is waiting for a polygon; nested features (rare) get a copy
+				Feature* last_feature = NULL;
+				for (Feature& feature : _features){
+					if (feature.has_pos_list) continue;
+					if (last_feature != NULL) last_feature->coordinates.reset(new vector<Coordinate>(*_pos_list));
+					last_feature = &feature;
+					feature.has_pos_list = true;
+				}
+				last_feature->coordinates = move(_pos_list);
+			}
+			break;
+
+		default:
+			break;
+		}
+	}
+
+	void characterData(const char* data, size_t length) override {
+		if (_capture_depth == _tags.size()){
+			_text.append(data, length);
+		} else if (_parsing_pos_list && _tags.back() == POS_LIST){
+			_splitter.feed(data, length, [this](const char* token, size_t length){ _addPosListToken(token, length); });
+		}
+	}
+
+private:
+	enum Tag { OTHER, UNCLASSIFIED_FEATURE, CONTINENTAL_FRAGMENT, DISPLACEMENT_POINT, RECONSTRUCTION_PLATE_ID, CONSTANT_VALUE, VALUE, VALUE_TYPE, NAME, POS_LIST };
+
+	struct Feature {
+		Tag type = OTHER;
+		vector<string> plate_ids;		// in order of appearance
+		bool has_name = false;
+		string name;
+		bool has_pos_list = false;
+		unique_ptr<vector<Coordinate> > coordinates;
+	};
+
+	static Tag _getTag(const char* name){
+		if (strcmp(name, "gpml:UnclassifiedFeature") == 0) return UNCLASSIFIED_FEATURE;
+		if (strcmp(name, "gpml:ContinentalFragment") == 0) return CONTINENTAL_FRAGMENT;
+		if (strcmp(name, "gpml:DisplacementPoint") == 0) return DISPLACEMENT_POINT;
+		if (strcmp(name, "gpml:reconstructionPlateId") == 0) return RECONSTRUCTION_PLATE_ID;
+		if (strcmp(name, "gpml:ConstantValue") == 0) return CONSTANT_VALUE;
+		if (strcmp(name, "gpml:value") == 0) return VALUE;
+		if (strcmp(name, "gpml:valueType") == 0) return VALUE_TYPE;
+		if (strcmp(name, "gml:name") == 0) return NAME;
+		if (strcmp(name, "gml:posList") == 0) return POS_LIST;
+		return OTHER;
+	}
+
+	/**
+	 * Returns the tag of the n-th open element, counting from the innermost one (0)
+	 */
+	Tag _parentTag(size_t n) const {
+		return (_tags.size() > n) ? _tags[_tags.size() - 1 - n] : OTHER;
+	}
+
+	bool _featureWithout(bool Feature::*flag) const {
+		for (const Feature& feature : _features){
+			if (!(feature.*flag)) return true;
+		}
+		return false;
+	}
+
+	void _captureText(){
+		_text.clear();
+		_capture_depth = _tags.size();
+	}
+
+	void _addPosListToken(const char* token, size_t length){
+		// Coordinates are separated by spaces, latitude first
+		double value = 0;
+		if (!Util::string_to_something(string_view(token, length), value)) throw PLFileParseException("Error parsing coordinate: " + string(token, length));
+
+		if (_pos_list_has_latitude){
+			_pos_list->push_back(Coordinate(_pos_list_latitude, value));
+		} else {
+			_pos_list_latitude = value;
+		}
+		_pos_list_has_latitude = !_pos_list_has_latitude;
+	}
+
+	/**
+	 * Assigns a plate ID to the feature it belongs to: the (outermost) enclosing
+	 * <gpml:UnclassifiedFeature>, or <gpml:ContinentalFragment> or <gpml:DisplacementPoint>
+	 * if there is none.
+	 */
+	void _addPlateId(const string& plate_id_str){
+		for (Tag type : { UNCLASSIFIED_FEATURE, CONTINENTAL_FRAGMENT, DISPLACEMENT_POINT }){
+			for (Feature& feature : _features){
+				if (feature.type != type) continue;
+				feature.plate_ids.push_back(plate_id_str);
+				return;
+			}
+		}
+
+		Logger::logWarn("Could not find name and polygon definition for plate '" + plate_id_str + "' in GPML file (missing <gpml:UnclassifiedFeature> ancestor) - ignoring plate");
+	}
+
+	void _addPlates(Feature& feature){
+		for (unsigned int i = 0; i < feature.plate_ids.size(); i++){
+			const string& plate_id_str = feature.plate_ids[i];
+			const unsigned int plate_id = strtoul(plate_id_str.c_str(), NULL, 10);
+
+			if (!feature.has_name){
+				Logger::logWarn("Could not find name for plate '" + plate_id_str + "' in GPML file (missing <gml:name> element) - ignoring plate");
+				continue;
+			}
+
+			if (!feature.has_pos_list){
+				Logger::logWarn("Could not find polygon definition for plate '" + feature.name + "' (id: " + plate_id_str + ") in GPML file (missing <gml:posList> element) - ignoring plate");
+				continue;
+			}
+
+			// Plates with the same feature (rare) each get a copy of the polygon
+			vector<Coordinate>* poly_coords = (i + 1 == feature.plate_ids.size()) ? feature.coordinates.release() : new vector<Coordinate>(*feature.coordinates);
+			_plates.push_back(new PLPlate(plate_id, feature.name, poly_coords));
+		}
+	}
+
+	vector<const PLPlate*>& _plates;
+
+	vector<Tag> _tags;				// open elements
+	vector<Feature> _features;		// open features
+
+	string _text;
+	size_t _capture_depth = 0;		// depth of the element of which the text is captured (0: none)
+
+	bool _in_plate_id = false;
+	bool _plate_id_has_value = false;
+	bool _plate_id_is_plate_id = false;
+	string _plate_id_value;
+
+	bool _parsing_pos_list = false;
+	bool _pos_list_has_latitude = false;
+	double _pos_list_latitude = 0;
+	unique_ptr<vector<Coordinate> > _pos_list;
+	TokenSplitter _splitter;
+};
+
+/**
+ * Reads plates from a KML file in a single pass: every polygon of a <Placemark> (directly or in
+ * a <MultiGeometry>) becomes a plate part. The plate ID is taken from the 'PLATEID1' field of the
+ * placemark's <SimpleData>. Plates are added when the placemark is closed.
+ */
+class KMLPlatesReader : public XMLStreamParser {
+public:
+	KMLPlatesReader(vector<const PLPlate*>& plates) : _plates(plates) {}
+
+protected:
+	void startElement(const char* name, const char** attributes) override {
+		const Tag tag = _getTag(name);
+		const Tag parent = _parentTag(0);
+		const Tag grandparent = _parentTag(1);
+		const Tag great_grandparent = _parentTag(2);
+		_tags.push_back(tag);
+
+		switch (tag){
+		case PLACEMARK:
+			_in_placemark = true;
+			_placemark_name.clear();
+			_placemark_has_plate_id = false;
+			_placemark_plate_id.clear();
+			_placemark_polygons.clear();
+			break;
+
+		case NAME:
+			if (parent == PLACEMARK) _captureText();
+			break;
+
+		case SIMPLE_DATA:
+			if (_in_placemark && !_placemark_has_plate_id){
+				const char* field_name = getAttribute(attributes, "name");
+				if (field_name != NULL && strcmp(field_name, "PLATEID1") == 0) _captureText();
+			}
+			break;
+
+		case POLYGON:
+			_polygon_accepted = (parent == PLACEMARK || (parent == MULTI_GEOMETRY && grandparent == PLACEMARK));
+			if (!_polygon_accepted) Logger::logWarn("Ignoring polygon - does not have parent Placemark");
+			_polygon.reset();
+			break;
+
+		case COORDINATES:
+			if (_polygon_accepted && !_polygon && parent == LINEAR_RING && grandparent == OUTER_BOUNDARY_IS && great_grandparent == POLYGON){
+				_polygon.reset(new vector<Coordinate>());
+				_parsing_coordinates = true;
+			}
+			break;
+
+		default:
+			break;
+		}
+	}
+
+	void endElement(const char* name) override {
+		const Tag tag = _tags.back();
+		const bool captured = (_capture_depth == _tags.size());
+		_tags.pop_back();
+		if (captured) _capture_depth = 0;
+
+		switch (tag){
+		case PLACEMARK:
+			_addPlates();
+			_in_placemark = false;
+			break;
+
+		case NAME:
+			if (captured) _placemark_name = _text;
+			break;
+
+		case SIMPLE_DATA:
+			if (captured){
+				_placemark_plate_id = _text;
+				_placemark_has_plate_id = true;
+			}
+			break;
+
+		case POLYGON:
+			if (_polygon_accepted){
+				if (_polygon){
+					_placemark_polygons.push_back(move(_polygon));
+				} else {
+					Logger::logWarn("Ignoring polygon - does not have an outer boundary");
+				}
+			}
+			_polygon_accepted = false;
+			break;
+
+		case COORDINATES:
+			if (_parsing_coordinates){
+				_splitter.finish([this](const char* token, size_t length){ _addCoordinatesToken(token, length); });
+				_parsing_coordinates = false;
+			}
+			break;
+
+		default:
+			break;
+		}
+	}
+
+	void characterData(const char* data, size_t length) override {
+		if (_capture_depth == _tags.size()){
+			_text.append(data, length);
+		} else if (_parsing_coordinates && _tags.back() == COORDINATES){
+			_splitter.feed(data, length, [this](const char* token, size_t length){ _addCoordinatesToken(token, length); });
+		}
+	}
+
+private:
+	enum Tag { OTHER, PLACEMARK, NAME, SIMPLE_DATA, MULTI_GEOMETRY, POLYGON, OUTER_BOUNDARY_IS, LINEAR_RING, COORDINATES };
+
+	static Tag _getTag(const char* name){
+		if (strcmp(name, "Placemark") == 0) return PLACEMARK;
+		if (strcmp(name, "name") == 0) return NAME;
+		if (strcmp(name, "SimpleData") == 0) return SIMPLE_DATA;
+		if (strcmp(name, "MultiGeometry") == 0) return MULTI_GEOMETRY;
+		if (strcmp(name, "Polygon") == 0) return POLYGON;
+		if (strcmp(name, "outerBoundaryIs") == 0) return OUTER_BOUNDARY_IS;
+		if (strcmp(name, "LinearRing") == 0) return LINEAR_RING;
+		if (strcmp(name, "coordinates") == 0) return COORDINATES;
+		return OTHER;
+	}
+
+	Tag _parentTag(size_t n) const {
+		return (_tags.size() > n) ? _tags[_tags.size() - 1 - n] : OTHER;
+	}
+
+	void _captureText(){
+		_text.clear();
+		_capture_depth = _tags.size();
+	}
+
+	void _addCoordinatesToken(const char* token, size_t length){
+		// Tuples are separated by whitespace: longitude,latitude[,altitude]
+		const char* comma = static_cast<const char*>(memchr(token, ',', length));
+		double lon = 0, lat = 0;
+
+		if (comma == NULL || !Util::string_to_something(string_view(token, comma - token), lon) || !Util::string_to_something(string_view(comma + 1, length - (comma + 1 - token)), lat)){
+			throw PLFileParseException("Error parsing coordinate: " + string(token, length));
+		}
+
+		_polygon->push_back(Coordinate(lat, lon));
+	}
+
+	void _addPlates(){
+		unsigned int plate_id = 0;
+
+		for (unique_ptr<vector<Coordinate> >& polygon : _placemark_polygons){
+			if (_placemark_has_plate_id && !Util::string_to_something(_placemark_plate_id, plate_id)){
+				Logger::logWarn("Ignoring plate '" + _placemark_name + "': unable to parse plate ID");
+				plate_id = 0;
+			}
+
+			if (plate_id == 0){
+				Logger::logWarn("Ignoring plate '" + _placemark_name + "': unable to determine plate ID");
+				continue;
+			}
+
+			_plates.push_back(new PLPlate(plate_id, _placemark_name, polygon.release()));
+		}
+
+		_placemark_polygons.clear();
+	}
+
+	vector<const PLPlate*>& _plates;
+
+	vector<Tag> _tags;				// open elements
+
+	string _text;
+	size_t _capture_depth = 0;		// depth of the element of which the text is captured (0: none)
+
+	bool _in_placemark = false;
+	string _placemark_name;
+	bool _placemark_has_plate_id = false;
+	string _placemark_plate_id;
+	vector<unique_ptr<vector<Coordinate> > > _placemark_polygons;
+
+	bool _polygon_accepted = false;
+	unique_ptr<vector<Coordinate> > _polygon;
+	bool _parsing_coordinates = false;
+	TokenSplitter _splitter;
+};
+
+};
 
 
 PLPlates::PLPlates() {}
@@ -41,131 +534,266 @@ PLPlates::~PLPlates() {
 }
 
 PLPlates* PLPlates::readFromFile(const string& filename) {
+	const Stats::Timer timer(Stats::PARSE_PLATES);
+
 	PLPlates* res = new PLPlates();
 
-	if (Util::string_ends_with(filename, ".kml")){
-		res->_readPlatesFromKML(filename);
-	} else if (Util::string_ends_with(filename, ".gpml")){
-		res->_readPlatesFromGPML(filename);
-	} else {
-		throw PLFileParseException("Unsupported file format (expecting .kml or .gpml): " + filename);
+	try {
+		if (Util::string_ends_with(filename, ".kml")){
+			res->_readPlatesFromKML(filename);
+		} else if (Util::string_ends_with(filename, ".gpml")){
+			res->_readPlatesFromGPML(filename);
+		} else {
+			throw PLFileParseException("Unsupported file format (expecting .kml or .gpml): " + filename);
+		}
+	} catch (...){
+		delete res;
+		throw;
 	}
 
+	res->_buildIndex();
+	res->_buildContainmentHierarchy();
+
 	return res;
 }
 
+void paleo_latitude::PLPlates::writeBinary(BinaryWriter& out) const {
+	out.write<uint32_t>(_plates.size());
+	for (const PLPlate* plate : _plates) plate->writeBinary(out);
+	for (const vector<unsigned int>& contained : _contained_parts) out.writeArray(contained);
 
-void paleo_latitude::PLPlates::_readPlatesFromKML(const string& kml_filename) {
-	// Read plates.kml
-	string kml_data;
+	out.write(_raster_rows);
+	out.write(_raster_cols);
+	out.writeArray(_raster);
+}
 
-	Logger::logInfo("Reading plate coordinate data from KML file " + kml_filename + "...");
-	if (!kmlbase::File::ReadFileToString(kml_filename, &kml_data)){
-		PLFileParseException plfe;
-		plfe << "Error importing plate polygons from KML file: read failed (" << kml_filename << ")";
-		throw plfe;
+PLPlates* PLPlates::readBinary(BinaryReader& in) {
+	PLPlates* res = new PLPlates();
+
+	try {
+		const uint32_t num_plates = in.read<uint32_t>();
+		for (uint32_t i = 0; i < num_plates; i++) res->_plates.push_back(PLPlate::readBinary(in));
+
+		res->_contained_parts.resize(num_plates);
+		for (vector<unsigned int>& contained : res->_contained_parts){
+			contained = in.readArray<unsigned int>().to_vector();
+			for (unsigned int part : contained){
+				if (part >= num_plates) throw Exception("Invalid plate containment hierarchy in '" + in.getSource() + "'");
+			}
+		}
+
+		const uint32_t raster_rows = in.read<uint32_t>();
+		const uint32_t raster_cols = in.read<uint32_t>();
+		const ArrayView<uint16_t> raster = in.readArray<uint16_t>();
+
+		if (raster.size() != static_cast<size_t>(raster_rows) * raster_cols || raster_cols != 2 * raster_rows){
+			throw Exception("Invalid plate raster in '" + in.getSource() + "'");
+		}
+
+		for (uint16_t value : raster){
+			if (value != RASTER_EXACT && value >= num_plates) throw Exception("Invalid plate raster in '" + in.getSource() + "'");
+		}
+
+		res->_raster = raster.to_vector();
+		res->_raster_rows = raster_rows;
+		res->_raster_cols = raster_cols;
+	} catch (...){
+		delete res;
+		throw;
 	}
 
-	Logger::logInfo("Parsing plate data...");
-	string kml_parse_errors;
-	kmldom::ElementPtr kml_root_elem = kmldom::Parse(kml_data, &kml_parse_errors);
+	res->_buildIndex();
+	return res;
+}
+
+void paleo_latitude::PLPlates::_readPlatesFromKML(const string& kml_filename) {
+	Logger::logInfo("Reading plate coordinate data from KML file " + kml_filename + "...");
 
-	if (kml_root_elem.get() == NULL){
+	KMLPlatesReader reader(_plates);
+	try {
+		reader.parseFile(kml_filename);
+	} catch (const PLFileParseException&){
+		throw;
+	} catch (const Exception& ex){
 		PLFileParseException plfe;
-		plfe << "Error reading polygons from KML file: " << kml_parse_errors << " (" << kml_filename << ")";
+		plfe << "Error reading polygons from KML file: " << ex.what() << " (" << kml_filename << ")";
 		throw plfe;
 	}
+}
 
-	kmlengine::ElementVector kml_polygons;
-	kmlengine::GetElementsById(kml_root_elem, kmldom::Type_Polygon, &kml_polygons);
 
-	// Iterate over all plates:
-	for (unsigned int p = 0; p < kml_polygons.size(); p++){
-		const kmldom::PolygonPtr polygon = kmldom::AsPolygon(kml_polygons[p]);
+const PLPlate* paleo_latitude::PLPlates::findPlate(double lat, double lon) const {
+	return findPlate(Coordinate(lat, lon));
+}
 
-		const kmldom::ElementPtr polygon_parent = polygon->GetParent();
+/**
+ * Builds the spatial index over the bounding boxes of the plate parts. Bounding boxes that
+ * cross the 180 degree meridian are inserted as two separate boxes.
+ */
+void paleo_latitude::PLPlates::_buildIndex() {
+	_index.clear();
 
-		kmldom::PlacemarkPtr placemark;
-		if (polygon_parent->IsA(kmldom::Type_Placemark)){
-			placemark = kmldom::AsPlacemark(polygon_parent);
-		} else if (polygon_parent->IsA(kmldom::Type_MultiGeometry)){
-			const kmldom::MultiGeometryPtr mgeom = kmldom::AsMultiGeometry(polygon_parent);
-			placemark = kmldom::AsPlacemark(mgeom->GetParent());
+	for (unsigned int i = 0; i < _plates.size(); i++){
+		for (const IndexBox& box : _indexBoxes(_plates[i]->getBoundingBox())){
+			_index.insert(make_pair(box, i));
 		}
+	}
+}
 
-		if (placemark.get() == NULL){
-			Logger::logWarn("Ignoring polygon - does not have parent Placemark");
-			continue;
-		}
+/**
+ * Returns the box(es) in lon/lat space covered by a bounding box: two boxes if it crosses
+ * the 180 degree meridian, none if it's empty.
+ */
+vector<paleo_latitude::PLPlates::IndexBox> paleo_latitude::PLPlates::_indexBoxes(const PLPlate::BoundingBox& bbox) {
+	vector<IndexBox> res;
+	if (bbox.empty()) return res;
 
-		const string plate_name = placemark->get_name();
+	if (bbox.crossesDateLine()){
+		res.push_back(IndexBox(IndexPoint(bbox.min_longitude, bbox.min_latitude), IndexPoint(180, bbox.max_latitude)));
+		res.push_back(IndexBox(IndexPoint(-180, bbox.min_latitude), IndexPoint(bbox.max_longitude, bbox.max_latitude)));
+	} else {
+		res.push_back(IndexBox(IndexPoint(bbox.min_longitude, bbox.min_latitude), IndexPoint(bbox.max_longitude, bbox.max_latitude)));
+	}
+	return res;
+}
 
-		kmlengine::ElementVector simpledata_fields;
-		kmlengine::GetElementsById(placemark, kmldom::Type_SimpleData, &simpledata_fields);
+/**
+ * Determines which plate parts are located within other plate parts, so that #findPlate can
+ * resolve sites on nested plates without repeating the (expensive) polygon-in-polygon test.
+ * Only pairs of parts with overlapping bounding boxes need to be tested.
+ */
+void paleo_latitude::PLPlates::_buildContainmentHierarchy() {
+	// Not part of any plate lookup
+	const Stats::Pause pause;
 
-		unsigned int plate_id = 0;
-		string plate_id_str;
+	_contained_parts.assign(_plates.size(), vector<unsigned int>());
 
-		for (unsigned int s = 0; s < simpledata_fields.size(); s++){
-			const kmldom::SimpleDataPtr sdata = kmldom::AsSimpleData(simpledata_fields[s]);
-			if (sdata->get_name() == "PLATEID1"){
-				plate_id_str = sdata->get_text();
+	for (unsigned int inner = 0; inner < _plates.size(); inner++){
+		vector<IndexValue> overlapping;
+		for (const IndexBox& box : _indexBoxes(_plates[inner]->getBoundingBox())){
+			_index.query(boost::geometry::index::intersects(box), back_inserter(overlapping));
+		}
 
-				if (!Util::string_to_something(plate_id_str, plate_id)){
-					Logger::logWarn("Ignoring plate '" + plate_name + "': unable to parse plate ID");
-					plate_id = 0;
-				}
+		for (const IndexValue& match : overlapping){
+			const unsigned int outer = match.second;
+			if (outer == inner || _partContains(outer, inner)) continue;
 
-				break;
+			if (_plates[outer]->contains(*_plates[inner])){
+				_contained_parts[outer].push_back(inner);
+				sort(_contained_parts[outer].begin(), _contained_parts[outer].end());
 			}
 		}
+	}
+}
 
-		if (plate_id == 0){
-			Logger::logWarn("Ignoring plate '" + plate_name + "': unable to determine plate ID");
-			continue;
-		}
+bool paleo_latitude::PLPlates::_partContains(unsigned int outer, unsigned int inner) const {
+	const vector<unsigned int>& contained = _contained_parts[outer];
+	return binary_search(contained.begin(), contained.end(), inner);
+}
 
-		kmldom::OuterBoundaryIsPtr boundary = polygon->get_outerboundaryis();
-		kmldom::LinearRingPtr ring = boundary->get_linearring();
-		kmldom::CoordinatesPtr kml_plate_coords = ring->get_coordinates();
+/**
+ * Returns the indices (in _plates, in ascending order) of the plate parts whose bounding box
+ * covers the site. Only these plates can possibly contain the site.
+ */
+vector<unsigned int> paleo_latitude::PLPlates::_findCandidatePlates(const Coordinate& site) const {
+	vector<IndexValue> matches;
+	_index.query(boost::geometry::index::intersects(IndexPoint(site.longitude, site.latitude)), back_inserter(matches));
 
-		const unsigned int num_coords = kml_plate_coords->get_coordinates_array_size();
+	vector<unsigned int> res;
+	res.reserve(matches.size());
+	for (const IndexValue& match : matches) res.push_back(match.second);
 
-		vector<Coordinate>* poly_coords = new vector<Coordinate>();
-		poly_coords->reserve(num_coords);
+	// Keep the order of the input data, and remove duplicates (sites on the 180 degree meridian)
+	sort(res.begin(), res.end());
+	res.erase(unique(res.begin(), res.end()), res.end());
+	return res;
+}
 
-		for (unsigned int c = 0; c < num_coords; c++){
-			kmlbase::Vec3 coords_tuple = kml_plate_coords->get_coordinates_array_at(c);
-			poly_coords->push_back(Coordinate(coords_tuple.get_latitude(), coords_tuple.get_longitude()));
-		}
+const PLPlate* paleo_latitude::PLPlates::findPlate(const Coordinate& site) const {
+	const Stats::Timer timer(Stats::FIND_PLATE);
 
-		PLPlate* plate = new PLPlate(plate_id, plate_name, poly_coords);
-		_plates.push_back(plate);
+	if (!_raster.empty()){
+		// Most sites are not near a plate boundary, and can be resolved using the raster
+		const uint16_t cell_value = _raster[_rasterCell(site.latitude, site.longitude)];
+		if (cell_value != RASTER_EXACT) return _plates[cell_value];
 	}
+
+	return _findPlateExact(site);
 }
 
+void paleo_latitude::PLPlates::findPlates(const vector<Coordinate>& sites, vector<const PLPlate*>& result, vector<string>* errors) const {
+	result.assign(sites.size(), NULL);
+	if (errors != NULL) errors->assign(sites.size(), "");
 
-const PLPlate* paleo_latitude::PLPlates::findPlate(double lat, double lon) const {
-	return findPlate(Coordinate(lat, lon));
+	vector<pair<uint32_t, size_t> > order;
+	order.reserve(sites.size());
+	for (size_t i = 0; i < sites.size(); i++){
+		order.push_back(make_pair(_mortonKey(sites[i]), i));
+	}
+	sort(order.begin(), order.end());
+
+	for (size_t k = 0; k < order.size(); k++){
+		const size_t i = order[k].second;
+		const Coordinate& site = sites[i];
+
+		// Field data often contains many samples from the same site, which end up next to
+		// each other after sorting
+		if (k > 0){
+			const size_t prev = order[k - 1].second;
+			if (sites[prev].latitude == site.latitude && sites[prev].longitude == site.longitude){
+				result[i] = result[prev];
+				if (errors != NULL) (*errors)[i] = (*errors)[prev];
+				continue;
+			}
+		}
+
+		try {
+			result[i] = findPlate(site);
+		} catch (Exception& ex){
+			if (errors != NULL) (*errors)[i] = ex.what();
+		}
+	}
 }
 
-const PLPlate* paleo_latitude::PLPlates::findPlate(const Coordinate& site) const {
+/**
+ * Returns the position of a site on a Morton (Z-order) curve: latitude and longitude are
+ * quantised to 16 bits each, and the bits are interleaved.
+ */
+uint32_t paleo_latitude::PLPlates::_mortonKey(const Coordinate& site) {
+	const double lat = min(1.0, max(0.0, (site.latitude + 90) / 180));
+	const double lon = min(1.0, max(0.0, (site.longitude + 180) / 360));
+
+	// Spread the 16 bits of a value over the even bits of a 32 bit value
+	auto spread = [](uint32_t value){
+		value = (value | (value << 8)) & 0x00FF00FF;
+		value = (value | (value << 4)) & 0x0F0F0F0F;
+		value = (value | (value << 2)) & 0x33333333;
+		value = (value | (value << 1)) & 0x55555555;
+		return value;
+	};
+
+	return (spread((uint32_t)(lat * 0xFFFF)) << 1) | spread((uint32_t)(lon * 0xFFFF));
+}
+
+const PLPlate* paleo_latitude::PLPlates::_findPlateExact(const Coordinate& site) const {
 	const PLPlate* res = NULL;
+	unsigned int res_index = 0;
 
-	for (const PLPlate* plate : _plates){
+	for (unsigned int candidate : _findCandidatePlates(site)){
+		const PLPlate* plate = _plates[candidate];
 		if (plate->contains(site)){
 			if (res != NULL){
 				// Already found a plate that contains this point? In exceptional circumstances,
-				// a plate is contained by another plate. In such a situation, check whether
-				// that is the case, and if so, use the most specific plate available.
+				// a plate is contained by another plate. In such a situation, use the most
+				// specific plate available (according to the containment hierarchy).
 
-				if (res->contains(*plate)){
+				if (_partContains(res_index, candidate)){
 					// This plate is fully contained in the previously found plate. Use
 					// this plate instead.
-					res = plate;
-				} else if (plate->contains(*res)){
+				} else if (_partContains(candidate, res_index)){
 					// This plate fully contains the previously found plate. Keep the
 					// previous plate as result
+					continue;
 				} else {
 					// Neither contains the other. That means that plates are
 					// overlapping at the provided coordinate.
@@ -175,6 +803,7 @@ const PLPlate* paleo_latitude::PLPlates::findPlate(const Coordinate& site) const
 				}
 			}
 			res = plate;
+			res_index = candidate;
 		}
 	}
 
@@ -187,6 +816,283 @@ const PLPlate* paleo_latitude::PLPlates::findPlate(const Coordinate& site) const
 	return res;
 }
 
+void paleo_latitude::PLPlates::enableRaster(double resolution, const string& raster_filename) {
+	validateRasterResolution(resolution);
+	const unsigned int expected_rows = max(1l, lround(180.0 / resolution));
+
+	// Raster may already be available (e.g. when the plates were restored from a dataset bundle)
+	if (!_raster.empty() && _raster_rows == expected_rows) return;
+
+	if (!raster_filename.empty() && readRaster(raster_filename)){
+		if (_raster_rows == expected_rows) return;
+
+		Logger::logInfo("Plate raster in '" + raster_filename + "' has a different resolution than requested - rebuilding raster");
+	}
+
+	buildRaster(resolution);
+	if (!raster_filename.empty()) writeRaster(raster_filename);
+}
+
+void paleo_latitude::PLPlates::validateRasterResolution(double resolution) {
+	if (!(resolution > 0 && resolution <= 90)){
+		Exception ex;
+		ex << "Invalid plate raster resolution: " << resolution << " (expecting a cell size in degrees, in (0,90])";
+		throw ex;
+	}
+
+	const double rows = max(1.0, round(180.0 / resolution));
+	if (2 * rows * rows > MAX_RASTER_CELLS){
+		Exception ex;
+		ex << "Invalid plate raster resolution: " << resolution << " (cell size too small: the raster would have more than "
+				<< MAX_RASTER_CELLS << " cells, expecting at least " << (180.0 / floor(sqrt(MAX_RASTER_CELLS / 2.0))) << " degrees)";
+		throw ex;
+	}
+}
+
+bool paleo_latitude::PLPlates::hasRaster() const {
+	return !_raster.empty();
+}
+
+/**
+ * Returns the index of the raster cell that covers the provided coordinate
+ */
+size_t paleo_latitude::PLPlates::_rasterCell(double lat, double lon) const {
+	long row = static_cast<long>(floor((lat + 90.0) * _raster_rows / 180.0));
+	long col = static_cast<long>(floor((lon + 180.0) * _raster_cols / 360.0));
+
+	row = max(0l, min(row, static_cast<long>(_raster_rows) - 1));
+	col = ((col % _raster_cols) + _raster_cols) % _raster_cols;
+
+	return static_cast<size_t>(row) * _raster_cols + col;
+}
+
+/**
+ * Marks all raster cells crossed by the great circle segment between two points (and the
+ * cells surrounding them) as cells that require the exact test. The segment is split in
+ * halves until both end points are in the same or in adjacent cells.
+ */
+void paleo_latitude::PLPlates::_rasteriseSegment(const Vector3& from, const Vector3& to, unsigned int depth) {
+	const size_t cell_from = _rasterCell(from.latitude(), from.longitude());
+	const size_t cell_to = _rasterCell(to.latitude(), to.longitude());
+
+	const long row_from = cell_from / _raster_cols, col_from = cell_from % _raster_cols;
+	const long row_to = cell_to / _raster_cols, col_to = cell_to % _raster_cols;
+	const long row_diff = abs(row_from - row_to);
+	const long col_diff = min(abs(col_from - col_to), static_cast<long>(_raster_cols) - abs(col_from - col_to));
+
+	const Vector3 mid = from + to;
+	if ((row_diff > 1 || col_diff > 1) && depth < 48 && mid.norm() > 1e-9){
+		const Vector3 mid_unit = mid.normalised();
+		_rasteriseSegment(from, mid_unit, depth + 1);
+		_rasteriseSegment(mid_unit, to, depth + 1);
+		return;
+	}
+
+	// Mark the cells of both end points, and the cells in between (when the end points are in
+	// diagonally adjacent cells), including their neighbours
+	for (long row : { row_from, row_to }){
+		for (long col : { col_from, col_to }){
+			for (long d_row = -1; d_row <= 1; d_row++){
+				const long r = row + d_row;
+				if (r < 0 || r >= static_cast<long>(_raster_rows)) continue;
+
+				for (long d_col = -1; d_col <= 1; d_col++){
+					const long c = (col + d_col + _raster_cols) % _raster_cols;
+					_raster[r * _raster_cols + c] = RASTER_EXACT;
+				}
+			}
+		}
+	}
+}
+
+/**
+ * Builds the plate raster. First, all cells near plate boundaries are marked as cells that
+ * require the exact test. The remaining cells form connected regions that are not crossed
+ * by any plate boundary, so every region is covered by a single plate: the exact test only
+ * needs to be carried out once per region.
+ */
+void paleo_latitude::PLPlates::buildRaster(double resolution) {
+	validateRasterResolution(resolution);
+
+	if (_plates.size() >= RASTER_UNASSIGNED){
+		throw Exception("Too many plates to build plate raster");
+	}
+
+	// Make sure the exact test is used while building the raster (without recording these
+	// lookups as plate lookups)
+	_raster.clear();
+	const Stats::Pause pause;
+
+	_raster_rows = max(1l, lround(180.0 / resolution));
+	_raster_cols = 2 * _raster_rows;
+	vector<uint16_t> raster(static_cast<size_t>(_raster_rows) * _raster_cols, RASTER_UNASSIGNED);
+	_raster.swap(raster);
+
+	stringstream ss_info;
+	ss_info << "Building plate raster (" << _raster_rows << "x" << _raster_cols << " cells)...";
+	Logger::logInfo(ss_info.str());
+
+	for (const PLPlate* plate : _plates){
+		const vector<Coordinate>& coords = *plate->getCoordinates();
+		for (unsigned int i = 0; i < coords.size(); i++){
+			const Coordinate& curr = coords[i];
+			const Coordinate& next = coords[(i+1) % coords.size()];
+			_rasteriseSegment(Vector3::fromLatLon(curr.latitude, curr.longitude), Vector3::fromLatLon(next.latitude, next.longitude), 0);
+		}
+	}
+
+	// Flood fill regions of unassigned cells
+	const double cell_size = 180.0 / _raster_rows;
+	unsigned int num_regions = 0;
+	vector<size_t> queue;
+
+	for (size_t seed = 0; seed < _raster.size(); seed++){
+		if (_raster[seed] != RASTER_UNASSIGNED) continue;
+
+		const Coordinate seed_center(-90.0 + (seed / _raster_cols + 0.5) * cell_size, -180.0 + (seed % _raster_cols + 0.5) * cell_size);
+		uint16_t value = RASTER_EXACT;
+		try {
+			const PLPlate* plate = _findPlateExact(seed_center);
+			value = find(_plates.begin(), _plates.end(), plate) - _plates.begin();
+		} catch (Exception& ex){
+			// No (single) plate for this region: leave it to the exact test, which will
+			// report the problem
+		}
+
+		num_regions++;
+		_raster[seed] = value;
+		queue.push_back(seed);
+
+		while (!queue.empty()){
+			const size_t cell = queue.back();
+			queue.pop_back();
+
+			const size_t row = cell / _raster_cols;
+			const size_t col = cell % _raster_cols;
+
+			const size_t neighbours[4] = {
+					row > 0 ? cell - _raster_cols : cell,
+					row + 1 < _raster_rows ? cell + _raster_cols : cell,
+					row * _raster_cols + (col + _raster_cols - 1) % _raster_cols,
+					row * _raster_cols + (col + 1) % _raster_cols
+			};
+
+			for (size_t neighbour : neighbours){
+				if (_raster[neighbour] == RASTER_UNASSIGNED){
+					_raster[neighbour] = value;
+					queue.push_back(neighbour);
+				}
+			}
+		}
+	}
+
+	const size_t num_exact = count(_raster.begin(), _raster.end(), RASTER_EXACT);
+	stringstream ss_done;
+	ss_done << "Plate raster built: " << num_regions << " regions, " << (100.0 * num_exact / _raster.size()) << "% of cells require exact test";
+	Logger::logInfo(ss_done.str());
+}
+
+/**
+ * Writes the plate raster to a binary file (see BinaryWriter). The file contains a fingerprint
+ * of the plate data, so that rasters built from other plate data are not used by accident.
+ * Note that the file is written in the byte order of the machine.
+ */
+void paleo_latitude::PLPlates::writeRaster(const string& filename) const {
+	if (_raster.empty()) throw Exception("No plate raster to write - build raster first");
+
+	BinaryWriter out;
+	out.write(RASTER_FILE_MAGIC);
+	out.write(RASTER_FILE_VERSION);
+	out.write(_raster_rows);
+	out.write(_raster_cols);
+	out.write(_fingerprint());
+	out.writeArray(_raster);
+
+	const vector<char>& data = out.getData();
+	ofstream file(filename, ios::binary);
+	file.write(data.data(), data.size());
+	file.close();
+
+	if (!file.good()){
+		Exception ex;
+		ex << "Error writing plate raster to '" << filename << "'";
+		throw ex;
+	}
+}
+
+/**
+ * Reads the plate raster from a file written by #writeRaster. Returns false if the file
+ * does not exist, or does not match the plate data.
+ */
+bool paleo_latitude::PLPlates::readRaster(const string& filename) {
+	if (!ifstream(filename).good()) return false;
+
+	const MappedFile file(filename);
+	uint32_t rows = 0, cols = 0;
+	ArrayView<uint16_t> raster;
+
+	try {
+		BinaryReader in(file.data(), file.size(), filename);
+		const bool supported = (in.read<array<char, 8> >() == RASTER_FILE_MAGIC && in.read<uint32_t>() == RASTER_FILE_VERSION);
+		rows = in.read<uint32_t>();
+		cols = in.read<uint32_t>();
+		const uint64_t fingerprint = in.read<uint64_t>();
+
+		if (!supported || rows == 0 || cols != 2 * rows){
+			Logger::logWarn("Ignoring plate raster '" + filename + "': not a (supported) plate raster file");
+			return false;
+		}
+
+		if (fingerprint != _fingerprint()){
+			Logger::logWarn("Ignoring plate raster '" + filename + "': raster was built using different plate data");
+			return false;
+		}
+
+		raster = in.readArray<uint16_t>();
+	} catch (Exception& ex){
+		Logger::logWarn("Ignoring plate raster: " + string(ex.what()));
+		return false;
+	}
+
+	if (raster.size() != static_cast<size_t>(rows) * cols){
+		Logger::logWarn("Ignoring plate raster '" + filename + "': invalid raster data");
+		return false;
+	}
+
+	for (uint16_t value : raster){
+		if (value != RASTER_EXACT && value >= _plates.size()){
+			Logger::logWarn("Ignoring plate raster '" + filename + "': invalid raster data");
+			return false;
+		}
+	}
+
+	_raster = raster.to_vector();
+	_raster_rows = rows;
+	_raster_cols = cols;
+
+	Logger::logInfo("Read plate raster from '" + filename + "'");
+	return true;
+}
+
+/**
+ * Computes a fingerprint of the plate data: the checksum (see BinaryIO::checksum) of the plate
+ * IDs and coordinates
+ */
+uint64_t paleo_latitude::PLPlates::_fingerprint() const {
+	BinaryWriter out;
+	for (const PLPlate* plate : _plates){
+		out.write<uint32_t>(plate->getId());
+
+		for (const Coordinate& coord : *plate->getCoordinates()){
+			out.write(coord.latitude);
+			out.write(coord.longitude);
+		}
+	}
+
+	const vector<char>& data = out.getData();
+	return BinaryIO::checksum(data.data(), data.size());
+}
+
 /**
  * Returns the plate parts as defined by the input data. Note that some plates consist
  * of multiple parts stitched together. In that case, every part is returned separately,
@@ -224,9 +1130,6 @@ int paleo_latitude::PLPlates::countRealNumberOfPlates() const {
  * @param gpmlfilename
  */
 void paleo_latitude::PLPlates::_readPlatesFromGPML(const string& gpmlfilename) {
-	xml_document gpml;
-	gpml.load_file(gpmlfilename.c_str());
-
 	// Structure of XML file:
 	// <gml:featureMember>							<-- one for each plate
 	//  <gpml:UnclassifiedFeature>                  <-- sometimes '<gpml:ContinentalFragment>' or '<gpml:DisplacementPoint>'
@@ -244,98 +1147,20 @@ void paleo_latitude::PLPlates::_readPlatesFromGPML(const string& gpmlfilename) {
 	//        <gml:LinearRing>
 	//         <gml:posList gml:dimension="2">
 	//          [lat1] [lon1] [lat2] [lon2]			<-- separated by spaces, latitude first
-
-	// XPath to find XML nodes that specifies plate ID
-	const string xpath_plate_ids = "//gpml:reconstructionPlateId/gpml:ConstantValue[gpml:valueType/text()='gpml:plateId']";
-
-	// Iterate over all nodes that describe a plate ID
-	pugi::xpath_node_set plate_ids_nodes = gpml.select_nodes(xpath_plate_ids.c_str());
-	for (pugi::xpath_node node_constantvalue_plate_id : plate_ids_nodes){
-		const pugi::xpath_node node_value_plate_id = node_constantvalue_plate_id.node().child("gpml:value");
-
-		// Plate ID is hidden in
-		// <gpml:reconstructionPlateId><gpml:ConstantValue><gpml:value>[PLATE_ID]
-		const unsigned int plate_id = node_value_plate_id.node().text().as_uint();
-		const string plate_id_str = node_value_plate_id.node().text().as_string();
-
-
-		// Different GPML files have the 'gpml:UnclassifiedFeature' node at different levels.
-		// Look for ancestor 'gpml:UnclassifiedFeature' by moving up the tree. However, it appears
-		// that some GPML files use 'gpml:ContinentalFragment' or 'gpml:DisplacementPoint' nodes
-		// instead of 'gpml:UnclassifiedFeature'
-		const string xpath_unclassifiedFeature = ".//ancestor::gpml:UnclassifiedFeature";
-		const string xpath_continentalfragment = ".//ancestor::gpml:ContinentalFragment";
-		const string xpath_displacementpoint = ".//ancestor::gpml:DisplacementPoint";
-
-		pugi::xpath_node node_uf_dp_cf = node_value_plate_id.node().select_single_node(xpath_unclassifiedFeature.c_str());
-
-		if (node_uf_dp_cf.node().empty()){
-			node_uf_dp_cf = node_value_plate_id.node().select_single_node(xpath_continentalfragment.c_str());
-		}
-
-		if (node_uf_dp_cf.node().empty()){
-			node_uf_dp_cf = node_value_plate_id.node().select_single_node(xpath_displacementpoint.c_str());
-		}
-
-		if (node_uf_dp_cf.node().empty()){
-			// Ancestor node <gpml:UnclassifiedFeature> not found
-			Logger::logWarn("Could not find name and polygon definition for plate '" + plate_id_str + "' in GPML file (missing <gpml:UnclassifiedFeature> ancestor) - ignoring plate");
-			continue;
-		}
-
-		const string xpath_plate_name = ".//gml:name";
-		const pugi::xpath_node node_plate_name = node_uf_dp_cf.node().select_single_node(xpath_plate_name.c_str());
-
-		if (node_plate_name.node().empty()){
-			// No <gml:name>
-			Logger::logWarn("Could not find name for plate '" + plate_id_str + "' in GPML file (missing <gml:name> element) - ignoring plate");
-			continue;
-		}
-
-		const string plate_name = node_plate_name.node().text().as_string();
-
-
-		// Find descendant 'gml:posList', which contains the coordinates of the line segments:
-		// <gpml:UnclassifiedFeature>
-		//  <gpml:unclassifiedGeometry>
-		//   <gpml:ConstantValue>
-		//    <gpml:value>
-		//     <gml:Polygon>
-		//      <gml:exterior>
-		//       <gml:LinearRing>
-		//        <gml:posList gml:dimension="2">
-		const string xpath_posList = ".//gml:posList";
-		const pugi::xpath_node node_poslist = node_uf_dp_cf.node().select_single_node(xpath_posList.c_str());
-
-		if (node_poslist.node().empty()){
-			// No <gml:posList> element
-			Logger::logWarn("Could not find polygon definition for plate '" + plate_name + "' (id: " + plate_id_str + ") in GPML file (missing <gml:posList> element) - ignoring plate");
-			continue;
-		}
-
-		string node_poslist_name = node_poslist.node().name();
-		string node_coords_text = node_poslist.node().text().as_string();
-		vector<string> coords_strs;
-		boost::split(coords_strs, node_coords_text, boost::is_any_of(" "));
-
-		vector<Coordinate>* poly_coords = new vector<Coordinate>();
-		poly_coords->reserve(coords_strs.size() / 2.0);
-
-		for (unsigned int i = 0; i < coords_strs.size() - 1; i+= 2){
-			string str_lon = coords_strs[i+1];
-			string str_lat = coords_strs[i];
-
-			double lat = 0;
-			double lon = 0;
-			if (!Util::string_to_something(str_lat, lat)) throw PLFileParseException("Error parsing coordinate: " + str_lat);
-			if (!Util::string_to_something(str_lon, lon)) throw PLFileParseException("Error parsing coordinate: " + str_lon);
-
-			poly_coords->push_back(Coordinate(lat, lon));
-		}
-
-		PLPlate* plate = new PLPlate(plate_id, plate_name, poly_coords);
-		_plates.push_back(plate);
+	//
+	// Plate IDs are found in <gpml:reconstructionPlateId><gpml:ConstantValue> elements with
+	// a <gpml:valueType> of 'gpml:plateId'. Different GPML files have the feature element at
+	// different levels, and some use 'gpml:ContinentalFragment' or 'gpml:DisplacementPoint'
+	// instead of 'gpml:UnclassifiedFeature' (see GPMLPlatesReader)
+
+	GPMLPlatesReader reader(_plates);
+	try {
+		reader.parseFile(gpmlfilename);
+	} catch (const PLFileParseException&){
+		throw;
+	} catch (const Exception& ex){
+		PLFileParseException plfe;
+		plfe << "Error reading plates from GPML file: " << ex.what() << " (" << gpmlfilename << ")";
+		throw plfe;
 	}
-
-
 }
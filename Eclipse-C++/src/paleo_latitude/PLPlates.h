@@ -9,8 +9,14 @@
 #define PLPLATES_H_
 
 #include <string>
+#include <utility>
+#include <cstdint>
+#include <boost/geometry/geometries/point.hpp>
+#include <boost/geometry/geometries/box.hpp>
+#include <boost/geometry/index/rtree.hpp>
 #include "PLPlate.h"
 #include "../util/Exception.h"
+#include "../util/Vector3.h"
 using namespace std;
 
 namespace paleo_latitude {
@@ -24,21 +30,109 @@ public:
 	const PLPlate* findPlate(const Coordinate& site) const;
 	const PLPlate* findPlate(double lat, double lon) const;
 
+	/**
+	 * Finds the plates for a batch of sites. Results are stored in the same order as the
+	 * sites, but the sites are processed in the order of a Morton (Z-order) curve, so that
+	 * consecutive lookups concern nearby sites (and hence the same plate data). Sites for
+	 * which no single plate can be found yield NULL; the reason is stored in errors (if
+	 * provided, empty for sites that were resolved).
+	 */
+	void findPlates(const vector<Coordinate>& sites, vector<const PLPlate*>& result, vector<string>* errors = NULL) const;
+
 	const vector<const PLPlate*> getPlates() const;
 	string getPlateName(unsigned int plate_id) const;
 
 	int countRealNumberOfPlates() const;
 
+	/**
+	 * Enables the plate ID raster: a global lat/lon grid (with cells of the given size in
+	 * degrees) that stores the plate covering each cell, so that #findPlate only needs to
+	 * run the exact point-in-polygon test for sites near plate boundaries. If a filename
+	 * is provided, the raster is read from that file (if it exists and matches the plate
+	 * data), or built and written to that file otherwise. Throws an Exception if the
+	 * resolution is invalid, or would yield too many cells.
+	 */
+	void enableRaster(double resolution, const string& raster_filename = "");
+
+	/**
+	 * Throws an Exception if the raster resolution (cell size in degrees) is invalid, or would
+	 * yield more than MAX_RASTER_CELLS cells
+	 */
+	static void validateRasterResolution(double resolution);
+
+	void buildRaster(double resolution);
+	bool readRaster(const string& filename);
+	void writeRaster(const string& filename) const;
+	bool hasRaster() const;
+
 	static PLPlates* readFromFile(const string& filename);
 
+	/**
+	 * Writes the plates and all derived data (containment data of the plates, containment
+	 * hierarchy, and the raster if enabled) in the binary format of dataset bundles. Only
+	 * the spatial index is rebuilt by readBinary().
+	 */
+	void writeBinary(BinaryWriter& out) const;
+	static PLPlates* readBinary(BinaryReader& in);
+
 private:
 	PLPlates();
 	PLPlates(const PLPlates& other) = delete; // keep things easy: no copy constructor
 
+	typedef boost::geometry::model::point<double, 2, boost::geometry::cs::cartesian> IndexPoint;
+	typedef boost::geometry::model::box<IndexPoint> IndexBox;
+	typedef pair<IndexBox, unsigned int> IndexValue;
+	typedef boost::geometry::index::rtree<IndexValue, boost::geometry::index::quadratic<16> > Index;
+
 	void _readPlatesFromKML(const string& kmlfilename);
 	void _readPlatesFromGPML(const string& gpmlfilename);
 
+	void _buildIndex();
+	void _buildContainmentHierarchy();
+	bool _partContains(unsigned int outer, unsigned int inner) const;
+	static vector<IndexBox> _indexBoxes(const PLPlate::BoundingBox& bbox);
+	vector<unsigned int> _findCandidatePlates(const Coordinate& site) const;
+	const PLPlate* _findPlateExact(const Coordinate& site) const;
+
+	size_t _rasterCell(double lat, double lon) const;
+	void _rasteriseSegment(const Vector3& from, const Vector3& to, unsigned int depth);
+	uint64_t _fingerprint() const;
+
+	static uint32_t _mortonKey(const Coordinate& site);
+
+	/**
+	 * Raster cell value indicating that the cell is crossed by (or close to) a plate
+	 * boundary, so the exact test is required
+	 */
+	const static uint16_t RASTER_EXACT;
+	const static uint16_t RASTER_UNASSIGNED;
+
+	/**
+	 * Maximum number of cells of the plate raster (2 bytes each)
+	 */
+	const static size_t MAX_RASTER_CELLS;
+
 	vector<const PLPlate*> _plates;
+
+	/**
+	 * Spatial index over the bounding boxes of all plate parts (in lon/lat space). Values
+	 * are indices into _plates.
+	 */
+	Index _index;
+
+	/**
+	 * Containment hierarchy of the plate parts: for every part (index in _plates), the sorted
+	 * indices of the parts that it fully contains (see PLPlate::contains(const PLPlate&))
+	 */
+	vector<vector<unsigned int> > _contained_parts;
+
+	/**
+	 * Plate ID raster (row-major, starting at (-90,-180)). Values are indices into _plates,
+	 * or RASTER_EXACT. Empty if the raster is not enabled.
+	 */
+	vector<uint16_t> _raster;
+	uint32_t _raster_rows = 0;
+	uint32_t _raster_cols = 0;
 };
 
 };
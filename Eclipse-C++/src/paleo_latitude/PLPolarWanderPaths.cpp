@@ -13,11 +13,16 @@
 #include <sstream>
 
 #include "exceptions/PLFileParseException.h"
+#include "../util/BinaryIO.h"
 #include "../util/Exception.h"
+#include "../util/Stats.h"
 
 using namespace paleo_latitude;
 using namespace std;
 
+const unsigned int PLPolarWanderPaths::AGE_STEP = 10;
+const unsigned int PLPolarWanderPaths::MAX_TABLE_PLATE_ID = 9999;
+const unsigned int PLPolarWanderPaths::MAX_TABLE_AGE = 4600;
 
 PLPolarWanderPaths::PLPolarWanderPaths() {}
 
@@ -33,9 +38,83 @@ PLPolarWanderPaths* PLPolarWanderPaths::readFromFile(string filename) {
 }
 
 void PLPolarWanderPaths::_readFromFile(string filename){
+	const Stats::Timer timer(Stats::PARSE_CSV);
+
 	if (_csvdata != NULL) delete _csvdata;
 	_csvdata = new CSVFileData<PWPEntry>();
 	_csvdata->parseFile(filename);
+	_buildTable();
+}
+
+void PLPolarWanderPaths::writeBinary(BinaryWriter& out) const {
+	vector<BinaryEntry> entries;
+	for (const PWPEntry& entry : _csvdata->getEntries()){
+		entries.push_back(BinaryEntry{ entry.plate_id, entry.age, entry.getLineNo(), 0, entry.a95, entry.latitude, entry.longitude });
+	}
+
+	out.writeString(_csvdata->getFilename());
+	out.writeArray(entries);
+}
+
+PLPolarWanderPaths* PLPolarWanderPaths::readBinary(BinaryReader& in) {
+	const string filename = in.readString();
+	const ArrayView<BinaryEntry> entries = in.readArray<BinaryEntry>();
+
+	PLPolarWanderPaths* res = new PLPolarWanderPaths();
+	res->_csvdata = new CSVFileData<PWPEntry>();
+	res->_csvdata->reserve(entries.size());
+
+	for (const BinaryEntry& entry : entries){
+		PWPEntry& pwp_entry = res->_csvdata->addEntry(filename, entry.line_no);
+		pwp_entry.plate_id = entry.plate_id;
+		pwp_entry.age = entry.age;
+		pwp_entry.a95 = entry.a95;
+		pwp_entry.latitude = entry.latitude;
+		pwp_entry.longitude = entry.longitude;
+	}
+
+	res->_buildTable();
+	return res;
+}
+
+void PLPolarWanderPaths::_buildTable(){
+	const vector<PWPEntry>& entries = _csvdata->getEntries();
+
+	_table.clear();
+	_table_rows.clear();
+	_table_num_ages = 0;
+	_irregular_entries.clear();
+
+	unsigned int num_rows = 0;
+	for (const PWPEntry& entry : entries){
+		if (!_inTable(entry.plate_id, entry.age)) continue;
+
+		if (entry.plate_id >= _table_rows.size()) _table_rows.resize(entry.plate_id + 1, -1);
+		if (_table_rows[entry.plate_id] < 0) _table_rows[entry.plate_id] = num_rows++;
+		_table_num_ages = max(_table_num_ages, entry.age / AGE_STEP + 1);
+	}
+
+	_table.assign(num_rows * _table_num_ages, -1);
+
+	for (size_t i = 0; i < entries.size(); i++){
+		const PWPEntry& entry = entries[i];
+
+		// In case of duplicates, the first entry in the file is used
+		if (!_inTable(entry.plate_id, entry.age)){
+			_irregular_entries.insert(make_pair(_tableKey(entry.plate_id, entry.age), i));
+		} else {
+			int& slot = _table[_table_rows[entry.plate_id] * _table_num_ages + entry.age / AGE_STEP];
+			if (slot < 0) slot = i;
+		}
+	}
+}
+
+bool PLPolarWanderPaths::_inTable(unsigned int plate_id, unsigned int age){
+	return plate_id <= MAX_TABLE_PLATE_ID && age <= MAX_TABLE_AGE && age % AGE_STEP == 0;
+}
+
+uint64_t PLPolarWanderPaths::_tableKey(unsigned int plate_id, unsigned int age){
+	return (((uint64_t) plate_id) << 32) | age;
 }
 
 const PLPolarWanderPaths::PWPEntry* PLPolarWanderPaths::getEntry(const PLPlate& plate, unsigned int age) const {
@@ -43,11 +122,26 @@ const PLPolarWanderPaths::PWPEntry* PLPolarWanderPaths::getEntry(const PLPlate&
 }
 
 
-const PLPolarWanderPaths::PWPEntry* PLPolarWanderPaths::getEntry(unsigned int plate_id, unsigned int age) const {
-	for (const PWPEntry& entry : _csvdata->getEntries()){
-		if (entry.age == age && entry.plate_id == plate_id) return &entry;
+const PLPolarWanderPaths::PWPEntry* PLPolarWanderPaths::findEntry(unsigned int plate_id, unsigned int age) const {
+	const Stats::Timer timer(Stats::APWP_LOOKUP);
+
+	const vector<PWPEntry>& entries = _csvdata->getEntries();
+
+	if (_inTable(plate_id, age)){
+		if (plate_id >= _table_rows.size() || _table_rows[plate_id] < 0 || age / AGE_STEP >= _table_num_ages) return NULL;
+
+		const int index = _table[_table_rows[plate_id] * _table_num_ages + age / AGE_STEP];
+		return (index >= 0) ? &entries[index] : NULL;
 	}
 
+	const auto it = _irregular_entries.find(_tableKey(plate_id, age));
+	return (it != _irregular_entries.end()) ? &entries[it->second] : NULL;
+}
+
+const PLPolarWanderPaths::PWPEntry* PLPolarWanderPaths::getEntry(unsigned int plate_id, unsigned int age) const {
+	const PWPEntry* entry = findEntry(plate_id, age);
+	if (entry != NULL) return entry;
+
 	Exception ex;
 	ex << "No apparent polar wander path known for plate ID " << plate_id << " and age " << age;
 
@@ -60,15 +154,13 @@ const vector<PLPolarWanderPaths::PWPEntry>& PLPolarWanderPaths::getAllEntries()
 }
 
 
-void PLPolarWanderPaths::PWPEntry::set(unsigned int col_index, const string value, const string filename, unsigned int lineno){
+void PLPolarWanderPaths::PWPEntry::set(unsigned int col_index, string_view value, const string& filename, unsigned int lineno){
 	// Column index 0: plate ID (uint)
 	// Column index 1: age (uint)
 	// Column index 2: a95 (uint)
 	// Column index 3: longitude (double)
 	// Column index 4: latitude (double)
 
-	auto entries = _container->getEntries();
-
 	if (col_index == 0) this->parseString(value, this->plate_id);
 
 	if (col_index == 1){
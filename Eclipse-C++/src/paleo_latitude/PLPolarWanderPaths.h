@@ -7,6 +7,8 @@
 
 #ifndef PLPOLARWANDERPATHS_H_
 #define PLPOLARWANDERPATHS_H_
+#include <cstdint>
+#include <unordered_map>
 #include <vector>
 #include "PLPlate.h"
 #include "../util/Logger.h"
@@ -24,7 +26,7 @@ class PLPolarWanderPaths {
 public:
 	struct PWPEntry : public CSVFileData<PWPEntry>::Entry {
 		PWPEntry(CSVFileData<PWPEntry>* parent, unsigned int line_no) : CSVFileData<PWPEntry>::Entry(parent, line_no){}
-		void set(unsigned int col_index, const string value, const string filename, unsigned int lineno) override;
+		void set(unsigned int col_index, string_view value, const string& filename, unsigned int lineno) override;
 		size_t numColumns() const override;
 
 		unsigned int plate_id = 0;
@@ -39,13 +41,45 @@ public:
 
 	const PWPEntry* getEntry(unsigned int plate_id, unsigned int age) const;
 	const PWPEntry* getEntry(const PLPlate& plate, unsigned int age) const;
+
+	/**
+	 * Same as getEntry(), but returns NULL (rather than throwing an exception) if there is no
+	 * entry for the plate and age
+	 */
+	const PWPEntry* findEntry(unsigned int plate_id, unsigned int age) const;
 	const vector<PWPEntry>& getAllEntries() const;
 
 	static PLPolarWanderPaths* readFromFile(string filename);
 
+	/**
+	 * Writes the entries in the binary format of dataset bundles
+	 */
+	void writeBinary(BinaryWriter& out) const;
+	static PLPolarWanderPaths* readBinary(BinaryReader& in);
+
 private:
+	/**
+	 * Entry as stored in dataset bundles (with explicit padding, which must be zero)
+	 */
+	struct BinaryEntry {
+		uint32_t plate_id;
+		uint32_t age;
+		uint32_t line_no;
+		uint32_t padding;
+		double a95;
+		double latitude;
+		double longitude;
+
+		static const bool BINARY_PACKED = true;
+	};
+	static_assert(sizeof(BinaryEntry) == 4 * sizeof(uint32_t) + 3 * sizeof(double), "BinaryEntry contains implicit padding");
+
 	PLPolarWanderPaths();
 	void _readFromFile(string filename);
+	void _buildTable();
+
+	static bool _inTable(unsigned int plate_id, unsigned int age);
+	static uint64_t _tableKey(unsigned int plate_id, unsigned int age);
 
 
 	template<class T> bool _parseCsvField(unsigned int line_no, const string& field, T& result, const string& warn_msg){
@@ -61,6 +95,22 @@ private:
 	}
 
 	CSVFileData<PWPEntry>* _csvdata = NULL;
+
+	/**
+	 * Lookup table: the data is on a regular grid of ages (AGE_STEP Myr), so entries are indexed
+	 * directly by (plate ID, age / AGE_STEP) in _table, which holds an index into the entries
+	 * (or -1). _table_rows maps a plate ID to its row in the table (or -1). Entries with other
+	 * ages, or with very large plate IDs or ages (which would make the table huge), are stored
+	 * in _irregular_entries.
+	 */
+	const static unsigned int AGE_STEP;
+	const static unsigned int MAX_TABLE_PLATE_ID;
+	const static unsigned int MAX_TABLE_AGE;
+
+	vector<int> _table;
+	vector<int> _table_rows;
+	unsigned int _table_num_ages = 0;
+	unordered_map<uint64_t, int> _irregular_entries;
 };
 
 };
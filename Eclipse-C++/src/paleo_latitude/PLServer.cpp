@@ -0,0 +1,389 @@
+/*
+ * PLServer.cpp
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: Sebastiaan J. van Schaik
+ */
+
+#include "PLServer.h"
+
+#include <cerrno>
+#include <cstring>
+#include <sstream>
+#include <thread>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <boost/algorithm/string.hpp>
+
+#include "PaleoLatitude.h"
+#include "PLDataset.h"
+#include "../util/Exception.h"
+#include "../util/Logger.h"
+#include "../util/Util.h"
+
+using namespace paleo_latitude;
+
+const string PLServer::END_OF_RESPONSE = "#END";
+const size_t PLServer::MAX_REQUEST_LENGTH = 4096;
+const unsigned int PLServer::CONNECTION_IDLE_TIMEOUT = 300;
+
+PLServer::PLServer(const PLParameters& defaults, unsigned int num_threads) : _defaults(defaults), _num_threads(num_threads), _stopping(false), _wakeup_fd(-1) {
+
+}
+
+PLServer::~PLServer() {
+	for (const pair<string, const PLDataset*>& model : _models) delete model.second;
+	_models.clear();
+}
+
+void PLServer::addModel(const string& name, const PLDataset* dataset) {
+	for (const pair<string, const PLDataset*>& model : _models){
+		if (model.first == name){
+			delete dataset;
+			throw Exception("Model '" + name + "' was added to the server twice");
+		}
+	}
+
+	_models.push_back(make_pair(name, dataset));
+}
+
+void PLServer::serve(const string& socket_path) {
+	if (_models.empty()) throw Exception("No models to serve - add a model first");
+
+	sockaddr_un address;
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	if (socket_path.empty() || socket_path.size() >= sizeof(address.sun_path)){
+		Exception ex;
+		ex << "Invalid socket path '" << socket_path << "' (expecting at most " << (sizeof(address.sun_path) - 1) << " characters)";
+		throw ex;
+	}
+	strncpy(address.sun_path, socket_path.c_str(), sizeof(address.sun_path) - 1);
+
+	// Replace the socket of an earlier server (but nothing else)
+	struct stat path_stat;
+	if (lstat(socket_path.c_str(), &path_stat) == 0){
+		if (!S_ISSOCK(path_stat.st_mode)) throw Exception("Cannot create socket '" + socket_path + "': file exists");
+		unlink(socket_path.c_str());
+	}
+
+	int wakeup_fds[2];
+	if (pipe2(wakeup_fds, O_NONBLOCK | O_CLOEXEC) != 0) throw Exception("Could not create pipe: " + string(strerror(errno)));
+
+	const int listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	if (listen_fd < 0 || bind(listen_fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 || listen(listen_fd, SOMAXCONN) != 0){
+		const int error = errno;
+		if (listen_fd >= 0) close(listen_fd);
+		close(wakeup_fds[0]);
+		close(wakeup_fds[1]);
+
+		Exception ex;
+		ex << "Could not listen on socket '" << socket_path << "': " << strerror(error);
+		throw ex;
+	}
+
+	_wakeup_fd = wakeup_fds[1];
+
+	const unsigned int num_threads = (_num_threads > 0) ? _num_threads : max(1u, thread::hardware_concurrency());
+	vector<thread> workers;
+	for (unsigned int i = 0; i < num_threads; i++) workers.push_back(thread(&PLServer::_workerLoop, this));
+
+	_pollLoop(listen_fd, wakeup_fds[0]);
+
+	{
+		lock_guard<mutex> lock(_queue_mutex);
+		_workers_stopping = true;
+	}
+	_queue_changed.notify_all();
+	for (thread& worker : workers) worker.join();
+
+	{
+		lock_guard<mutex> lock(_queue_mutex);
+		for (const pair<const int, Connection*>& connection : _connections){
+			close(connection.first);
+			delete connection.second;
+		}
+		_connections.clear();
+		_queue.clear();
+		_workers_stopping = false;
+	}
+
+	_wakeup_fd = -1;
+	close(wakeup_fds[0]);
+	close(wakeup_fds[1]);
+	close(listen_fd);
+	unlink(socket_path.c_str());
+}
+
+void PLServer::stop() {
+	_stopping = true;
+	_wakeUp();
+
+	// Wakes up workers that are sending a response to a client that does not read it
+	lock_guard<mutex> lock(_queue_mutex);
+	for (const pair<const int, Connection*>& connection : _connections) shutdown(connection.first, SHUT_RDWR);
+}
+
+void PLServer::_wakeUp() {
+	const int wakeup_fd = _wakeup_fd;
+	if (wakeup_fd < 0) return; // not serving (yet)
+
+	// If the pipe is full, the poll loop will wake up anyway
+	const char c = 0;
+	const ssize_t res = write(wakeup_fd, &c, 1);
+	(void) res;
+}
+
+/**
+ * Waits for new connections and for input on the connections that are not busy, and queues
+ * connections with requests for the workers, until the server is stopped
+ */
+void PLServer::_pollLoop(int listen_fd, int wakeup_fd) {
+	vector<pollfd> poll_fds;
+	vector<Connection*> polled_connections;
+
+	while (!_stopping){
+		const chrono::steady_clock::time_point now = chrono::steady_clock::now();
+		poll_fds.assign({ { listen_fd, POLLIN, 0 }, { wakeup_fd, POLLIN, 0 } });
+		polled_connections.clear();
+
+		{
+			lock_guard<mutex> lock(_queue_mutex);
+			for (map<int, Connection*>::iterator it = _connections.begin(); it != _connections.end(); ){
+				Connection* connection = it->second;
+				if (connection->busy){
+					++it;
+					continue;
+				}
+
+				if (connection->finished || now - connection->last_activity > chrono::seconds(CONNECTION_IDLE_TIMEOUT)){
+					close(connection->fd);
+					delete connection;
+					it = _connections.erase(it);
+					continue;
+				}
+
+				poll_fds.push_back({ connection->fd, POLLIN, 0 });
+				polled_connections.push_back(connection);
+				++it;
+			}
+		}
+
+		// Wake up regularly to close idle connections
+		if (poll(poll_fds.data(), poll_fds.size(), 1000) < 0){
+			if (errno == EINTR) continue;
+			throw Exception("Error waiting for requests: " + string(strerror(errno)));
+		}
+
+		if (poll_fds[1].revents != 0){
+			char buffer[256];
+			while (read(wakeup_fd, buffer, sizeof(buffer)) > 0);
+		}
+
+		if (poll_fds[0].revents != 0) _acceptConnections(listen_fd);
+
+		for (size_t i = 0; i < polled_connections.size(); i++){
+			if (poll_fds[i + 2].revents != 0) _receive(polled_connections[i]);
+		}
+	}
+}
+
+void PLServer::_acceptConnections(int listen_fd) {
+	while (true){
+		const int connection_fd = accept4(listen_fd, NULL, NULL, SOCK_CLOEXEC);
+		if (connection_fd < 0){
+			if (errno == EINTR || errno == ECONNABORTED) continue;
+			if (errno == EAGAIN || errno == EWOULDBLOCK) return;
+
+			// E.g. out of file descriptors: try again when the next connection arrives
+			Logger::logWarn("Could not accept connection: " + string(strerror(errno)));
+			return;
+		}
+
+		// A client that does not read its responses should not occupy a worker forever
+		const timeval send_timeout = { (time_t) CONNECTION_IDLE_TIMEOUT, 0 };
+		setsockopt(connection_fd, SOL_SOCKET, SO_SNDTIMEO, &send_timeout, sizeof(send_timeout));
+
+		lock_guard<mutex> lock(_queue_mutex);
+		_connections[connection_fd] = new Connection(connection_fd);
+	}
+}
+
+/**
+ * Reads the input that is available on a connection, and queues the connection for a worker
+ * once it contains a complete request (or the client has closed the connection)
+ */
+void PLServer::_receive(Connection* connection) {
+	char buffer[4096];
+	const ssize_t num_read = recv(connection->fd, buffer, sizeof(buffer), MSG_DONTWAIT);
+	if (num_read < 0 && (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK)) return;
+
+	if (num_read > 0){
+		connection->pending.append(buffer, num_read);
+		connection->last_activity = chrono::steady_clock::now();
+	} else {
+		// Treat the remainder of the input as the last request (unless the connection failed)
+		connection->end_of_input = true;
+		if (num_read < 0) connection->pending.clear();
+	}
+
+	if (!connection->end_of_input && connection->pending.find('\n') == string::npos && connection->pending.size() <= MAX_REQUEST_LENGTH) return;
+
+	{
+		lock_guard<mutex> lock(_queue_mutex);
+		connection->busy = true;
+		_queue.push_back(connection);
+	}
+	_queue_changed.notify_one();
+}
+
+void PLServer::_workerLoop() {
+	while (true){
+		Connection* connection;
+		{
+			unique_lock<mutex> lock(_queue_mutex);
+			_queue_changed.wait(lock, [this](){ return _workers_stopping || !_queue.empty(); });
+			if (_workers_stopping) return;
+
+			connection = _queue.front();
+			_queue.pop_front();
+		}
+
+		_handleRequests(connection);
+
+		{
+			lock_guard<mutex> lock(_queue_mutex);
+			connection->busy = false;
+		}
+		_wakeUp();
+	}
+}
+
+/**
+ * Sends the responses to the complete requests (one per line) received on a connection, and
+ * marks the connection as finished when the client has closed it
+ */
+void PLServer::_handleRequests(Connection* connection) {
+	string& pending = connection->pending;
+
+	size_t line_begin = 0;
+	size_t line_end;
+	while (!_stopping && (line_end = pending.find('\n', line_begin)) != string::npos){
+		const string request = pending.substr(line_begin, line_end - line_begin);
+		line_begin = line_end + 1;
+
+		if (boost::trim_copy(request).empty()) continue;
+		if (!_sendAll(connection->fd, handleRequest(request))){
+			connection->finished = true;
+			return;
+		}
+	}
+	pending.erase(0, line_begin);
+
+	if (pending.size() > MAX_REQUEST_LENGTH){
+		_sendAll(connection->fd, _errorResponse("Request too long"));
+		connection->finished = true;
+	} else if (connection->end_of_input){
+		if (!_stopping && !boost::trim_copy(pending).empty()) _sendAll(connection->fd, handleRequest(pending));
+		connection->finished = true;
+	}
+
+	connection->last_activity = chrono::steady_clock::now();
+}
+
+string PLServer::handleRequest(const string& request) const {
+	PLParameters params = _defaults;
+	const PLDataset* dataset = NULL;
+	bool include_kml = true;
+	string error;
+
+	if (!_parseRequest(request, params, dataset, include_kml, error)) return _errorResponse(error);
+
+	try {
+		PaleoLatitude pl(&params, dataset);
+		if (!pl.compute()) return _errorResponse("Insufficient data available to compute paleolatitude for the requested age(s)");
+
+		stringstream response;
+		pl.writeMachineReadable(response, include_kml);
+		response << END_OF_RESPONSE << endl;
+		return response.str();
+	} catch (exception& ex){
+		return _errorResponse(ex.what());
+	}
+}
+
+bool PLServer::_parseRequest(const string& request, PLParameters& params, const PLDataset*& dataset, bool& include_kml, string& error) const {
+	params.site_latitude = params.site_longitude = -9999;
+	params.age = params.age_min = params.age_max = params.age_pm = -9999;
+	params.all_ages = false;
+	dataset = _models.front().second;
+	include_kml = true;
+
+	vector<string> tokens;
+	const string trimmed_request = boost::trim_copy(request);
+	boost::split(tokens, trimmed_request, boost::is_any_of(" \t\r"), boost::token_compress_on);
+
+	for (const string& token : tokens){
+		const size_t separator = token.find('=');
+		const string key = token.substr(0, separator);
+		const string value = (separator != string::npos) ? token.substr(separator + 1) : "";
+
+		bool parsed = true;
+		if (key == "site-lat") parsed = Util::string_to_something(value, params.site_latitude);
+		else if (key == "site-lon") parsed = Util::string_to_something(value, params.site_longitude);
+		else if (key == "age") parsed = Util::string_to_something(value, params.age);
+		else if (key == "age-pm" || key == "age-error") parsed = Util::string_to_something(value, params.age_pm);
+		else if (key == "min-age") parsed = Util::string_to_something(value, params.age_min);
+		else if (key == "max-age") parsed = Util::string_to_something(value, params.age_max);
+		else if (key == "all-ages") params.all_ages = (value != "0");
+		else if (key == "kml") include_kml = (value != "0");
+		else if (key == "model"){
+			dataset = NULL;
+			for (const pair<string, const PLDataset*>& model : _models){
+				if (model.first == value) dataset = model.second;
+			}
+
+			if (dataset == NULL){
+				error = "Unknown model '" + value + "'";
+				return false;
+			}
+		} else {
+			error = "Unknown request parameter '" + key + "'";
+			return false;
+		}
+
+		if (!parsed){
+			error = "Invalid value for request parameter '" + key + "': '" + value + "'";
+			return false;
+		}
+	}
+
+	return params.validate(error);
+}
+
+string PLServer::_errorResponse(const string& message) {
+	// Keep the error message on a single line
+	string clean_message = boost::trim_copy(message);
+	boost::replace_all(clean_message, "\n", " ");
+
+	return "#error:" + clean_message + "\n" + END_OF_RESPONSE + "\n";
+}
+
+bool PLServer::_sendAll(int fd, const string& data) {
+	size_t sent = 0;
+	while (sent < data.size()){
+		// No SIGPIPE if the client has gone away
+		const ssize_t num_sent = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+		if (num_sent < 0){
+			if (errno == EINTR) continue;
+			return false;
+		}
+		sent += num_sent;
+	}
+
+	return true;
+}
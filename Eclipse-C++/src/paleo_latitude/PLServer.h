@@ -0,0 +1,141 @@
+/*
+ * PLServer.h
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: Sebastiaan J. van Schaik
+ */
+
+#ifndef PLSERVER_H_
+#define PLSERVER_H_
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+#include "PLParameters.h"
+
+using namespace std;
+
+namespace paleo_latitude {
+
+class PLDataset;
+
+/**
+ * Query server that keeps one or more datasets (models) in memory and answers requests on a
+ * Unix domain socket, so that clients do not pay for starting a process and reading the input
+ * data for every query. Clients send one request per line, and may send any number of requests
+ * over a single connection. A request consists of whitespace-separated key=value pairs, using
+ * the names of the command-line options:
+ *
+ *   site-lat=52.5 site-lon=5.1 age=50 age-pm=5
+ *   site-lat=52.5 site-lon=5.1 min-age=40 max-age=60 model=torsvik
+ *   site-lat=52.5 site-lon=5.1 all-ages kml=0
+ *
+ * 'model' selects one of the models added to the server (default: the first one), and 'kml=0'
+ * omits the KML section of the response. The response to a request is the output of
+ * --machine-readable, or a single '#error:<message>' line, followed by an END_OF_RESPONSE line.
+ *
+ * A single thread waits for input on all connections (using poll), and hands connections with
+ * complete requests to the worker threads. Idle connections therefore do not occupy a worker,
+ * and are closed after CONNECTION_IDLE_TIMEOUT seconds without requests.
+ */
+class PLServer {
+public:
+	/**
+	 * Creates a server that handles up to num_threads requests concurrently (0 = one per
+	 * CPU core). The parameters provide defaults for all requests (e.g. for the plate raster);
+	 * site coordinates and ages are taken from the requests.
+	 */
+	PLServer(const PLParameters& defaults, unsigned int num_threads = 0);
+	PLServer(const PLServer& other) = delete;
+	virtual ~PLServer();
+
+	/**
+	 * Adds a model under the given name. The dataset is owned by the server from now on.
+	 */
+	void addModel(const string& name, const PLDataset* dataset);
+
+	/**
+	 * Listens on the Unix domain socket with the given path (replacing a socket left behind by
+	 * an earlier server) and handles requests until #stop is called
+	 */
+	void serve(const string& socket_path);
+
+	/**
+	 * Stops the server: closes the socket and all connections, which makes #serve return. May
+	 * be called from any thread.
+	 */
+	void stop();
+
+	/**
+	 * Handles a single request, and returns the response (including the END_OF_RESPONSE line)
+	 */
+	string handleRequest(const string& request) const;
+
+	const static string END_OF_RESPONSE;
+
+	/**
+	 * Number of seconds after which a connection without (complete) requests is closed
+	 */
+	const static unsigned int CONNECTION_IDLE_TIMEOUT;
+
+private:
+	/**
+	 * Open connection, and the input received on it that has not been handled yet. While a
+	 * worker handles its requests, a connection is busy: it is only accessed by that worker.
+	 */
+	struct Connection {
+		Connection(int fd_) : fd(fd_), last_activity(chrono::steady_clock::now()) {}
+
+		const int fd;
+		string pending;
+		chrono::steady_clock::time_point last_activity;
+		bool busy = false;
+		bool end_of_input = false;
+		bool finished = false;		// to be closed
+	};
+
+	void _pollLoop(int listen_fd, int wakeup_fd);
+	void _acceptConnections(int listen_fd);
+	void _receive(Connection* connection);
+	void _workerLoop();
+	void _handleRequests(Connection* connection);
+	void _wakeUp();
+	bool _parseRequest(const string& request, PLParameters& params, const PLDataset*& dataset, bool& include_kml, string& error) const;
+
+	static string _errorResponse(const string& message);
+	static bool _sendAll(int fd, const string& data);
+
+	const PLParameters _defaults;
+	const unsigned int _num_threads;
+	vector<pair<string, const PLDataset*> > _models;
+
+	/**
+	 * Maximum length of a request line (longer requests are rejected, and the connection is closed)
+	 */
+	const static size_t MAX_REQUEST_LENGTH;
+
+	atomic<bool> _stopping;
+
+	// Write end of the pipe that wakes up the poll loop (e.g. when a worker is done with a
+	// connection, or the server is stopped)
+	atomic<int> _wakeup_fd;
+
+	// Open connections (only accessed by the poll loop, except for busy connections)
+	map<int, Connection*> _connections;
+
+	// Connections with requests, waiting for a worker
+	mutex _queue_mutex;
+	condition_variable _queue_changed;
+	deque<Connection*> _queue;
+	bool _workers_stopping = false;
+};
+
+};
+
+#endif /* PLSERVER_H_ */
@@ -0,0 +1,496 @@
+/*
+ * PLSitesBatch.cpp
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: Sebastiaan J. van Schaik
+ */
+
+#include "PLSitesBatch.h"
+
+#include <fstream>
+#include <sstream>
+#include <memory>
+#include <functional>
+#include <iomanip>
+#include <boost/algorithm/string.hpp>
+#include <boost/property_tree/ptree.hpp>
+#include <boost/property_tree/json_parser.hpp>
+
+#include "PaleoLatitude.h"
+#include "PLDataset.h"
+#include "PLPlates.h"
+#include "../util/Exception.h"
+#include "../util/Util.h"
+#include "../util/ThreadPool.h"
+#include "../util/Stats.h"
+#include "../util/TextBuffer.h"
+
+using namespace paleo_latitude;
+
+const size_t PLSitesBatch::BLOCK_SIZE = 4096;
+const size_t PLSitesBatch::TASK_SIZE = 16;
+
+PLSitesBatch::PLSitesBatch(const PLDataset* dataset, const PLParameters& defaults, unsigned int num_threads) : _dataset(dataset), _defaults(defaults), _num_threads(num_threads) {
+
+}
+
+string PLSitesBatch::getHeader() {
+	return "id;site latitude;site longitude;plate id;age;min age;max age;latitude;lower bound;upper bound;error code;error";
+}
+
+unsigned int PLSitesBatch::process(const string& input_filename, ostream& output) const {
+	ifstream input(input_filename);
+	if (!input.good()){
+		Exception ex;
+		ex << "File '" << input_filename << "' does not exist or is not readable";
+		throw ex;
+	}
+
+	return process(input, output);
+}
+
+unsigned int PLSitesBatch::process(istream& input, ostream& output) const {
+	output << getHeader() << endl;
+
+	// Without additional threads, every line is written as soon as it has been processed
+	unique_ptr<ThreadPool> pool;
+	if (_num_threads != 1) pool.reset(new ThreadPool(_num_threads));
+	const size_t block_size = pool ? BLOCK_SIZE : 1;
+
+	vector<string> lines;
+	vector<string> rows;
+	vector<ErrorCode> error_codes;
+	unsigned int lines_read = 0;
+	unsigned int num_failed = 0;
+
+	while (true){
+		lines.clear();
+		string line;
+		while (lines.size() < block_size && getline(input, line)) lines.push_back(line);
+		if (lines.empty()) break;
+
+		_processLines(lines, lines_read + 1, false, pool.get(), rows, error_codes);
+
+		// Write results in the order of the input
+		for (size_t i = 0; i < lines.size(); i++){
+			output << rows[i];
+			if (error_codes[i] != OK) num_failed++;
+		}
+		lines_read += lines.size();
+	}
+
+	return num_failed;
+}
+
+unsigned int PLSitesBatch::stream(istream& input, ostream& output, size_t flush_interval) const {
+	unique_ptr<ThreadPool> pool;
+	if (_num_threads != 1) pool.reset(new ThreadPool(_num_threads));
+	flush_interval = max(flush_interval, (size_t) 1);
+
+	vector<string> lines;
+	vector<string> rows;
+	vector<ErrorCode> error_codes;
+	unsigned int lines_read = 0;
+	unsigned int num_failed = 0;
+
+	// Input that has arrived already, but has not been processed yet (possibly ending with a
+	// partial request)
+	string pending;
+
+	while (true){
+		// Only wait for the first request
+		string line;
+		size_t newline = pending.find('\n');
+		if (newline != string::npos){
+			line = pending.substr(0, newline);
+			pending.erase(0, newline + 1);
+		} else if (getline(input, line)){
+			line = pending + line;
+			pending.clear();
+		} else if (!pending.empty()){
+			// Last request, without a line break
+			line.swap(pending);
+		} else {
+			break;
+		}
+		lines.assign(1, line);
+
+		// Other requests are only taken from the input once they have arrived completely:
+		// waiting for the rest of a request would delay the responses to the others
+		while (lines.size() < flush_interval){
+			newline = pending.find('\n');
+			if (newline != string::npos){
+				lines.push_back(pending.substr(0, newline));
+				pending.erase(0, newline + 1);
+				continue;
+			}
+
+			const streamsize available = input.rdbuf()->in_avail();
+			if (available <= 0) break;
+
+			const size_t pending_size = pending.size();
+			pending.resize(pending_size + available);
+			pending.resize(pending_size + input.readsome(&pending[pending_size], available));
+		}
+
+		_processLines(lines, lines_read + 1, true, pool.get(), rows, error_codes);
+
+		for (size_t i = 0; i < lines.size(); i++){
+			output << rows[i];
+			if (error_codes[i] != OK) num_failed++;
+		}
+		output.flush();
+		lines_read += lines.size();
+	}
+
+	return num_failed;
+}
+
+struct PLSitesBatch::SiteResult {
+	string id;
+	string latitude;
+	string longitude;
+	PLParameters params;
+	bool json = false;		// request in JSON format, which yields output in JSON format
+	bool ignored = false;	// empty line, comment or header, which yields no output
+
+	const PLPlate* plate = NULL;
+	vector<PaleoLatitude::PaleoLatitudeEntry> entries;
+	ErrorCode error_code = OK;
+	string error;
+};
+
+/**
+ * Processes a block of lines (using the thread pool, if any), and stores the output and error
+ * code of every line. When streaming, lines may contain JSON requests, and every line yields
+ * output (see #_parseLine). Lines are processed in three steps: all lines are parsed first,
+ * then the plates of all sites in the block are determined together (see PLPlates::findPlates),
+ * and finally the paleolatitudes are computed.
+ */
+void PLSitesBatch::_processLines(const vector<string>& lines, unsigned int first_line_no, bool streaming, ThreadPool* pool, vector<string>& rows, vector<ErrorCode>& error_codes) const {
+	rows.assign(lines.size(), "");
+	error_codes.assign(lines.size(), OK);
+
+	// Runs func for every index in [0, num), in tasks of the given number of indices
+	auto run_tasks = [pool](size_t num, size_t task_size, const function<void(size_t)>& func){
+		auto process_task = [&](size_t task){
+			const size_t last = min(num, (task + 1) * task_size);
+			for (size_t i = task * task_size; i < last; i++) func(i);
+		};
+
+		const size_t num_tasks = (num + task_size - 1) / task_size;
+		if (pool != NULL && num_tasks > 1){
+			pool->run(num_tasks, process_task);
+		} else {
+			for (size_t task = 0; task < num_tasks; task++) process_task(task);
+		}
+	};
+
+	vector<SiteResult> sites(lines.size());
+	run_tasks(lines.size(), TASK_SIZE, [&](size_t i){
+		const size_t first_char = lines[i].find_first_not_of(" \t");
+		if (streaming && first_char != string::npos && lines[i][first_char] == '{'){
+			_parseJSONLine(lines[i], sites[i]);
+		} else {
+			_parseLine(lines[i], first_line_no + i, streaming, sites[i]);
+		}
+	});
+
+	// Sites that have been parsed and validated successfully need a plate
+	vector<size_t> located;
+	vector<Coordinate> coordinates;
+	for (size_t i = 0; i < sites.size(); i++){
+		if (sites[i].ignored || sites[i].error_code != OK) continue;
+		located.push_back(i);
+		coordinates.push_back(Coordinate(sites[i].params.site_latitude, sites[i].params.site_longitude));
+	}
+
+	// Every thread determines the plates of a contiguous part of the sites
+	const size_t num_parts = (pool != NULL) ? pool->getNumThreads() : 1;
+	const size_t part_size = max(TASK_SIZE, (coordinates.size() + num_parts - 1) / num_parts);
+	const size_t num_plate_tasks = (coordinates.size() + part_size - 1) / part_size;
+	run_tasks(num_plate_tasks, 1, [&](size_t task){
+		const size_t first = task * part_size;
+		const size_t last = min(coordinates.size(), first + part_size);
+		const vector<Coordinate> part(coordinates.begin() + first, coordinates.begin() + last);
+
+		vector<const PLPlate*> plates;
+		vector<string> errors;
+		_dataset->getPlates()->findPlates(part, plates, &errors);
+
+		for (size_t k = 0; k < part.size(); k++){
+			SiteResult& site = sites[located[first + k]];
+			site.plate = plates[k];
+			if (site.plate == NULL){
+				site.error_code = ERROR_NO_PLATE;
+				site.error = errors[k];
+			}
+		}
+	});
+
+	run_tasks(sites.size(), TASK_SIZE, [&](size_t i){
+		SiteResult& site = sites[i];
+		if (site.ignored) return;
+
+		if (site.error_code == OK) _computeSite(site);
+		rows[i] = site.json ? _jsonRow(site) : _csvRows(site);
+		error_codes[i] = site.error_code;
+	});
+}
+
+/**
+ * Parses a single line of input into a site, and validates its parameters. Empty lines, comments,
+ * and a header on the first line are ignored, except when streaming: a client then expects a
+ * response to every line it sends, so these lines yield a parse error.
+ */
+void PLSitesBatch::_parseLine(const string& line, unsigned int line_no, bool streaming, SiteResult& site) const {
+	const string trimmed_line = boost::trim_copy(line);
+	if (trimmed_line.empty() || trimmed_line[0] == '#'){
+		if (!streaming){
+			site.ignored = true;
+			return;
+		}
+
+		site.error_code = ERROR_PARSE;
+		site.error = trimmed_line.empty() ? "Empty request" : "Comment instead of request";
+		return;
+	}
+
+	vector<string> values;
+	boost::split(values, trimmed_line, boost::is_any_of(";,"));
+	for (string& value : values) boost::trim(value);
+
+	site.id = values[0];
+	site.latitude = (values.size() > 1) ? values[1] : "";
+	site.longitude = (values.size() > 2) ? values[2] : "";
+
+	PLParameters& params = site.params;
+	params = _defaults;
+	params.age = params.age_min = params.age_max = -9999;
+
+	bool parsed = (values.size() >= 3 && values.size() <= 5);
+	parsed = parsed && Util::string_to_something(site.latitude, params.site_latitude);
+	parsed = parsed && Util::string_to_something(site.longitude, params.site_longitude);
+	// Age columns are ignored when computing all ages
+	if (values.size() == 4 && !params.all_ages) parsed = parsed && Util::string_to_something(values[3], params.age);
+	if (values.size() == 5 && !params.all_ages){
+		parsed = parsed && Util::string_to_something(values[3], params.age_min);
+		parsed = parsed && Util::string_to_something(values[4], params.age_max);
+	}
+
+	if (!parsed){
+		// The first line of a file may be a header
+		if (line_no == 1 && !streaming){
+			site.ignored = true;
+			return;
+		}
+
+		stringstream msg;
+		msg << "Parse error on line " << line_no << ": expecting id, latitude, longitude, and either age or min age and max age";
+		site.error_code = ERROR_PARSE;
+		site.error = msg.str();
+		return;
+	}
+
+	_validateSite(site);
+}
+
+/**
+ * Parses a request in JSON format (a single object with the site and ages, see #stream) into
+ * a site, and validates its parameters
+ */
+void PLSitesBatch::_parseJSONLine(const string& line, SiteResult& site) const {
+	site.json = true;
+
+	PLParameters& params = site.params;
+	params = _defaults;
+	params.site_latitude = params.site_longitude = -9999;
+	params.age = params.age_min = params.age_max = -9999;
+
+	try {
+		boost::property_tree::ptree request;
+		istringstream line_stream(line);
+		boost::property_tree::read_json(line_stream, request);
+
+		for (const auto& field : request){
+			const string& key = field.first;
+			const string value = field.second.data();
+			if (!field.second.empty()) throw Exception("unexpected nested value for '" + key + "'");
+
+			bool parsed = true;
+			if (key == "id") site.id = value;
+			else if (key == "site-lat"){
+				site.latitude = value;
+				parsed = Util::string_to_something(value, params.site_latitude);
+			} else if (key == "site-lon"){
+				site.longitude = value;
+				parsed = Util::string_to_something(value, params.site_longitude);
+			}
+			else if (key == "age") parsed = Util::string_to_something(value, params.age);
+			else if (key == "age-pm") parsed = Util::string_to_something(value, params.age_pm);
+			else if (key == "min-age") parsed = Util::string_to_something(value, params.age_min);
+			else if (key == "max-age") parsed = Util::string_to_something(value, params.age_max);
+			else if (key == "all-ages"){
+				parsed = (value == "true" || value == "false");
+				params.all_ages = (value == "true");
+			} else {
+				throw Exception("unknown field '" + key + "'");
+			}
+
+			if (!parsed) throw Exception("invalid value for '" + key + "': '" + value + "'");
+		}
+	} catch (exception& ex){
+		site.error_code = ERROR_PARSE;
+		site.error = string("Parse error in JSON request: ") + ex.what();
+		return;
+	}
+
+	_validateSite(site);
+}
+
+void PLSitesBatch::_validateSite(SiteResult& site) {
+	string validate_err;
+	if (!site.params.validate(validate_err)){
+		site.error_code = ERROR_INVALID_PARAMETERS;
+		site.error = validate_err;
+	}
+}
+
+/**
+ * Computes the paleolatitude of a site, of which the plate has been determined already
+ */
+void PLSitesBatch::_computeSite(SiteResult& site) const {
+	if (site.plate->isUnconstrained()){
+		site.error_code = ERROR_UNCONSTRAINED_PLATE;
+		site.error = "site is located on an unconstrained plate";
+		return;
+	}
+
+	PaleoLatitude pl(&site.params, _dataset);
+	try {
+		if (!pl.compute(site.plate)){
+			site.error_code = ERROR_NO_DATA;
+			site.error = "insufficient data available for the requested age(s)";
+			return;
+		}
+	} catch (exception& ex){
+		site.error_code = ERROR_COMPUTATION;
+		site.error = ex.what();
+		return;
+	}
+
+	if (site.params.all_ages){
+		site.entries = pl.getRelevantPaleolatitudeEntries();
+	} else {
+		site.entries.push_back(pl.getPaleoLatitude());
+	}
+}
+
+string PLSitesBatch::_csvRows(const SiteResult& result) {
+	const Stats::Timer timer(Stats::WRITE_OUTPUT);
+
+	if (result.error_code != OK) return _errorRow(result.id, result.latitude, result.longitude, result.error_code, result.error);
+
+	TextBuffer rows;
+	for (const PaleoLatitude::PaleoLatitudeEntry& entry : result.entries){
+		rows.append(result.id).append(';').append(result.latitude).append(';').append(result.longitude).append(';');
+		rows.appendInteger(result.plate->getId()).append(';');
+
+		if (entry.age_years >= 0) rows.appendFixed(entry.age_years / 1000000.0, 2);
+		rows.append(';');
+		if (entry.age_years_lower_bound >= 0) rows.appendFixed(entry.age_years_lower_bound / 1000000.0, 2);
+		rows.append(';');
+		if (entry.age_years_upper_bound >= 0) rows.appendFixed(entry.age_years_upper_bound / 1000000.0, 2);
+		rows.append(';');
+
+		if (PaleoLatitude::is_valid_latitude(entry.palat) && entry.age_years >= 0) rows.appendFixed(entry.palat, 5);
+		rows.append(';');
+		if (PaleoLatitude::is_valid_latitude(entry.palat_min)) rows.appendFixed(entry.palat_min, 5);
+		rows.append(';');
+		if (PaleoLatitude::is_valid_latitude(entry.palat_max)) rows.appendFixed(entry.palat_max, 5);
+		rows.append(';');
+
+		rows.appendInteger((int) OK).append(";\n");
+	}
+
+	return rows.str();
+}
+
+string PLSitesBatch::_jsonRow(const SiteResult& result) {
+	const Stats::Timer timer(Stats::WRITE_OUTPUT);
+
+	stringstream row;
+	row.setf(ios::fixed, ios::floatfield);
+	row << "{\"id\":" << _jsonString(result.id);
+
+	if (result.error_code != OK){
+		string clean_message = boost::trim_copy(result.error);
+		boost::replace_all(clean_message, "\n", " ");
+
+		row << ",\"error_code\":" << result.error_code << ",\"error\":" << _jsonString(clean_message) << "}" << endl;
+		return row.str();
+	}
+
+	row << ",\"plate_id\":" << result.plate->getId() << ",\"error_code\":" << OK << ",\"results\":[";
+
+	// Values that are not available are written as null
+	auto write_age = [&row](long age_years){
+		row.precision(2);
+		if (age_years >= 0) row << (age_years / 1000000.0);
+		else row << "null";
+	};
+	auto write_latitude = [&row](double latitude, bool available){
+		row.precision(5);
+		if (available && PaleoLatitude::is_valid_latitude(latitude)) row << latitude;
+		else row << "null";
+	};
+
+	for (size_t i = 0; i < result.entries.size(); i++){
+		const PaleoLatitude::PaleoLatitudeEntry& entry = result.entries[i];
+		if (i > 0) row << ",";
+
+		row << "{\"age\":";
+		write_age(entry.age_years);
+		row << ",\"min_age\":";
+		write_age(entry.age_years_lower_bound);
+		row << ",\"max_age\":";
+		write_age(entry.age_years_upper_bound);
+		row << ",\"latitude\":";
+		write_latitude(entry.palat, entry.age_years >= 0);
+		row << ",\"lower_bound\":";
+		write_latitude(entry.palat_min, true);
+		row << ",\"upper_bound\":";
+		write_latitude(entry.palat_max, true);
+		row << "}";
+	}
+
+	row << "]}" << endl;
+	return row.str();
+}
+
+string PLSitesBatch::_errorRow(const string& id, const string& latitude, const string& longitude, ErrorCode error_code, const string& message) {
+	// Keep the error message on a single line, and in a single column
+	string clean_message = boost::trim_copy(message);
+	boost::replace_all(clean_message, "\n", " ");
+	boost::replace_all(clean_message, ";", ",");
+
+	stringstream row;
+	row << id << ";" << latitude << ";" << longitude << ";;;;;;;;" << error_code << ";" << clean_message << endl;
+	return row.str();
+}
+
+string PLSitesBatch::_jsonString(const string& value) {
+	stringstream res;
+	res << '"';
+	for (const char c : value){
+		if (c == '"' || c == '\\'){
+			res << '\\' << c;
+		} else if (static_cast<unsigned char>(c) < 0x20){
+			res << "\\u" << hex << setw(4) << setfill('0') << static_cast<int>(c) << dec;
+		} else {
+			res << c;
+		}
+	}
+	res << '"';
+	return res.str();
+}
@@ -0,0 +1,119 @@
+/*
+ * PLSitesBatch.h
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: Sebastiaan J. van Schaik
+ */
+
+#ifndef PLSITESBATCH_H_
+#define PLSITESBATCH_H_
+
+#include <string>
+#include <vector>
+#include <iostream>
+#include "PLParameters.h"
+
+using namespace std;
+
+namespace paleo_latitude {
+
+class PLDataset;
+class ThreadPool;
+
+/**
+ * Computes the paleolatitude of a series of sites using a single dataset. Sites are read from
+ * CSV input (separated by ';' or ','), with one site per line:
+ *
+ *   id;latitude;longitude;age           (age in Myr)
+ *   id;latitude;longitude;min age;max age
+ *   id;latitude;longitude               (when computing all ages, any age columns are ignored)
+ *
+ * Every site yields one line of output (or one line per age when computing all ages), which
+ * is written as soon as the site has been processed. Sites that cannot be processed yield a
+ * line with an error code, rather than aborting the batch.
+ */
+class PLSitesBatch {
+public:
+	enum ErrorCode {
+		OK = 0,
+		ERROR_PARSE = 1,				// line could not be parsed
+		ERROR_INVALID_PARAMETERS = 2,	// invalid site coordinates or ages
+		ERROR_NO_PLATE = 3,				// no (single) plate found for site
+		ERROR_UNCONSTRAINED_PLATE = 4,	// site is located on an unconstrained plate
+		ERROR_NO_DATA = 5,				// insufficient data for requested age(s)
+		ERROR_COMPUTATION = 6			// any other error
+	};
+
+	/**
+	 * Creates a batch using the given dataset (not owned by the batch). The parameters provide
+	 * defaults for all sites (e.g. all_ages or age_pm); site coordinates and ages are taken
+	 * from the input. Sites are processed using the given number of threads (0 = one per
+	 * CPU core); the output is always in the order of the input.
+	 */
+	PLSitesBatch(const PLDataset* dataset, const PLParameters& defaults, unsigned int num_threads = 1);
+
+	/**
+	 * Processes all sites in the input and writes the results (including a header) to the
+	 * output. Returns the number of sites that could not be processed.
+	 */
+	unsigned int process(istream& input, ostream& output) const;
+	unsigned int process(const string& input_filename, ostream& output) const;
+
+	/**
+	 * Processes requests as they arrive (e.g. from a co-process), one request per line, and
+	 * writes one line of output per request (without a header). Requests are either CSV lines
+	 * (as above, yielding the same output) or JSON objects, such as:
+	 *
+	 *   {"id": "s1", "site-lat": 52.5, "site-lon": 5.1, "age": 50}
+	 *   {"id": "s2", "site-lat": 52.5, "site-lon": 5.1, "min-age": 40, "max-age": 60}
+	 *   {"id": "s3", "site-lat": 52.5, "site-lon": 5.1, "all-ages": true}
+	 *
+	 * JSON requests yield a JSON object with the results of all ages in a single line:
+	 *
+	 *   {"id":"s1","plate_id":315,"error_code":0,"results":[{"age":50.00,"min_age":50.00,...}]}
+	 *   {"id":"s4","error_code":3,"error":"No plate found for site ..."}
+	 *
+	 * (When computing all ages, a CSV request yields one line per age; use JSON to get a single
+	 * line.) Every line of input yields output, including empty lines and comments (with error
+	 * code ERROR_PARSE). Requests that have already arrived completely are processed together,
+	 * and the output is flushed after every flush_interval requests, and whenever no further
+	 * complete requests are waiting: a client never waits for the response to a request it has
+	 * sent. Returns the number of requests that could not be processed.
+	 */
+	unsigned int stream(istream& input, ostream& output, size_t flush_interval = 1) const;
+
+	static string getHeader();
+
+private:
+	const PLDataset* _dataset;
+	const PLParameters _defaults;
+	const unsigned int _num_threads;
+
+	/**
+	 * Number of lines read (and processed in parallel) at once, and the number of lines per
+	 * task when processing a block of lines using multiple threads
+	 */
+	const static size_t BLOCK_SIZE;
+	const static size_t TASK_SIZE;
+
+	/**
+	 * Site, as provided in the input (including its parameters), and the outcome of its
+	 * computation
+	 */
+	struct SiteResult;
+
+	void _processLines(const vector<string>& lines, unsigned int first_line_no, bool streaming, ThreadPool* pool, vector<string>& rows, vector<ErrorCode>& error_codes) const;
+	void _parseLine(const string& line, unsigned int line_no, bool streaming, SiteResult& site) const;
+	void _parseJSONLine(const string& line, SiteResult& site) const;
+	static void _validateSite(SiteResult& site);
+	void _computeSite(SiteResult& site) const;
+
+	static string _csvRows(const SiteResult& result);
+	static string _jsonRow(const SiteResult& result);
+	static string _errorRow(const string& id, const string& latitude, const string& longitude, ErrorCode error_code, const string& message);
+	static string _jsonString(const string& value);
+};
+
+};
+
+#endif /* PLSITESBATCH_H_ */
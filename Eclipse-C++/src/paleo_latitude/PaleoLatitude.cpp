@@ -25,25 +25,24 @@
 #include "../debugging-macros.h"
 #include "PaleoLatitude.h"
 
-#include <boost/numeric/ublas/matrix.hpp>
-#include <boost/numeric/ublas/assignment.hpp>
-#include <boost/numeric/ublas/vector.hpp>
-
 #include <iostream>
 #include <cmath>
 #include <cstdlib>
 
 #include "PLPlate.h"
+#include "PLDataset.h"
 #include "PLParameters.h"
 #include "PLPlates.h"
 #include "PLPolarWanderPaths.h"
 #include "../util/Logger.h"
+#include "../util/Stats.h"
+#include "../util/TextBuffer.h"
 #include "PLEulerPolesReconstructions.h"
 
 using namespace paleo_latitude;
 using namespace std;
 
-namespace bnu = boost::numeric::ublas;
+const size_t PaleoLatitude::OUTPUT_BLOCK_SIZE = 65536;
 
 PaleoLatitude::PaleoLatitude() {
 
@@ -51,20 +50,23 @@ PaleoLatitude::PaleoLatitude() {
 
 
 PaleoLatitude::~PaleoLatitude() {
-	delete _pwp;
-	delete _plates;
-	delete _euler;
+	if (_owns_dataset) delete _dataset;
 
+	_dataset = NULL;
 	_pwp = NULL;
 	_plates = NULL;
 	_euler = NULL;
 }
 
 
-PaleoLatitude::PaleoLatitude(PLParameters* params) : _params(params) {
-	_pwp = PLPolarWanderPaths::readFromFile(params->input_apwp_csv);
-	_plates = PLPlates::readFromFile(params->input_plates_file);
-	_euler = PLEulerPolesReconstructions::readFromFile(params->input_euler_rotation_csv);
+PaleoLatitude::PaleoLatitude(PLParameters* params) : PaleoLatitude(params, PLDataset::readFromFiles(params)) {
+	_owns_dataset = true;
+}
+
+PaleoLatitude::PaleoLatitude(PLParameters* params, const PLDataset* dataset) : _params(params), _dataset(dataset) {
+	_pwp = dataset->getPolarWanderPaths();
+	_plates = dataset->getPlates();
+	_euler = dataset->getEulerPolesReconstructions();
 }
 
 PLParameters* PaleoLatitude::set() {
@@ -79,14 +81,23 @@ bool PaleoLatitude::compute(){
 	}
 
 	// Determine plate
+	return compute(_plates->findPlate(_params->site_latitude, _params->site_longitude));
+}
+
+bool PaleoLatitude::compute(const PLPlate* plate){
+	string validate_err;
+	if (!_params->validate(validate_err)){
+		throw Exception(validate_err);
+	}
+
 	const Coordinate site(_params->site_latitude, _params->site_longitude);
-	_plate = _plates->findPlate(site);
+	_plate = plate;
 
-	Logger::info << "Site " << site.to_string() << " (lat,lon) is located on plate '" << _plate->getName() << "' (id: " << _plate->getId() << ")" << endl;
+	__LOG(Logger::info) << "Site " << site.to_string() << " (lat,lon) is located on plate '" << _plate->getName() << "' (id: " << _plate->getId() << ")" << endl;
 
-	if (_plate->getId() == 1001){
+	if (_plate->isUnconstrained()){
 		// Unconstrained plate - can't do anything with that
-		Logger::error << "The provided site is located on an unconstrained plate - cannot compute paleolatitude" << endl;
+		__LOG(Logger::error) << "The provided site is located on an unconstrained plate - cannot compute paleolatitude" << endl;
 		return false;
 	}
 
@@ -97,7 +108,7 @@ bool PaleoLatitude::compute(){
 	const long age_max_years = _params->getMaxAgeInYears();
 
 	// Read the relevant ages from the Euler rotations table
-	vector<unsigned int> compute_ages;
+	ArrayView<unsigned int> compute_ages;
 	if (_params->all_ages){
 		compute_ages = _euler->getRelevantAges(_plate, 0, 99999);
 	} else if (age_min_myr >= 0 && age_max_myr >= 0) {
@@ -107,25 +118,32 @@ bool PaleoLatitude::compute(){
 	}
 
 	if (compute_ages.size() == 0){
-		Logger::error << "Insufficient data available to compute paleolatitude for site (" << _params->site_latitude << "," << _params->site_longitude << ") on plate " << _plate->getName() << " (id: " << _plate->getId() << ") for the requested age(s). Maybe try computing for all ages?";
+		__LOG(Logger::error) << "Insufficient data available to compute paleolatitude for site (" << _params->site_latitude << "," << _params->site_longitude << ") on plate " << _plate->getName() << " (id: " << _plate->getId() << ") for the requested age(s). Maybe try computing for all ages?" << endl;
 		return false;
 	}
 
-	Logger::info << "Computing lower and upper bound of paleolatitude for the following ages: ";
-	for (unsigned int rel_age_myr : compute_ages) Logger::info << rel_age_myr << " ";
-	Logger::info << endl;
+	__LOG(Logger::info) << "Computing lower and upper bound of paleolatitude for the following ages: ";
+	for (unsigned int rel_age_myr : compute_ages) __LOG(Logger::info) << rel_age_myr << " ";
+	__LOG(Logger::info) << endl;
 
 	// Paleolatitudes for a series of ages:
 	// age, paleolat_min, paleolat, paleolat_max
-	_result.clear();
-	_result.reserve(compute_ages.size() * 2);
+	const Vector3 site_vector = Vector3::fromLatLon(site.latitude, site.longitude);
 
-	// Compute values for relevant ages, interpolated values will be added later
-	for (unsigned int i = 0; i < compute_ages.size(); i++){
-		const unsigned int curr_age_myr = compute_ages[i];
+	if (_params->all_ages){
+		// All ages of the plate: single pass over its time series
+		_calculatePaleolatitudeTimeSeries(site_vector, _plate);
+	} else {
+		_result.clear();
+		_result.reserve(compute_ages.size() * 2);
+
+		// Compute values for relevant ages, interpolated values will be added later
+		for (unsigned int i = 0; i < compute_ages.size(); i++){
+			const unsigned int curr_age_myr = compute_ages[i];
 
-		const vector<PaleoLatitudeEntry> palats = _calculatePaleolatitudeRangeForAge(site, _plate, curr_age_myr);
-		_result.insert(std::end(_result), std::begin(palats), std::end(palats));
+			const vector<PaleoLatitudeEntry> palats = _calculatePaleolatitudeRangeForAge(site_vector, _plate, curr_age_myr);
+			_result.insert(std::end(_result), std::begin(palats), std::end(palats));
+		}
 	}
 
 	// Sort the results (from more recent to longer ago)
@@ -172,8 +190,8 @@ bool PaleoLatitude::compute(){
 		sort(_result.begin(), _result.end(), PaleoLatitude::PaleoLatitudeEntry::compareByAge);
 	}
 
-	for (PaleoLatitudeEntry entry : _result){
-		Logger::info << entry.to_string() << endl;
+	for (const PaleoLatitudeEntry& entry : _result){
+		__LOG(Logger::info) << entry.to_string() << endl;
 	}
 
 	return true;
@@ -181,194 +199,93 @@ bool PaleoLatitude::compute(){
 
 
 
+/**
+ * Computes the paleolatitude of the site for every Euler entry of the plate (i.e. for all ages)
+ * and stores them in _result, in the same order as _calculatePaleolatitudeRangeForAge() would
+ * for every age in turn
+ */
+void PaleoLatitude::_calculatePaleolatitudeTimeSeries(const Vector3& site, const PLPlate* plate) {
+	const PLEulerPolesReconstructions::TimeSeries series = _euler->getTimeSeries(plate);
+	const bool has_paleopoles = !series.paleopoles.empty();
+
+	// Preallocate room for interpolated entries as well, which compute() appends later
+	_result.clear();
+	_result.reserve(series.entries.size() * 2);
+	_result.resize(series.entries.size());
+
+	for (size_t i = 0; i < series.entries.size(); i++){
+		const PLEulerPolesReconstructions::EPEntry* euler_entry = series.entries[i];
+
+		if (has_paleopoles && series.paleopoles[i].available){
+			_result[i] = _calculatePaleolatitudeRange(site, euler_entry->age, euler_entry, series.paleopoles[i]);
+		} else {
+			// Not precomputed: rotate the reference pole now (getEntry() throws if there is no APWP data)
+			const PLPolarWanderPaths::PWPEntry* pwp_entry = _pwp->getEntry(euler_entry->rotation_rel_to_plate_id, euler_entry->age);
+			_result[i] = _calculatePaleolatitudeRange(site, euler_entry->age, euler_entry, PLEulerPolesReconstructions::computePaleopole(*euler_entry, *pwp_entry));
+		}
+	}
+}
+
 /**
  * Step 3
  */
-const vector<PaleoLatitude::PaleoLatitudeEntry> PaleoLatitude::_calculatePaleolatitudeRangeForAge(const Coordinate& site, const PLPlate* plate, unsigned int age_myr) const {
-	__IF_DEBUG(Logger::debug << "Calculating paleolatitude for (lat=" << site.latitude << ",lon=" << site.longitude << ") for age=" << age_myr << endl);
+const vector<PaleoLatitude::PaleoLatitudeEntry> PaleoLatitude::_calculatePaleolatitudeRangeForAge(const Vector3& site, const PLPlate* plate, unsigned int age_myr) const {
+	__IF_DEBUG(__LOG(Logger::debug) << "Calculating paleolatitude for (lat=" << site.latitude() << ",lon=" << site.longitude() << ") for age=" << age_myr << endl);
 
 	// Get Euler pole and reference pole. For some ages, this will yield multiple (up to two)
 	// Euler poles (relative to different plates)
-	const vector<const PLEulerPolesReconstructions::EPEntry*> euler_entries = _euler->getEntries(plate, age_myr);
+	const ArrayView<const PLEulerPolesReconstructions::EPEntry*> euler_entries = _euler->getEntries(plate, age_myr);
 
 	vector<PaleoLatitude::PaleoLatitudeEntry> res;
 	for (const PLEulerPolesReconstructions::EPEntry* euler_entry : euler_entries){
-		const PLPolarWanderPaths::PWPEntry* pwp_entry = _pwp->getEntry(euler_entry->rotation_rel_to_plate_id, age_myr);
-		res.push_back(_calculatePaleolatitudeRange(site, plate, age_myr, euler_entry, pwp_entry));
+		const PLEulerPolesReconstructions::Paleopole* paleopole = _euler->getPaleopole(euler_entry);
+
+		PLEulerPolesReconstructions::Paleopole computed_paleopole;
+		if (paleopole == NULL){
+			// Not precomputed: rotate the reference pole now (getEntry() throws if there is no APWP data)
+			const PLPolarWanderPaths::PWPEntry* pwp_entry = _pwp->getEntry(euler_entry->rotation_rel_to_plate_id, age_myr);
+			computed_paleopole = PLEulerPolesReconstructions::computePaleopole(*euler_entry, *pwp_entry);
+			paleopole = &computed_paleopole;
+		}
+
+		res.push_back(_calculatePaleolatitudeRange(site, age_myr, euler_entry, *paleopole));
 	}
 
 	return res;
 }
 
-const PaleoLatitude::PaleoLatitudeEntry PaleoLatitude::_calculatePaleolatitudeRange(const Coordinate& site, const PLPlate* plate, unsigned int age_myr, const PLEulerPolesReconstructions::EPEntry* euler_entry, const PLPolarWanderPaths::PWPEntry* pwp_entry) const {
-	const double lambda_s = site.latitude;
-	const double lambda_s_rad = _deg2rad(lambda_s);
-	const double phi_s  = site.longitude;
-	const double phi_s_rad = _deg2rad(phi_s);
-
-	const double lambda_e = euler_entry->latitude;
-	const double lambda_e_rad = _deg2rad(lambda_e);
-	const double phi_e = euler_entry->longitude;
-	const double phi_e_rad = _deg2rad(phi_e);
-	const double omega = euler_entry->rotation;
-	const double omega_rad = _deg2rad(omega);
-
+const PaleoLatitude::PaleoLatitudeEntry PaleoLatitude::_calculatePaleolatitudeRange(const Vector3& site, unsigned int age_myr, const PLEulerPolesReconstructions::EPEntry* euler_entry, const PLEulerPolesReconstructions::Paleopole& paleopole) const {
+	const Stats::Timer timer(Stats::ROTATION);
 
-	// Get latitude and longitude of reference pole from
-	// relevant entry from apparent polar wander paths
-
-	const double lambda_p = pwp_entry->latitude;
-	const double lambda_p_rad = _deg2rad(lambda_p);
-	const double phi_p  = pwp_entry->longitude;
-	const double phi_p_rad = _deg2rad(phi_p);
-	const double a95 = pwp_entry->a95;
+	const double a95 = paleopole.a95;
 	const bool compute_bounds = (a95 > 0.0000001);
 
-	const double theta_e = 90 - lambda_e;		// colatitude of Euler pole
-	const double theta_e_rad = _deg2rad(theta_e);
-	const double theta_p = 90 - lambda_p;		// colatitude of reference pole
-	const double theta_p_rad = _deg2rad(theta_p);
-
-	__IF_DEBUG(Logger::debug << "λ_s = " << lambda_s << " (" << lambda_s_rad << "), φ_s = " << phi_s << " (" << phi_s_rad << "), age = " << age_myr << " (Myr)" << endl;)
-	__IF_DEBUG(Logger::debug << "λ_E = " << lambda_e << " (" << lambda_e_rad << "), φ_E = " << phi_e << " (" << phi_e_rad << "), Ω = " << omega << " (" << omega_rad << ")" << endl;)
-	__IF_DEBUG(Logger::debug << "λ_p = " << lambda_p << " (" << lambda_p_rad << "), φ_p = " << phi_p << " (" << phi_p_rad << "), A95 = " << a95 << (compute_bounds ? "" : " (n/a)") <<  endl;)
-	__IF_DEBUG(Logger::debug << "θ_E = " << theta_e << " (" << theta_e_rad << "), θ_p = " << theta_p << " (" << theta_p_rad << ")" << endl;)
-
-	// Unit vectors
-	const bnu::unit_vector<unsigned int> vec_x_unit(3,0); //  [1, 0, 0]
-	const bnu::unit_vector<unsigned int> vec_y_unit(3,1); //  [0, 1, 0]
-	const bnu::unit_vector<unsigned int> vec_z_unit(3,2); //  [0, 0, 1]
-
-
-	bnu::vector<double> vec_theta_e (3);
-	vec_theta_e <<=	cos(phi_e_rad) * cos(theta_e_rad),
-					sin(phi_e_rad) * cos(theta_e_rad),
-					-sin(theta_e_rad);
-
-	// Consistency check:
-	const double vec_theta_e_sqrt = sqrt(pow(vec_theta_e[0],2.0) + pow(vec_theta_e[1],2.0) + pow(vec_theta_e[2],2.0));
-	__IF_DEBUG(Logger::debug << "θ_e[] = [" << vec_theta_e[0] << "," << vec_theta_e[1] << "," << vec_theta_e[2] << "]  (square root of squared sums: " << vec_theta_e_sqrt << ")" << endl;)
-	if (!Util::double_eq(vec_theta_e_sqrt, 1)){
-		Exception ex;
-		ex << "Consistency check failed: square root of squared sums of θ_E[] vector elements does not equal 1, but " << vec_theta_e_sqrt << "?";
-		throw ex;
-	}
-
-
-	bnu::vector<double> vec_phi_e (3);
-	vec_phi_e <<=	-sin(phi_e_rad),
-					cos(phi_e_rad),
-					0;
-
-	// Consistency check:
-	const double vec_phi_e_sqrt = sqrt(pow(vec_phi_e[0],2.0) + pow(vec_phi_e[1],2.0) + pow(vec_phi_e[2],2.0));
-	__IF_DEBUG(Logger::debug << "φ_e[] = [" << vec_phi_e[0] << "," << vec_phi_e[1] << "," << vec_phi_e[2] << "]  (square root of squared sums: " << vec_theta_e_sqrt << ")" << endl;)
-	if (!Util::double_eq(vec_phi_e_sqrt, 1)){
-		Exception ex;
-		ex << "Consistency check failed: square root of squared sums of r_E[] vector elements does not equal 1, but " << vec_phi_e_sqrt << "?";
-		throw ex;
-	}
-
-	bnu::vector<double> vec_r_e (3);	// rotation axis
-	vec_r_e <<=	cos(phi_e_rad) * sin(theta_e_rad),
-				sin(phi_e_rad) * sin(theta_e_rad),
-				cos(theta_e_rad);
-
-	// Consistency check:
-	const double vec_r_e_sqrt = sqrt(pow(vec_r_e[0],2.0) + pow(vec_r_e[1],2.0) + pow(vec_r_e[2],2.0));
-	__IF_DEBUG(Logger::debug << "r_e[] = [" << vec_r_e[0] << "," << vec_r_e[1] << "," << vec_r_e[2] << "]  (square root of squared sums: " << vec_theta_e_sqrt << ")" << endl;)
-	if (!Util::double_eq(vec_r_e_sqrt, 1)){
-		Exception ex;
-		ex << "Consistency check failed: square root of squared sums of r_E[] vector elements does not equal 1, but " << vec_r_e_sqrt << "?";
-		throw ex;
-	}
-
-	// Transformation matrix:
-	bnu::matrix<double> L(3, 3);
-	L(0,0) = inner_prod(vec_theta_e, vec_x_unit);
-	L(1,0) = inner_prod(vec_theta_e, vec_y_unit);
-	L(2,0) = inner_prod(vec_theta_e, vec_z_unit);
-
-	L(0,1) = inner_prod(vec_phi_e, vec_x_unit);
-	L(1,1) = inner_prod(vec_phi_e, vec_y_unit);
-	L(2,1) = inner_prod(vec_phi_e, vec_z_unit);
-
-	L(0,2) = inner_prod(vec_r_e, vec_x_unit);
-	L(1,2) = inner_prod(vec_r_e, vec_y_unit);
-	L(2,2) = inner_prod(vec_r_e, vec_z_unit);
-
-	__IF_DEBUG(Logger::debug << "Transformation matrix L: " << _ppMatrix(L) << endl;)
+	__IF_DEBUG(__LOG(Logger::debug) << "site = " << _ppVector(site) << ", age = " << age_myr << " (Myr)" << endl;)
+	__IF_DEBUG(__LOG(Logger::debug) << "λ_E = " << euler_entry->latitude << ", φ_E = " << euler_entry->longitude << ", Ω = " << euler_entry->rotation << ", A95 = " << a95 << (compute_bounds ? "" : " (n/a)") << endl;)
+	__IF_DEBUG(__LOG(Logger::debug) << "xyz_p_rot = " << _ppVector(paleopole.pole) << "     (= reference pole after Euler pole rotation)" << endl;)
 
-	const bnu::matrix<double> L_trans = trans(L);
-	__IF_DEBUG(Logger::debug << "L_transposed: " << _ppMatrix(L_trans) << endl;)
+	// Paleolatitude: the sine of the paleolatitude is the inner product of the site and the
+	// rotated reference pole (clamped to [-1,1] to guard against rounding errors)
+	const double lambda_numerator = max(-1.0, min(1.0, site.dot(paleopole.pole)));
+	const double lambda_denominator = sqrt(1 - lambda_numerator * lambda_numerator);
 
-	// Reference pole to Cartesian coordinates:
-	bnu::vector<double> vec_xyz_p(3);
-	vec_xyz_p <<=	cos(phi_p_rad) * sin(theta_p_rad),
-					sin(phi_p_rad) * sin(theta_p_rad),
-					cos(theta_p_rad);
-
-	__IF_DEBUG(Logger::debug << "xyz[] = " << _ppVector(vec_xyz_p) << "    (reference pole -> cartesian coordinates)"<< endl;)
-
-
-	bnu::matrix<double> rot_matrix(3,3);
-	rot_matrix <<=	cos(-omega_rad),-sin(-omega_rad),	0,
-					sin(-omega_rad),cos(-omega_rad),	0,
-					0,			0,				1;
-
-
-	__IF_DEBUG(Logger::debug << "Rotation matrix R: " << _ppMatrix(rot_matrix) << endl;)
-
-	const bnu::matrix<double> L_x_rot = prod(L, rot_matrix);
-	__IF_DEBUG(Logger::debug << "L*R: " << _ppMatrix(L_x_rot) << endl;)
-
-	// Multiply transposed L (Lt) with cartesian coordinates of reference pole (xyz)
-	const bnu::vector<double> Lt_x_xyz = prod(L_trans, vec_xyz_p);
-	__IF_DEBUG(Logger::debug << "L_trans * xyz: " << _ppVector(Lt_x_xyz) << "     (transposed L * cartesian coordinates reference pole)" << endl;)
-
-	const bnu::vector<double> vec_xyz_p_rot = prod(L_x_rot, Lt_x_xyz);
-	__IF_DEBUG(Logger::debug << "xyz_p_rot = " << _ppVector(vec_xyz_p_rot) << "     (= result of Euler pole rotation)" << endl;)
-
-	const double& x_p_rot = vec_xyz_p_rot(0);
-	const double& y_p_rot = vec_xyz_p_rot(1);
-	const double& z_p_rot = vec_xyz_p_rot(2);
-
-	// if x_p_rot < 0: 						phi_p_rot = atan(y_p_rot / x_p_rot) + pi;
-	// if x_p_rot >= 0 and y_p_rot >= 0: 	phi_p_rot = atan(y_p_rot / x_p_rot)
-	// if x_p_rot >= 0 and y_p_rot <= 0:	phi_p_rot = atan(y_p_rot / x_p_rot) + 2 * pi;
-	double phi_p_rot_rad = atan(y_p_rot / x_p_rot);
-	if (x_p_rot < 0) phi_p_rot_rad += M_PI;
-	if (x_p_rot >= 0 and y_p_rot <= 0) phi_p_rot_rad += 2 * M_PI;
-
-	const double theta_p_rot_rad = acos(z_p_rot);
-
-	const double lambda_p_rot_rad = 0.5 * M_PI - theta_p_rot_rad;
-
-	__IF_DEBUG(Logger::debug << "φ_p_rot = " << phi_p_rot_rad << ", θ_p_rot = " << theta_p_rot_rad << ", λ_p_rot = " << lambda_p_rot_rad << " (radians)" << endl;)
-
-
-	// Paleolatitude
-	const double lambda_numerator = sin(lambda_p_rot_rad) * sin(lambda_s_rad) +
-			cos(lambda_p_rot_rad) * cos(lambda_s_rad) * cos(phi_p_rot_rad - phi_s_rad);
-	const double lambda_denominator = sqrt(1 - pow(lambda_numerator, 2.0));
-
-	const double lambda_rad = atan(lambda_numerator / lambda_denominator);
+	const double lambda_rad = asin(lambda_numerator);
 	const double lambda = _rad2deg(lambda_rad);
 
 	// Uncertainty in paleolatitude
 	double lambda_min, lambda_max;
 
 	if (compute_bounds){
-		// A95 data available for computation of error bounds
-		const double delta_i = a95 * 2.0 / (1 + 3 * pow(cos(0.5*M_PI - lambda_rad), 2.0));
+		// A95 data available for computation of error bounds (note: cos(0.5π - Λ) = sin(Λ))
+		const double delta_i = a95 * 2.0 / (1 + 3 * lambda_numerator * lambda_numerator);
 		const double delta_i_rad = _deg2rad(delta_i);
-		__IF_DEBUG(Logger::debug << "Λ = " << lambda_rad << " (radians), Δ_I = " << delta_i << " degrees, Δ_I = " << delta_i_rad << " radians" << endl;)
+		__IF_DEBUG(__LOG(Logger::debug) << "Λ = " << lambda_rad << " (radians), Δ_I = " << delta_i << " degrees, Δ_I = " << delta_i_rad << " radians" << endl;)
 
 		// Upper and lower bounds for paleolatitude
 
 		// Inclination of geomagnetic field (I)
 		const double field_incl_rad = atan((2 * lambda_numerator) / lambda_denominator);
-		__IF_DEBUG(Logger::debug << "I = " << field_incl_rad << " (inclination of geomagnetic field in radians)" << endl;)
+		__IF_DEBUG(__LOG(Logger::debug) << "I = " << field_incl_rad << " (inclination of geomagnetic field in radians)" << endl;)
 
 		const double lambda_min_rad = atan(0.5 * tan(field_incl_rad - delta_i_rad));
 		const double lambda_max_rad = atan(0.5 * tan(field_incl_rad + delta_i_rad));
@@ -378,8 +295,8 @@ const PaleoLatitude::PaleoLatitudeEntry PaleoLatitude::_calculatePaleolatitudeRa
 		lambda_max = _rad2deg(lambda_max_rad);
 
 
-		__IF_DEBUG(Logger::debug << "Λ_min = " << lambda_min_rad << ", Λ = " << lambda_rad << ", Λ_max = " << lambda_max_rad << " (radians)" << endl;)
-		__IF_DEBUG(Logger::debug << "Λ_min = " << lambda_min << ", Λ = " << lambda << ", Λ_max = " << lambda_max << " (degrees)" << endl;)
+		__IF_DEBUG(__LOG(Logger::debug) << "Λ_min = " << lambda_min_rad << ", Λ = " << lambda_rad << ", Λ_max = " << lambda_max_rad << " (radians)" << endl;)
+		__IF_DEBUG(__LOG(Logger::debug) << "Λ_min = " << lambda_min << ", Λ = " << lambda << ", Λ_max = " << lambda_max << " (degrees)" << endl;)
 
 
 		// Check whether either lambda_min or lambda_max is out of bounds, indicating that the lower or upper
@@ -392,7 +309,7 @@ const PaleoLatitude::PaleoLatitudeEntry PaleoLatitude::_calculatePaleolatitudeRa
 			// Lower bound moved over the south pole, then up the other side. Resulting min is then
 			// 85, which should be -85.
 
-			Logger::info << "Applying correction for bounds over south pole: [" << lambda_min << "," << lambda_max << "] becomes ";
+			__LOG(Logger::info) << "Applying correction for bounds over south pole: [" << lambda_min << "," << lambda_max << "] becomes ";
 			if (lambda < 0){
 				// Things went south on the south pole (ba dum tssh)
 				lambda_max = max(-abs(lambda_min), -abs(lambda_max));
@@ -403,11 +320,11 @@ const PaleoLatitude::PaleoLatitudeEntry PaleoLatitude::_calculatePaleolatitudeRa
 				lambda_max = 90;
 			}
 
-			Logger::info << "[" << lambda_min << "," << lambda_max << "]" << endl;
+			__LOG(Logger::info) << "[" << lambda_min << "," << lambda_max << "]" << endl;
 		}
 	} else {
 		// No uncertainty bounds computable due to lack of A95 info
-		__IF_DEBUG(Logger::debug << "not computing error bounds on paleolatitude due to lack of data" << endl;)
+		__IF_DEBUG(__LOG(Logger::debug) << "not computing error bounds on paleolatitude due to lack of data" << endl;)
 
 		lambda_min = -99999;
 		lambda_max = -99999;
@@ -425,6 +342,14 @@ double PaleoLatitude::_rad2deg(const double& rad){
 	return rad * (180.0 / M_PI);
 }
 
+string PaleoLatitude::_ppVector(const Vector3& vector) {
+	stringstream res;
+	res.precision(5);
+	res << fixed;
+	res << "[" << vector.x << "," << vector.y << "," << vector.z << "]";
+	return res.str();
+}
+
 string PaleoLatitude::getVersion(){
 	return PALEOLATITUDE_VERSION;
 }
@@ -441,7 +366,7 @@ void PaleoLatitude::printAbout() {
 	cout << "  In: PLoS ONE, 2015 (http://doi.org/10.1371/journal.pone.0126946)." << endl << endl;
 }
 
-string PaleoLatitude::PaleoLatitudeEntry::to_string() {
+string PaleoLatitude::PaleoLatitudeEntry::to_string() const {
 	stringstream res;
 	double age_myr = (age_years / 1000000.0);
 	res << "PaleoLatitude for age " << age_myr << " (Myr): ";
@@ -471,6 +396,7 @@ string PaleoLatitude::PaleoLatitudeEntry::to_string() {
 PaleoLatitude::PaleoLatitudeEntry PaleoLatitude::PaleoLatitudeEntry::interpolate(
 		const PaleoLatitudeEntry& other_younger,
 		const PaleoLatitudeEntry& other_older, unsigned long age_years) {
+	const Stats::Timer timer(Stats::INTERPOLATION);
 
 	if (other_younger.computed_using_plate_id != other_older.computed_using_plate_id){
 		Exception e;
@@ -510,7 +436,7 @@ const vector<PaleoLatitude::PaleoLatitudeEntry> PaleoLatitude::getRelevantPaleol
 PaleoLatitude::PaleoLatitudeEntry PaleoLatitude::getPaleoLatitude() const {
 	_requireResult();
 
-	__IF_DEBUG(Logger::debug << "Processing " << _result.size() << " results for requested time period" << endl;)
+	__IF_DEBUG(__LOG(Logger::debug) << "Processing " << _result.size() << " results for requested time period" << endl;)
 
 	// The computation might have yielded multiple results, even if only a single
 	// age was requested: if that exact age is not available, then the results will
@@ -519,7 +445,7 @@ PaleoLatitude::PaleoLatitudeEntry PaleoLatitude::getPaleoLatitude() const {
 	PaleoLatitudeEntry aggr;
 	aggr.age_years = 99999; // placeholder to trigger later initialisation
 
-	for (PaleoLatitudeEntry entry : _result){
+	for (const PaleoLatitudeEntry& entry : _result){
 		if (aggr.age_years == 99999){
 			aggr = entry; // initialise with useful values
 			aggr.age_years = -99999;
@@ -556,67 +482,82 @@ void PaleoLatitude::writeKML(const string& filename) {
 }
 
 void PaleoLatitude::writeCSV(ostream& output_stream) {
+	const Stats::Timer timer(Stats::WRITE_OUTPUT);
+
 	_requireResult();
-	output_stream << "age;latitude;lower bound;upper bound;interpolated;relative_to" << endl;
-	output_stream.setf(ios::fixed, ios::floatfield);
 
-	for (PaleoLatitudeEntry entry : _result){
-		output_stream.precision(2);
-		output_stream << entry.getAgeInMYR() << ";";
+	// Rows are composed in a buffer and written in large blocks (without flushing), and the
+	// state of the output stream is not changed
+	TextBuffer buffer;
+	buffer.append("age;latitude;lower bound;upper bound;interpolated;relative_to\n");
 
-		output_stream.precision(5);
-		output_stream << entry.palat << ";";
+	// All rows are usually computed using the same plate: only look up its name once
+	unsigned int label_plate_id = 0;
+	string plate_label;
+
+	for (const PaleoLatitudeEntry& entry : _result){
+		buffer.appendFixed(entry.getAgeInMYR(), 2).append(';');
+		buffer.appendFixed(entry.palat, 5).append(';');
 
-		if (is_valid_latitude(entry.palat_min)) output_stream << entry.palat_min;
-		output_stream << ";";
+		if (is_valid_latitude(entry.palat_min)) buffer.appendFixed(entry.palat_min, 5);
+		buffer.append(';');
 
-		if (is_valid_latitude(entry.palat_max)) output_stream << entry.palat_max;
-		output_stream << ";";
+		if (is_valid_latitude(entry.palat_max)) buffer.appendFixed(entry.palat_max, 5);
+		buffer.append(';');
 
-		output_stream << (entry.is_interpolated ? "1" : "0") << ";";
+		buffer.append(entry.is_interpolated ? "1;" : "0;");
 
 		if (entry.computed_using_plate_id > 0){
-			const string plate_name = _plates->getPlateName(entry.computed_using_plate_id);
-			if (plate_name == ""){
-				output_stream << "Plate " << entry.computed_using_plate_id;
-			} else {
-				output_stream << plate_name << " (" << entry.computed_using_plate_id << ")";
+			if (entry.computed_using_plate_id != label_plate_id){
+				const string plate_name = _plates->getPlateName(entry.computed_using_plate_id);
+				const string plate_id_str = std::to_string(entry.computed_using_plate_id);
+
+				label_plate_id = entry.computed_using_plate_id;
+				plate_label = (plate_name == "") ? "Plate " + plate_id_str : plate_name + " (" + plate_id_str + ")";
 			}
+			buffer.append(plate_label);
 		}
 
-		output_stream << endl;
+		buffer.append('\n');
+		if (buffer.size() >= OUTPUT_BLOCK_SIZE) buffer.writeTo(output_stream);
 	}
+
+	buffer.writeTo(output_stream);
 }
 
 void PaleoLatitude::writeKML(ostream& output_stream) {
+	const Stats::Timer timer(Stats::WRITE_OUTPUT);
+
 	_requireResult();
 
-	output_stream << "<?xml version=\"1.0\" encoding=\"utf-8\" ?>" << endl
-			<< "<kml xmlns=\"http://www.opengis.net/kml/2.2\">" << endl
-			<< "<Document>" << endl
-			<< " <name>paleolatitude.org</name>" << endl
-			<< " <Style id=\"paleolatitude_site_default\">" << endl
-			<< "  <IconStyle>" << endl
-			<< "   <scale>0.75</scale>" << endl
-			<< "   <Icon><href>http://maps.google.com/mapfiles/kml/shapes/target.png</href></Icon>" << endl
-			<< "  </IconStyle>" << endl
-			<< " </Style>" << endl
-			<< " <StyleMap id=\"paleolatitude_site\">" << endl
-			<< "  <Pair>" << endl
-			<< "   <key>normal</key><styleUrl>#paleolatitude_site_default</styleUrl>" << endl
-			<< "  </Pair>" << endl
-			<< "  <Pair>" << endl
-			<< "   <key>highlight</key><styleUrl>#paleolatitude_site_default</styleUrl>" << endl
-			<< "  </Pair>" << endl
-			<< " </StyleMap>" << endl;
+	// Plate placemarks are written as blocks of text (see PLPlate::writeKMLPlacemark): do not
+	// flush the stream after every line
+	output_stream << "<?xml version=\"1.0\" encoding=\"utf-8\" ?>\n"
+			<< "<kml xmlns=\"http://www.opengis.net/kml/2.2\">\n"
+			<< "<Document>\n"
+			<< " <name>paleolatitude.org</name>\n"
+			<< " <Style id=\"paleolatitude_site_default\">\n"
+			<< "  <IconStyle>\n"
+			<< "   <scale>0.75</scale>\n"
+			<< "   <Icon><href>http://maps.google.com/mapfiles/kml/shapes/target.png</href></Icon>\n"
+			<< "  </IconStyle>\n"
+			<< " </Style>\n"
+			<< " <StyleMap id=\"paleolatitude_site\">\n"
+			<< "  <Pair>\n"
+			<< "   <key>normal</key><styleUrl>#paleolatitude_site_default</styleUrl>\n"
+			<< "  </Pair>\n"
+			<< "  <Pair>\n"
+			<< "   <key>highlight</key><styleUrl>#paleolatitude_site_default</styleUrl>\n"
+			<< "  </Pair>\n"
+			<< " </StyleMap>\n";
 
 	// Add Placemark for site location
-	output_stream << "<Placemark>" << endl
-			<< " <name>Site location</name>" << endl
-			<< " <open>1</open>" << endl
-			<< " <styleUrl>#paleolatitude_site</styleUrl>" << endl
-			<< " <Point><coordinates>" << _params->site_longitude << "," << _params->site_latitude << "</coordinates></Point>" << endl
-			<< "</Placemark>" << endl;
+	output_stream << "<Placemark>\n"
+			<< " <name>Site location</name>\n"
+			<< " <open>1</open>\n"
+			<< " <styleUrl>#paleolatitude_site</styleUrl>\n"
+			<< " <Point><coordinates>" << _params->site_longitude << "," << _params->site_latitude << "</coordinates></Point>\n"
+			<< "</Placemark>\n";
 
 
 	// Add Placemarks with Polygons
@@ -631,8 +572,47 @@ void PaleoLatitude::writeKML(ostream& output_stream) {
 	}
 
 
-	output_stream << "</Document>" << endl
-			<< "</kml>" << endl;
+	output_stream << "</Document>\n"
+			<< "</kml>\n";
+}
+
+void PaleoLatitude::writeMachineReadable(ostream& output_stream, bool include_kml) {
+	// #latitude:52.50
+	// #longitude:-35.5
+	// #plate_name:Eurasia
+	// #plate_id:201
+	// #CSV
+	// .....
+	//
+	// #KML
+	// .....
+	_requireResult();
+
+	output_stream << "#latitude:" << _params->site_latitude << endl;
+	output_stream << "#longitude:" << _params->site_longitude << endl;
+
+	output_stream << "#plate_name:" << _plate->getName() << endl;
+	output_stream << "#plate_id:" << _plate->getId() << endl;
+
+	output_stream << "#CSV" << endl;
+	writeCSV(output_stream);
+
+	if (include_kml){
+		output_stream << endl;
+		output_stream << "#KML" << endl;
+
+		// The KML section has always used fixed-point coordinates with 5 decimals (which
+		// writeCSV used to leave behind in the stream)
+		const ios::fmtflags flags = output_stream.flags();
+		const streamsize precision = output_stream.precision();
+		output_stream.setf(ios::fixed, ios::floatfield);
+		output_stream.precision(5);
+
+		writeKML(output_stream);
+
+		output_stream.flags(flags);
+		output_stream.precision(precision);
+	}
 }
 
 double PaleoLatitude::PaleoLatitudeEntry::getAgeInMYR() const {
@@ -26,7 +26,6 @@
 #define PALEOLATITUDE_H_
 #include <iomanip>
 #include <string>
-#include <boost/numeric/ublas/matrix.hpp>
 #include <cstdio>
 #include <tuple>
 #include <iostream>
@@ -35,11 +34,11 @@
 #include "PLPlate.h"
 #include "PLPolarWanderPaths.h"
 #include "PLEulerPolesReconstructions.h"
+#include "../util/Vector3.h"
 
 #define PALEOLATITUDE_VERSION "2.1"
 
 using namespace std;
-namespace bnu = boost::numeric::ublas;
 
 namespace paleo_latitude {
 
@@ -47,10 +46,12 @@ class PLPolarWanderPaths;
 class PLParameters;
 class PLPlates;
 class PLEulerPolesReconstructions;
+class PLDataset;
 
 /**
  * The PaleoLatitude class contains the model logic and ties all data (e.g. plates, euler table)
- * together. It takes a PLParameters pointer that describes the input data.
+ * together. It takes a PLParameters pointer that describes the input data, and optionally a
+ * PLDataset that was read beforehand (which can then be shared between PaleoLatitude objects).
  */
 class PaleoLatitude {
 
@@ -60,7 +61,7 @@ public:
 		PaleoLatitudeEntry(unsigned long age_years_lower_bound_, unsigned long age_years_, unsigned long age_years_upper_bound_, double palat_min_, double palat_, double palat_max_, unsigned int computed_using_plate_id_) :
 			age_years_lower_bound(age_years_lower_bound_), age_years(age_years_), age_years_upper_bound(age_years_upper_bound_), palat_min(palat_min_), palat(palat_), palat_max(palat_max_), computed_using_plate_id(computed_using_plate_id_){}
 
-		string to_string();
+		string to_string() const;
 		static PaleoLatitudeEntry interpolate(const PaleoLatitudeEntry& other_younger, const PaleoLatitudeEntry& other_older, unsigned long age_years);
 
 		double getAgeInMYR() const;
@@ -82,6 +83,12 @@ public:
 
 	PaleoLatitude();
 	PaleoLatitude(PLParameters* params);
+
+	/**
+	 * Uses a dataset that was read beforehand, rather than reading the input files specified
+	 * in the parameters. The dataset is not owned by this object, and must outlive it.
+	 */
+	PaleoLatitude(PLParameters* params, const PLDataset* dataset);
 	PaleoLatitude(const PaleoLatitude& other) = delete;
 
 	virtual ~PaleoLatitude();
@@ -106,6 +113,12 @@ public:
 	 */
 	void writeKML(ostream& output_stream);
 
+	/**
+	 * Writes the machine readable output (as printed by --machine-readable): the site, the
+	 * plate, and the CSV and (optionally) KML data, each section preceded by a '#' line
+	 */
+	void writeMachineReadable(ostream& output_stream, bool include_kml = true);
+
 	/**
 	 * Returns all entries that were relevant to the paleolatitude computation. For example, when requesting a range with
 	 * interpolated boundaries, the values before and after the relevant data points will be returned as well.
@@ -134,6 +147,12 @@ public:
 	 */
 	bool compute();
 
+	/**
+	 * Computes the paleolatitude using the plate of the site, which has been determined
+	 * beforehand (e.g. to report sites that are not located on a plate separately)
+	 */
+	bool compute(const PLPlate* plate);
+
 	/**
 	 * Prints information about this implementation to stdout
 	 */
@@ -153,19 +172,29 @@ public:
 	}
 
 private:
-	PLPolarWanderPaths* _pwp = NULL;
+	// Measures _calculatePaleolatitudeRange() in isolation (see benchmarks/)
+	friend class PaleoLatitudeBenchmark;
+
 	PLParameters* _params = NULL;
-	PLPlates* _plates = NULL;
-	PLEulerPolesReconstructions* _euler = NULL;
+	const PLDataset* _dataset = NULL;
+	bool _owns_dataset = false;
+	const PLPolarWanderPaths* _pwp = NULL;
+	const PLPlates* _plates = NULL;
+	const PLEulerPolesReconstructions* _euler = NULL;
 	const PLPlate* _plate = NULL;
 
 	vector<PaleoLatitudeEntry> _result;
 
-	const vector<PaleoLatitudeEntry> _calculatePaleolatitudeRangeForAge(const Coordinate& site, const PLPlate* plate, unsigned int age_myr) const;
-	const PaleoLatitudeEntry _calculatePaleolatitudeRange(const Coordinate& site, const PLPlate* plate, unsigned int age_myr, const PLEulerPolesReconstructions::EPEntry* euler_entry, const PLPolarWanderPaths::PWPEntry* pwp_entry) const;
+	/**
+	 * Number of bytes of output that are composed before writing them to the output stream
+	 */
+	const static size_t OUTPUT_BLOCK_SIZE;
 
-	template<class T> static string _ppMatrix(const bnu::matrix<T>& matrix);
-	template<class T> static string _ppVector(const bnu::vector<T>& vector);
+	void _calculatePaleolatitudeTimeSeries(const Vector3& site, const PLPlate* plate);
+	const vector<PaleoLatitudeEntry> _calculatePaleolatitudeRangeForAge(const Vector3& site, const PLPlate* plate, unsigned int age_myr) const;
+	const PaleoLatitudeEntry _calculatePaleolatitudeRange(const Vector3& site, unsigned int age_myr, const PLEulerPolesReconstructions::EPEntry* euler_entry, const PLEulerPolesReconstructions::Paleopole& paleopole) const;
+
+	static string _ppVector(const Vector3& vector);
 
 	static double _deg2rad(const double& deg);
 	static double _rad2deg(const double& deg);
@@ -173,39 +202,5 @@ private:
 	void _requireResult() const;
 };
 
-
-template<class T>
-string PaleoLatitude::_ppMatrix(const bnu::matrix<T>& matrix) {
-	stringstream res;
-	res.precision(5);
-	res << fixed;
-
-	res << "Matrix (dimensions: " << matrix.size1() << "x" << matrix.size2() << ")" << endl;
-	for (unsigned int row = 0; row < matrix.size1(); row++){
-		for (unsigned int col = 0; col < matrix.size2(); col++){
-			const double val = matrix(row,col);
-			if (col != 0) res << ", ";
-			if (val >= 0) res << " ";
-			res << val;
-		}
-		res << endl;
-	}
-	return res.str();
-}
-
-
-template<class T> string PaleoLatitude::_ppVector(const bnu::vector<T>& vector) {
-	stringstream res;
-	res.precision(5);
-	res << fixed;
-	res << "[";
-	for (unsigned int i = 0; i < vector.size(); i++){
-		if (i != 0) res << ",";
-		res << vector[i];
-	}
-	res << "]";
-	return res.str();
-};
-
 };
 #endif /* PALEOLATITUDE_H_ */
@@ -0,0 +1,46 @@
+/*
+ * ArrayView.h
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: Sebastiaan J. van Schaik
+ */
+
+#ifndef ARRAYVIEW_H_
+#define ARRAYVIEW_H_
+
+#include <cstddef>
+#include <vector>
+
+namespace paleo_latitude {
+
+/**
+ * Read-only view of a contiguous range of elements that are owned by another object (which
+ * must outlive the view). Used to return (parts of) precomputed tables without copying them.
+ */
+template<class T> class ArrayView {
+public:
+	typedef const T* const_iterator;
+
+	ArrayView() : _begin(NULL), _end(NULL) {}
+	ArrayView(const T* begin, const T* end) : _begin(begin), _end(end) {}
+
+	const_iterator begin() const { return _begin; }
+	const_iterator end() const { return _end; }
+
+	size_t size() const { return _end - _begin; }
+	bool empty() const { return _begin == _end; }
+
+	const T& operator[](size_t i) const { return _begin[i]; }
+	const T& front() const { return *_begin; }
+	const T& back() const { return *(_end - 1); }
+
+	std::vector<T> to_vector() const { return std::vector<T>(_begin, _end); }
+
+private:
+	const T* _begin;
+	const T* _end;
+};
+
+};
+
+#endif /* ARRAYVIEW_H_ */
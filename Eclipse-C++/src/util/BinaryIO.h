@@ -0,0 +1,200 @@
+/*
+ * BinaryIO.h
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: Sebastiaan J. van Schaik
+ */
+
+#ifndef BINARYIO_H_
+#define BINARYIO_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include "ArrayView.h"
+#include "Exception.h"
+
+using namespace std;
+
+namespace paleo_latitude {
+
+/**
+ * Whether values of type T can be copied into binary data byte by byte, i.e. whether they have
+ * no padding: padding bytes are not initialised, and would make the data (and its checksum)
+ * differ between runs. This holds for types with unique object representations, and for
+ * floating point types (of which only values such as -0 and NaN lack a unique representation).
+ * Records with floating point fields cannot be checked this way: they declare that they have no
+ * padding using a constant BINARY_PACKED, and verify it using a static_assert on their size.
+ */
+template<class T, class = void> struct IsBinaryPacked : integral_constant<bool, has_unique_object_representations<T>::value || is_floating_point<T>::value> {};
+template<class T> struct IsBinaryPacked<T, void_t<decltype(T::BINARY_PACKED)> > : integral_constant<bool, T::BINARY_PACKED> {};
+
+/**
+ * Helpers for flat binary data (see BinaryWriter and BinaryReader). Values are stored in the
+ * byte order of the machine. Arrays are aligned to ALIGNMENT bytes (relative to the start of
+ * the data), so that they can be used in place when the data is located at an address with
+ * the same alignment (e.g. in a memory-mapped file).
+ */
+class BinaryIO {
+public:
+	const static size_t ALIGNMENT = 8;
+
+	/**
+	 * Computes an FNV-1a hash of the data, processing 64 bit words rather than single bytes
+	 */
+	static uint64_t checksum(const char* data, size_t size){
+		uint64_t hash = 14695981039346656037ull;
+		size_t pos = 0;
+
+		for (; pos + sizeof(uint64_t) <= size; pos += sizeof(uint64_t)){
+			uint64_t word;
+			memcpy(&word, data + pos, sizeof(word));
+			hash ^= word;
+			hash *= 1099511628211ull;
+		}
+
+		for (; pos < size; pos++){
+			hash ^= static_cast<unsigned char>(data[pos]);
+			hash *= 1099511628211ull;
+		}
+
+		return hash;
+	}
+
+	static size_t padding(size_t offset){
+		return (ALIGNMENT - offset % ALIGNMENT) % ALIGNMENT;
+	}
+};
+
+/**
+ * Serialises values and arrays of trivially copyable types into a memory buffer
+ */
+class BinaryWriter {
+public:
+	template<class T> void write(const T& value){
+		static_assert(is_trivially_copyable<T>::value, "Only trivially copyable types can be written");
+		static_assert(IsBinaryPacked<T>::value, "Only types without padding can be written (see IsBinaryPacked)");
+		_append(&value, sizeof(T));
+	}
+
+	/**
+	 * Writes the number of elements, followed by the (aligned) elements
+	 */
+	template<class T> void writeArray(const T* values, size_t count){
+		static_assert(is_trivially_copyable<T>::value, "Only trivially copyable types can be written");
+		static_assert(IsBinaryPacked<T>::value, "Only types without padding can be written (see IsBinaryPacked)");
+		_align();
+		write<uint64_t>(count);
+		_append(values, count * sizeof(T));
+		_align();
+	}
+
+	template<class T> void writeArray(const vector<T>& values){
+		writeArray(values.data(), values.size());
+	}
+
+	void writeString(const string& value){
+		writeArray(value.data(), value.size());
+	}
+
+	/**
+	 * Returns the data written so far (padded to a multiple of BinaryIO::ALIGNMENT bytes)
+	 */
+	const vector<char>& getData(){
+		_align();
+		return _data;
+	}
+
+private:
+	void _append(const void* data, size_t size){
+		const char* bytes = static_cast<const char*>(data);
+		_data.insert(_data.end(), bytes, bytes + size);
+	}
+
+	void _align(){
+		_data.resize(_data.size() + BinaryIO::padding(_data.size()), 0);
+	}
+
+	vector<char> _data;
+};
+
+/**
+ * Reads data written by BinaryWriter. Arrays are returned as views of the data (which must
+ * outlive them), without copying. Throws an Exception if the data is truncated or corrupt.
+ */
+class BinaryReader {
+public:
+	/**
+	 * The data must be aligned to BinaryIO::ALIGNMENT bytes. The name of the source is only
+	 * used in error messages.
+	 */
+	BinaryReader(const char* data, size_t size, const string& source) : _data(data), _size(size), _source(source) {
+		if (reinterpret_cast<uintptr_t>(data) % BinaryIO::ALIGNMENT != 0){
+			Exception ex;
+			ex << "Binary data of '" << source << "' is not aligned";
+			throw ex;
+		}
+	}
+
+	template<class T> T read(){
+		static_assert(is_trivially_copyable<T>::value, "Only trivially copyable types can be read");
+		_require(sizeof(T));
+
+		T value;
+		memcpy(&value, _data + _pos, sizeof(T));
+		_pos += sizeof(T);
+		return value;
+	}
+
+	template<class T> ArrayView<T> readArray(){
+		static_assert(is_trivially_copyable<T>::value, "Only trivially copyable types can be read");
+		_align();
+		const uint64_t count = read<uint64_t>();
+		if (count > (_size - _pos) / sizeof(T)) _truncated();
+
+		const T* begin = reinterpret_cast<const T*>(_data + _pos);
+		_pos += count * sizeof(T);
+		_align();
+		return ArrayView<T>(begin, begin + count);
+	}
+
+	string readString(){
+		const ArrayView<char> chars = readArray<char>();
+		return string(chars.begin(), chars.end());
+	}
+
+	bool atEnd() const {
+		return _pos >= _size;
+	}
+
+	const string& getSource() const {
+		return _source;
+	}
+
+private:
+	void _require(size_t size) const {
+		if (size > _size - _pos) _truncated();
+	}
+
+	void _align(){
+		_pos = min(_size, _pos + BinaryIO::padding(_pos));
+	}
+
+	[[noreturn]] void _truncated() const {
+		Exception ex;
+		ex << "Unexpected end of binary data of '" << _source << "' (at byte " << _pos << " of " << _size << ")";
+		throw ex;
+	}
+
+	const char* _data;
+	const size_t _size;
+	size_t _pos = 0;
+	const string _source;
+};
+
+};
+
+#endif /* BINARYIO_H_ */
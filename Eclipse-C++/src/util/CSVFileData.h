@@ -11,9 +11,9 @@
 #include "Exception.h"
 #include <iostream>
 #include <string>
+#include <string_view>
 #include <fstream>
 #include <vector>
-#include <boost/algorithm/string.hpp>
 #include "Util.h"
 
 namespace paleo_latitude {
@@ -26,10 +26,14 @@ class CSVFileData {
 public:
 	struct Entry {
 	public:
-		virtual void set(unsigned int column, const string value, const string filename, unsigned int lineno) = 0;
+		/**
+		 * Sets the value of a column. The value refers to the line buffer of the parser, and is
+		 * only valid during this call.
+		 */
+		virtual void set(unsigned int column, string_view value, const string& filename, unsigned int lineno) = 0;
 		virtual size_t numColumns() const = 0;
 
-		template<class T> T parseString(const string& input, T& output) const {
+		template<class T> T parseString(string_view input, T& output) const {
 			bool res = Util::string_to_something(input, output);
 
 			if (!res){
@@ -56,9 +60,9 @@ public:
 
 	struct StringEntry : public Entry {
 	public:
-		virtual void set(unsigned int column, const string value, const string filename, unsigned int lineno){
+		virtual void set(unsigned int column, string_view value, const string& filename, unsigned int lineno){
 			_values.resize(this->numColumns());
-			_values[column] = value;
+			_values[column] = string(value);
 		}
 
 		/**
@@ -120,6 +124,20 @@ public:
 		return _filename;
 	}
 
+	/**
+	 * Adds an empty entry (for data that is not read from a CSV file, e.g. when restoring a
+	 * dataset bundle). The filename is only used in error messages.
+	 */
+	EntryType& addEntry(const string& filename, unsigned int line_no){
+		_filename = filename;
+		_data.emplace_back(this, line_no);
+		return _data.back();
+	}
+
+	void reserve(size_t num_entries){
+		_data.reserve(num_entries);
+	}
+
 	void parseFile(const string filename){
 		_filename = filename;
 		ifstream csvfile (filename);
@@ -131,17 +149,17 @@ public:
 		}
 
 		string line;
+		vector<string_view> values;
 
 		unsigned int lines_parsed = 0;
 		unsigned int line_no = 0;
 
 		while (getline(csvfile, line)){
 			line_no++;
-			vector<string> values;
 
 			EntryType csv_entry(this, line_no);
 
-			boost::split(values, line, boost::is_any_of(_sep_chars));
+			_splitLine(line, values);
 
 			if (values.size() != csv_entry.numColumns()){
 				if (lines_parsed > 0 || line_no >= 3){
@@ -159,7 +177,7 @@ public:
 					csv_entry.set(i, values[i], filename, line_no);
 				}
 
-				_data.push_back(csv_entry);
+				_data.push_back(move(csv_entry));
 				lines_parsed++;
 			} catch (CSVFileDataParseException& pex){
 				// Ignore parse exceptions in headers (ie., when no lines have been parsed yet)
@@ -176,6 +194,27 @@ public:
 
 private:
 	CSVFileData(const CSVFileData<EntryType>& other) = delete;
+
+	/**
+	 * Splits a line at every separator character (without merging adjacent separators, so a
+	 * line with n separators always yields n+1 values). The values refer to the line.
+	 */
+	void _splitLine(const string& line, vector<string_view>& values) const {
+		values.clear();
+
+		size_t begin = 0;
+		while (true){
+			const size_t end = line.find_first_of(_sep_chars, begin);
+			if (end == string::npos){
+				values.emplace_back(line.data() + begin, line.size() - begin);
+				return;
+			}
+
+			values.emplace_back(line.data() + begin, end - begin);
+			begin = end + 1;
+		}
+	}
+
 	string _filename;
 	vector<EntryType> _data;
 	string _sep_chars = ";,";
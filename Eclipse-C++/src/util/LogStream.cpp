@@ -6,34 +6,55 @@
  */
 
 #include "LogStream.h"
+#include <vector>
 
 using namespace paleo_latitude;
 
-LogStream::LogStream(string label, ostream& target) : _target(target), _label(label) {}
+mutex LogStream::_output_mutex;
+atomic<size_t> LogStream::_num_streams(0);
+
+LogStream::LogStream(string label, ostream& target) : _target(&target), _enabled(true), _label(label), _index(_num_streams++) {}
+
+LogStream::Line& LogStream::_currentLine() {
+	static thread_local vector<Line> lines;
+	if (lines.size() <= _index) lines.resize(_index + 1);
+	return lines[_index];
+}
 
 
 void LogStream::enable() {
-	_enabled = true;
+	_enabled.store(true, memory_order_relaxed);
 }
 
 void LogStream::disable() {
-	_enabled = false;
+	_enabled.store(false, memory_order_relaxed);
 }
 
-bool LogStream::isEnabled() const {
-	return _enabled;
+void LogStream::setTarget(ostream& target) {
+	lock_guard<mutex> lock(_output_mutex);
+	_target = &target;
 }
 
 LogStream& LogStream::operator<<(Flag someFlag){
 	if (someFlag.type == FlagTypes::FlagNoLabel){
-		_skipLabel = true;
+		_currentLine().skip_label = true;
 	}
 	return *this;
 }
 
 LogStream& LogStream::operator<<(StandardEndLine manip){
-	_skipLabel = false;
-	if (_enabled) _target << manip;
+	Line& line = _currentLine();
+
+	if (isEnabled()){
+		const string text = line.buffer.str();
+
+		lock_guard<mutex> lock(_output_mutex);
+		if (!text.empty() && !line.skip_label && _label != "") *_target << _label << ": ";
+		*_target << text << manip;
+	}
+
+	line.buffer.str("");
+	line.skip_label = false;
 	return *this;
 }
 
@@ -8,8 +8,11 @@
 #ifndef LOGSTREAM_H_
 #define LOGSTREAM_H_
 
+#include <atomic>
 #include <iostream>
+#include <sstream>
 #include <string>
+#include <mutex>
 
 using namespace std;
 
@@ -24,18 +27,27 @@ public:
 	};
 
 	LogStream(string label, ostream& target = cout);
+	LogStream(const LogStream& other) = delete;
 
 	void enable();
 	void disable();
-	bool isEnabled() const;
-
-	template <class SomeType> LogStream& operator<<(SomeType val){
-		if (_enabled){
-			if (!_skipLabel && _label != ""){
-				_target << _label << ": ";
-				_skipLabel = true;
-			}
-			_target << val;
+
+	/**
+	 * Writes the log lines to another target from now on (e.g. standard error, when standard
+	 * output contains results)
+	 */
+	void setTarget(ostream& target);
+
+	/**
+	 * Checked before every log statement (see __LOG), so this is kept inline and cheap
+	 */
+	bool isEnabled() const {
+		return _enabled.load(memory_order_relaxed);
+	}
+
+	template <class SomeType> LogStream& operator<<(const SomeType& val){
+		if (isEnabled()){
+			_currentLine().buffer << val;
 		}
 		return *this;
 	}
@@ -49,12 +61,36 @@ public:
 	static Flag noLabel;
 
 private:
-	ostream& _target;
-	bool _enabled = true;
-	bool _skipLabel = false;
+	/**
+	 * Every thread composes its log lines in its own buffer. Complete lines are written to the
+	 * target at once, so lines logged by different threads do not get mixed up.
+	 */
+	struct Line {
+		stringstream buffer;
+		bool skip_label = false;
+	};
+
+	Line& _currentLine();
+
+	ostream* _target;
+	atomic<bool> _enabled;
 	string _label = "";
+
+	// Index of the stream in the per-thread line buffers
+	const size_t _index;
+
+	static mutex _output_mutex;
+	static atomic<size_t> _num_streams;
 };
 
 };
 
+/**
+ * Logs to a LogStream only if it is enabled: when it is disabled, the rest of the statement
+ * (including the evaluation of its operands) is skipped entirely. Usage:
+ *
+ *   __LOG(Logger::info) << "Computed " << entry.to_string() << endl;
+ */
+#define __LOG(log_stream) if (!(log_stream).isEnabled()) {} else (log_stream)
+
 #endif /* LOGSTREAM_H_ */
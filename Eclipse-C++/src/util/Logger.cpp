@@ -11,17 +11,17 @@
 
 using namespace paleo_latitude;
 
-void Logger::logError(string str_error){
-	error << str_error << endl;
+void Logger::logError(const string& str_error){
+	__LOG(error) << str_error << endl;
 }
 
-void Logger::logInfo(string str_info){
-	info << str_info << endl;
+void Logger::logInfo(const string& str_info){
+	__LOG(info) << str_info << endl;
 }
 
 
-void Logger::logWarn(string str_warn){
-	warning << str_warn << endl;
+void Logger::logWarn(const string& str_warn){
+	__LOG(warning) << str_warn << endl;
 }
 
 void Logger::disableAll(){
@@ -24,9 +24,9 @@ public:
 	static void disableAll();
 	static void enableAll();
 
-	static void logError(string error);
-	static void logInfo(string info);
-	static void logWarn(string warn);
+	static void logError(const string& error);
+	static void logInfo(const string& info);
+	static void logWarn(const string& warn);
 
 	static LogStream info;
 	static LogStream warning;
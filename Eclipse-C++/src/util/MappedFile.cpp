@@ -0,0 +1,75 @@
+/*
+ * MappedFile.cpp
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: Sebastiaan J. van Schaik
+ */
+
+#include "MappedFile.h"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "Exception.h"
+
+using namespace paleo_latitude;
+
+MappedFile::MappedFile(const string& filename) : _filename(filename) {
+	const int fd = open(filename.c_str(), O_RDONLY);
+	if (fd < 0){
+		Exception ex;
+		ex << "Could not open file '" << filename << "': " << strerror(errno);
+		throw ex;
+	}
+
+	struct stat file_stat;
+	if (fstat(fd, &file_stat) != 0){
+		const int error = errno;
+		close(fd);
+
+		Exception ex;
+		ex << "Could not determine size of file '" << filename << "': " << strerror(error);
+		throw ex;
+	}
+
+	_size = static_cast<size_t>(file_stat.st_size);
+
+	// Mapping an empty file fails, but there is nothing to map anyway
+	if (_size > 0){
+		void* data = mmap(NULL, _size, PROT_READ, MAP_SHARED, fd, 0);
+		if (data == MAP_FAILED){
+			const int error = errno;
+			close(fd);
+
+			Exception ex;
+			ex << "Could not map file '" << filename << "' into memory: " << strerror(error);
+			throw ex;
+		}
+		_data = data;
+	}
+
+	// The mapping remains valid after the file is closed
+	close(fd);
+}
+
+MappedFile::~MappedFile() {
+	if (_data != NULL) munmap(_data, _size);
+	_data = NULL;
+	_size = 0;
+}
+
+const char* MappedFile::data() const {
+	return static_cast<const char*>(_data);
+}
+
+size_t MappedFile::size() const {
+	return _size;
+}
+
+const string& MappedFile::getFilename() const {
+	return _filename;
+}
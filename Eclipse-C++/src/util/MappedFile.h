@@ -0,0 +1,44 @@
+/*
+ * MappedFile.h
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: Sebastiaan J. van Schaik
+ */
+
+#ifndef MAPPEDFILE_H_
+#define MAPPEDFILE_H_
+
+#include <cstddef>
+#include <string>
+
+using namespace std;
+
+namespace paleo_latitude {
+
+/**
+ * Read-only memory mapping of a whole file. The pages are shared with the page cache (and
+ * hence with other processes mapping the same file), and are only read from disk when they
+ * are accessed. The mapping is released when the object is destroyed.
+ */
+class MappedFile {
+public:
+	/**
+	 * Maps the file into memory. Throws an Exception if the file cannot be opened or mapped.
+	 */
+	MappedFile(const string& filename);
+	MappedFile(const MappedFile& other) = delete;
+	~MappedFile();
+
+	const char* data() const;
+	size_t size() const;
+	const string& getFilename() const;
+
+private:
+	const string _filename;
+	void* _data = NULL;
+	size_t _size = 0;
+};
+
+};
+
+#endif /* MAPPEDFILE_H_ */
@@ -0,0 +1,102 @@
+/*
+ * Matrix3.h
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: Sebastiaan J. van Schaik
+ */
+
+#ifndef MATRIX3_H_
+#define MATRIX3_H_
+
+#include <cmath>
+#include "Vector3.h"
+
+namespace paleo_latitude {
+
+/**
+ * Fixed-size 3x3 matrix (row-major), used for rotations on the unit sphere. All operations are
+ * inline and work on the stack, so that they can be used in the innermost loops of the model.
+ */
+struct Matrix3 {
+	constexpr Matrix3() : m{{0, 0, 0}, {0, 0, 0}, {0, 0, 0}} {}
+	constexpr Matrix3(double m00, double m01, double m02, double m10, double m11, double m12, double m20, double m21, double m22)
+		: m{{m00, m01, m02}, {m10, m11, m12}, {m20, m21, m22}} {}
+
+	/**
+	 * Returns the matrix with the given vectors as columns
+	 */
+	static Matrix3 fromColumns(const Vector3& c0, const Vector3& c1, const Vector3& c2){
+		return Matrix3(c0.x, c1.x, c2.x, c0.y, c1.y, c2.y, c0.z, c1.z, c2.z);
+	}
+
+	/**
+	 * Returns the matrix that rotates vectors over the given angle (in radians) around the z axis
+	 */
+	static Matrix3 rotationZ(double angle_rad){
+		const double c = cos(angle_rad);
+		const double s = sin(angle_rad);
+		return Matrix3(c, -s, 0, s, c, 0, 0, 0, 1);
+	}
+
+	/**
+	 * Returns the matrix that rotates vectors over the given angle (in radians) around the axis
+	 * through the given latitude and longitude (in radians). The rotation is applied in a frame
+	 * with its z axis through the rotation axis, i.e. as L * R * L^T, where the columns of L
+	 * are the local south, east and up directions at the rotation axis.
+	 */
+	static Matrix3 eulerRotation(double latitude_rad, double longitude_rad, double angle_rad){
+		const double colatitude_rad = 0.5 * M_PI - latitude_rad;
+		const double cos_lon = cos(longitude_rad), sin_lon = sin(longitude_rad);
+		const double cos_colat = cos(colatitude_rad), sin_colat = sin(colatitude_rad);
+
+		const Matrix3 L = fromColumns(
+				Vector3(cos_lon * cos_colat, sin_lon * cos_colat, -sin_colat),
+				Vector3(-sin_lon, cos_lon, 0),
+				Vector3(cos_lon * sin_colat, sin_lon * sin_colat, cos_colat));
+
+		return (L * rotationZ(angle_rad)) * L.transposed();
+	}
+
+	constexpr double operator()(unsigned int row, unsigned int col) const {
+		return m[row][col];
+	}
+
+	double& operator()(unsigned int row, unsigned int col){
+		return m[row][col];
+	}
+
+	Vector3 row(unsigned int i) const {
+		return Vector3(m[i][0], m[i][1], m[i][2]);
+	}
+
+	Vector3 column(unsigned int i) const {
+		return Vector3(m[0][i], m[1][i], m[2][i]);
+	}
+
+	Matrix3 transposed() const {
+		return Matrix3(m[0][0], m[1][0], m[2][0], m[0][1], m[1][1], m[2][1], m[0][2], m[1][2], m[2][2]);
+	}
+
+	Matrix3 operator*(const Matrix3& other) const {
+		Matrix3 res;
+		for (unsigned int i = 0; i < 3; i++){
+			for (unsigned int j = 0; j < 3; j++){
+				res.m[i][j] = m[i][0] * other.m[0][j] + m[i][1] * other.m[1][j] + m[i][2] * other.m[2][j];
+			}
+		}
+		return res;
+	}
+
+	Vector3 operator*(const Vector3& v) const {
+		return Vector3(
+				m[0][0] * v.x + m[0][1] * v.y + m[0][2] * v.z,
+				m[1][0] * v.x + m[1][1] * v.y + m[1][2] * v.z,
+				m[2][0] * v.x + m[2][1] * v.y + m[2][2] * v.z);
+	}
+
+	double m[3][3];
+};
+
+};
+
+#endif /* MATRIX3_H_ */
@@ -0,0 +1,77 @@
+/*
+ * Stats.cpp
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: Sebastiaan J. van Schaik
+ */
+
+#include "Stats.h"
+
+#include <sstream>
+
+using namespace paleo_latitude;
+
+atomic<bool> Stats::_enabled(false);
+thread_local unsigned int Stats::_paused = 0;
+Stats::Counter Stats::_counters[Stats::NUM_STAGES];
+
+void Stats::enable() {
+	_enabled.store(true, memory_order_relaxed);
+}
+
+void Stats::disable() {
+	_enabled.store(false, memory_order_relaxed);
+}
+
+void Stats::reset() {
+	for (Counter& counter : _counters){
+		counter.calls.store(0, memory_order_relaxed);
+		counter.nanoseconds.store(0, memory_order_relaxed);
+	}
+}
+
+void Stats::add(Stage stage, uint64_t calls, uint64_t nanoseconds) {
+	_counters[stage].calls.fetch_add(calls, memory_order_relaxed);
+	_counters[stage].nanoseconds.fetch_add(nanoseconds, memory_order_relaxed);
+}
+
+Stats::StageStats Stats::get(Stage stage) {
+	StageStats res;
+	res.calls = _counters[stage].calls.load(memory_order_relaxed);
+	res.nanoseconds = _counters[stage].nanoseconds.load(memory_order_relaxed);
+	return res;
+}
+
+string Stats::getName(Stage stage) {
+	switch (stage){
+		case LOAD_DATASET: return "load_dataset";
+		case PARSE_CSV: return "parse_csv";
+		case PARSE_PLATES: return "parse_plates";
+		case FIND_PLATE: return "find_plate";
+		case PLATE_CONTAINS: return "plate_contains";
+		case EULER_LOOKUP: return "euler_lookup";
+		case APWP_LOOKUP: return "apwp_lookup";
+		case ROTATION: return "rotation";
+		case INTERPOLATION: return "interpolation";
+		case WRITE_OUTPUT: return "write_output";
+		default: return "unknown";
+	}
+}
+
+void Stats::writeJSON(ostream& output) {
+	stringstream json;
+	json.setf(ios::fixed, ios::floatfield);
+	json.precision(3);
+
+	json << "{";
+	for (unsigned int i = 0; i < NUM_STAGES; i++){
+		const StageStats stats = get(static_cast<Stage>(i));
+		const double mean_us = (stats.calls > 0) ? stats.nanoseconds / 1000.0 / stats.calls : 0;
+
+		if (i > 0) json << ",";
+		json << "\"" << getName(static_cast<Stage>(i)) << "\":{\"calls\":" << stats.calls << ",\"total_ms\":" << (stats.nanoseconds / 1000000.0) << ",\"mean_us\":" << mean_us << "}";
+	}
+	json << "}";
+
+	output << json.str() << endl;
+}
@@ -0,0 +1,130 @@
+/*
+ * Stats.h
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: Sebastiaan J. van Schaik
+ */
+
+#ifndef STATS_H_
+#define STATS_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+namespace paleo_latitude {
+
+/**
+ * Process-wide counters of the number of calls to, and the time spent in, the stages of a
+ * computation (see Stage). Recording is disabled by default: a disabled Timer only checks a
+ * flag. When enabled, timing adds two clock reads per call, which is noticeable for the
+ * smallest stages (e.g. ROTATION) but not for the others. Counters are shared between threads,
+ * so the time of a stage is the total over all threads.
+ */
+class Stats {
+public:
+	enum Stage {
+		LOAD_DATASET = 0,	// reading a complete dataset (files or bundle, including the stages below)
+		PARSE_CSV,			// reading the APWP and Euler rotation CSV files
+		PARSE_PLATES,		// reading the plates (GPML or KML) file
+		FIND_PLATE,			// determining the plate of a site
+		PLATE_CONTAINS,		// point-in-polygon tests (number of plates tested)
+		EULER_LOOKUP,		// looking up Euler rotations (and relevant ages) of a plate
+		APWP_LOOKUP,		// looking up apparent polar wander path entries
+		ROTATION,			// computing the paleolatitude range for one Euler rotation
+		INTERPOLATION,		// interpolating between ages
+		WRITE_OUTPUT,		// formatting and writing results
+		NUM_STAGES
+	};
+
+	struct StageStats {
+		uint64_t calls = 0;
+		uint64_t nanoseconds = 0;
+	};
+
+	/**
+	 * Records a call to a stage and the time until the timer goes out of scope (if enabled)
+	 */
+	class Timer {
+	public:
+		Timer(Stage stage) : _stage(stage), _running(Stats::isEnabled()) {
+			if (_running) _start = chrono::steady_clock::now();
+		}
+
+		~Timer(){
+			if (_running) Stats::add(_stage, 1, chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - _start).count());
+		}
+
+		Timer(const Timer& other) = delete;
+
+	private:
+		const Stage _stage;
+		const bool _running;
+		chrono::steady_clock::time_point _start;
+	};
+
+	/**
+	 * Stops recording on the current thread until the pause goes out of scope. Used for work
+	 * that is part of reading a dataset rather than of a computation (e.g. the point-in-polygon
+	 * tests that determine which plates are nested), which would otherwise distort the counts
+	 * of the stages it uses.
+	 */
+	class Pause {
+	public:
+		Pause(){
+			_paused++;
+		}
+
+		~Pause(){
+			_paused--;
+		}
+
+		Pause(const Pause& other) = delete;
+	};
+
+	static void enable();
+	static void disable();
+	static void reset();
+
+	/**
+	 * Whether recording is enabled (and not paused on the current thread)
+	 */
+	static bool isEnabled(){
+		return _enabled.load(memory_order_relaxed) && _paused == 0;
+	}
+
+	static void add(Stage stage, uint64_t calls, uint64_t nanoseconds);
+	static StageStats get(Stage stage);
+
+	/**
+	 * Returns the name of a stage as used in the JSON summary (e.g. "find_plate")
+	 */
+	static string getName(Stage stage);
+
+	/**
+	 * Writes a summary of all stages as a single JSON object, e.g.:
+	 *
+	 *   {"find_plate":{"calls":1000,"total_ms":12.345,"mean_us":12.345},...}
+	 */
+	static void writeJSON(ostream& output);
+
+private:
+	// Every stage has its own cache line, so that threads working in different stages do not
+	// slow each other down
+	struct alignas(64) Counter {
+		atomic<uint64_t> calls;
+		atomic<uint64_t> nanoseconds;
+	};
+
+	static atomic<bool> _enabled;
+	static thread_local unsigned int _paused;
+	static Counter _counters[NUM_STAGES];
+};
+
+};
+
+#endif /* STATS_H_ */
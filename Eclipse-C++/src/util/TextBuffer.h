@@ -0,0 +1,95 @@
+/*
+ * TextBuffer.h
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: Sebastiaan J. van Schaik
+ */
+
+#ifndef TEXTBUFFER_H_
+#define TEXTBUFFER_H_
+
+#include <charconv>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+using namespace std;
+
+namespace paleo_latitude {
+
+/**
+ * Composes text output in memory, without iostreams: numbers are formatted using to_chars,
+ * which does not depend on the locale or on the state of an output stream. Fixed-point
+ * numbers are formatted exactly like an output stream with ios::fixed and the same precision.
+ */
+class TextBuffer {
+public:
+	TextBuffer& append(string_view text){
+		_data.append(text.data(), text.size());
+		return *this;
+	}
+
+	TextBuffer& append(char c){
+		_data.push_back(c);
+		return *this;
+	}
+
+	template<class T> TextBuffer& appendInteger(T value){
+		static_assert(is_integral<T>::value, "Only integers can be appended using appendInteger");
+		char buffer[24];
+		const to_chars_result res = to_chars(buffer, buffer + sizeof(buffer), value);
+		_data.append(buffer, res.ptr - buffer);
+		return *this;
+	}
+
+	/**
+	 * Appends a number with the given number of digits after the decimal point
+	 */
+	TextBuffer& appendFixed(double value, int precision){
+		// Large enough for any double (up to 309 digits before the decimal point)
+		char buffer[400];
+		const to_chars_result res = to_chars(buffer, buffer + sizeof(buffer), value, chars_format::fixed, precision);
+		_data.append(buffer, res.ptr - buffer);
+		return *this;
+	}
+
+	/**
+	 * Appends a number with the given number of significant digits, like an output stream
+	 * without floatfield flags (i.e., in its default state: 6 significant digits)
+	 */
+	TextBuffer& appendGeneral(double value, int precision = 6){
+		char buffer[32];
+		const to_chars_result res = to_chars(buffer, buffer + sizeof(buffer), value, chars_format::general, precision);
+		_data.append(buffer, res.ptr - buffer);
+		return *this;
+	}
+
+	/**
+	 * Writes the contents to an output stream (without flushing the stream), and clears the
+	 * buffer so that it can be reused
+	 */
+	void writeTo(ostream& output){
+		output.write(_data.data(), _data.size());
+		_data.clear();
+	}
+
+	const string& str() const {
+		return _data;
+	}
+
+	size_t size() const {
+		return _data.size();
+	}
+
+	void clear(){
+		_data.clear();
+	}
+
+private:
+	string _data;
+};
+
+};
+
+#endif /* TEXTBUFFER_H_ */
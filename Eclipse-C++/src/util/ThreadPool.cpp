@@ -0,0 +1,122 @@
+/*
+ * ThreadPool.cpp
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: Sebastiaan J. van Schaik
+ */
+
+#include "ThreadPool.h"
+
+using namespace paleo_latitude;
+
+ThreadPool::ThreadPool(unsigned int num_threads) : _num_threads(num_threads), _remaining(0) {
+	if (_num_threads == 0) _num_threads = max(1u, thread::hardware_concurrency());
+
+	for (unsigned int w = 0; w < _num_threads; w++){
+		_queues.push_back(unique_ptr<Queue>(new Queue()));
+	}
+
+	// Worker 0 is the thread calling run()
+	for (unsigned int w = 1; w < _num_threads; w++){
+		_threads.push_back(thread(&ThreadPool::_workerLoop, this, w));
+	}
+}
+
+ThreadPool::~ThreadPool() {
+	{
+		lock_guard<mutex> lock(_state_mutex);
+		_stop = true;
+	}
+	_work_available.notify_all();
+
+	for (thread& t : _threads) t.join();
+}
+
+unsigned int ThreadPool::getNumThreads() const {
+	return _num_threads;
+}
+
+void ThreadPool::run(size_t num_tasks, const function<void(size_t)>& task) {
+	if (num_tasks == 0) return;
+
+	_task = &task;
+	_exception = nullptr;
+	_remaining = num_tasks;
+
+	// Contiguous ranges of tasks per worker: neighbouring tasks often use the same data
+	for (unsigned int w = 0; w < _num_threads; w++){
+		const size_t first = num_tasks * w / _num_threads;
+		const size_t last = num_tasks * (w + 1) / _num_threads;
+
+		lock_guard<mutex> lock(_queues[w]->queue_mutex);
+		for (size_t t = first; t < last; t++) _queues[w]->tasks.push_back(t);
+	}
+
+	{
+		lock_guard<mutex> lock(_state_mutex);
+		_generation++;
+	}
+	_work_available.notify_all();
+
+	_work(0);
+
+	unique_lock<mutex> lock(_state_mutex);
+	_work_done.wait(lock, [this]{ return _remaining == 0; });
+	_task = NULL;
+
+	if (_exception) rethrow_exception(_exception);
+}
+
+void ThreadPool::_workerLoop(unsigned int worker) {
+	unsigned long generation_seen = 0;
+
+	while (true){
+		{
+			unique_lock<mutex> lock(_state_mutex);
+			_work_available.wait(lock, [this, generation_seen]{ return _stop || _generation != generation_seen; });
+			if (_stop) return;
+			generation_seen = _generation;
+		}
+
+		_work(worker);
+	}
+}
+
+void ThreadPool::_work(unsigned int worker) {
+	size_t task;
+	while (_nextTask(worker, task)){
+		try {
+			(*_task)(task);
+		} catch (...){
+			lock_guard<mutex> lock(_state_mutex);
+			if (!_exception) _exception = current_exception();
+		}
+
+		if (--_remaining == 0){
+			lock_guard<mutex> lock(_state_mutex);
+			_work_done.notify_all();
+		}
+	}
+}
+
+/**
+ * Takes the next task from the front of the worker's own queue, or steals one from the back
+ * of another worker's queue
+ */
+bool ThreadPool::_nextTask(unsigned int worker, size_t& task) {
+	for (unsigned int i = 0; i < _num_threads; i++){
+		Queue& queue = *_queues[(worker + i) % _num_threads];
+		lock_guard<mutex> lock(queue.queue_mutex);
+		if (queue.tasks.empty()) continue;
+
+		if (i == 0){
+			task = queue.tasks.front();
+			queue.tasks.pop_front();
+		} else {
+			task = queue.tasks.back();
+			queue.tasks.pop_back();
+		}
+		return true;
+	}
+	return false;
+}
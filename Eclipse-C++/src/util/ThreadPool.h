@@ -0,0 +1,76 @@
+/*
+ * ThreadPool.h
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: Sebastiaan J. van Schaik
+ */
+
+#ifndef THREADPOOL_H_
+#define THREADPOOL_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+namespace paleo_latitude {
+
+/**
+ * Fixed-size pool of worker threads with work stealing. Every worker has its own queue of
+ * tasks; a worker that runs out of tasks takes tasks from the back of the queues of other
+ * workers, which balances tasks of uneven cost.
+ */
+class ThreadPool {
+public:
+	/**
+	 * Creates a pool with the given number of threads (0 = one per CPU core). The thread
+	 * calling #run counts as one of them.
+	 */
+	ThreadPool(unsigned int num_threads);
+	ThreadPool(const ThreadPool& other) = delete;
+	virtual ~ThreadPool();
+
+	unsigned int getNumThreads() const;
+
+	/**
+	 * Runs task(i) for all i in [0, num_tasks) and blocks until all tasks have finished.
+	 * Tasks are divided over the workers in contiguous ranges. If any task throws an
+	 * exception, the first exception is rethrown (after all other tasks have finished).
+	 */
+	void run(size_t num_tasks, const function<void(size_t)>& task);
+
+private:
+	struct Queue {
+		mutex queue_mutex;
+		deque<size_t> tasks;
+	};
+
+	void _workerLoop(unsigned int worker);
+	void _work(unsigned int worker);
+	bool _nextTask(unsigned int worker, size_t& task);
+
+	unsigned int _num_threads;
+	vector<thread> _threads;
+	vector<unique_ptr<Queue> > _queues;
+
+	const function<void(size_t)>* _task = NULL;
+	atomic<size_t> _remaining;
+	exception_ptr _exception;
+
+	mutex _state_mutex;
+	condition_variable _work_available;
+	condition_variable _work_done;
+	unsigned long _generation = 0;
+	bool _stop = false;
+};
+
+};
+
+#endif /* THREADPOOL_H_ */
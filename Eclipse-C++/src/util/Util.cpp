@@ -33,8 +33,8 @@ bool Util::double_eq(const double& a, const double& b){
 	return (diff / (fabs(a) + fabs(b)) < DOUBLE_COMPARISON_EPSILON);
 }
 
-template<> bool Util::string_to_something(const string& str, string& result){
-	result = str;
+bool Util::string_to_something(string_view str, string& result){
+	result = string(str);
 	return true;
 }
 
@@ -9,7 +9,10 @@
 #define UTIL_H_
 
 #include <string>
+#include <string_view>
 #include <sstream>
+#include <charconv>
+#include <type_traits>
 
 using namespace std;
 
@@ -17,21 +20,60 @@ namespace paleo_latitude {
 
 class Util {
 public:
-	template<class T> static bool string_to_something(const string& str, T& result){
-		istringstream iss(str);
-		T tmp;
-		if (!(iss >> tmp)) return false;
+	/**
+	 * Parses a value from a string, like operator>> would: leading whitespace is skipped, and
+	 * anything following the value is ignored. Numbers are parsed using std::from_chars (which
+	 * is locale-independent and does not allocate); negative values for unsigned types, 'inf'
+	 * and 'nan' are rejected. Returns false (leaving result untouched) if parsing fails.
+	 */
+	template<class T> static bool string_to_something(string_view str, T& result){
+		if constexpr (is_arithmetic<T>::value && !is_same<T, bool>::value){
+			return _parse_number(str, result);
+		} else {
+			istringstream iss{string(str)};
+			T tmp;
+			if (!(iss >> tmp)) return false;
 
-		result = tmp;
-		return true;
+			result = tmp;
+			return true;
+		}
 	}
 
+	/**
+	 * Copies the whole string (including spaces)
+	 */
+	static bool string_to_something(string_view str, string& result);
 
 	static bool string_ends_with(const string& some_string, const string& suffix);
 
 	static bool double_eq(const double& a, const double& b);
 
 	constexpr static double DOUBLE_COMPARISON_EPSILON = 0.0000000001;
+
+private:
+	template<class T> static bool _parse_number(string_view str, T& result){
+		const char* pos = str.data();
+		const char* end = pos + str.size();
+
+		while (pos < end && _is_space(*pos)) pos++;
+		if (pos < end && *pos == '+' && (end - pos) > 1 && pos[1] != '-') pos++;
+
+		// from_chars also accepts 'inf' and 'nan' (operator>> does not)
+		if (is_floating_point<T>::value){
+			const char* digits = (pos < end && *pos == '-') ? pos + 1 : pos;
+			if (digits == end || !((*digits >= '0' && *digits <= '9') || *digits == '.')) return false;
+		}
+
+		T tmp;
+		if (from_chars(pos, end, tmp).ec != errc()) return false;
+
+		result = tmp;
+		return true;
+	}
+
+	static bool _is_space(char c){
+		return (c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' || c == '\f');
+	}
 };
 
 };
@@ -0,0 +1,88 @@
+/*
+ * Vector3.h
+ *
+ *  Created on: 16 Oct 2026
+ *      Author: Sebastiaan J. van Schaik
+ */
+
+#ifndef VECTOR3_H_
+#define VECTOR3_H_
+
+#include <cmath>
+
+namespace paleo_latitude {
+
+/**
+ * Simple three-dimensional vector, mostly used to represent points on the unit sphere
+ * (x axis through (0,0), y axis through (0,90), z axis through the north pole).
+ */
+struct Vector3 {
+	// Written to binary data as is (see IsBinaryPacked)
+	static const bool BINARY_PACKED = true;
+
+	Vector3() : x(0), y(0), z(0) {}
+	Vector3(double x_, double y_, double z_) : x(x_), y(y_), z(z_) {}
+
+	/**
+	 * Returns the unit vector that corresponds to a latitude and longitude (in degrees)
+	 */
+	static Vector3 fromLatLon(double latitude, double longitude){
+		const double lat_rad = latitude * M_PI / 180.0;
+		const double lon_rad = longitude * M_PI / 180.0;
+		return Vector3(cos(lat_rad) * cos(lon_rad), cos(lat_rad) * sin(lon_rad), sin(lat_rad));
+	}
+
+	double dot(const Vector3& other) const {
+		return x * other.x + y * other.y + z * other.z;
+	}
+
+	Vector3 cross(const Vector3& other) const {
+		return Vector3(y * other.z - z * other.y, z * other.x - x * other.z, x * other.y - y * other.x);
+	}
+
+	double norm() const {
+		return sqrt(dot(*this));
+	}
+
+	Vector3 normalised() const {
+		const double n = norm();
+		return Vector3(x / n, y / n, z / n);
+	}
+
+	Vector3 operator+(const Vector3& other) const {
+		return Vector3(x + other.x, y + other.y, z + other.z);
+	}
+
+	Vector3 operator-(const Vector3& other) const {
+		return Vector3(x - other.x, y - other.y, z - other.z);
+	}
+
+	Vector3 operator-() const {
+		return Vector3(-x, -y, -z);
+	}
+
+	Vector3 operator*(double factor) const {
+		return Vector3(x * factor, y * factor, z * factor);
+	}
+
+	/**
+	 * Latitude (in degrees) of the point on the unit sphere in the direction of this vector
+	 */
+	double latitude() const {
+		return atan2(z, sqrt(x * x + y * y)) * 180.0 / M_PI;
+	}
+
+	/**
+	 * Longitude (in degrees, [-180,180]) of the point on the unit sphere in the direction of this vector
+	 */
+	double longitude() const {
+		return atan2(y, x) * 180.0 / M_PI;
+	}
+
+	double x, y, z;
+};
+static_assert(sizeof(Vector3) == 3 * sizeof(double), "Vector3 contains padding");
+
+};
+
+#endif /* VECTOR3_H_ */
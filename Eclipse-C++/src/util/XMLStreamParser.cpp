@@ -0,0 +1,110 @@
+/*
+ * XMLStreamParser.cpp
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: Sebastiaan J. van Schaik
+ */
+
+#include "XMLStreamParser.h"
+
+#include <cstring>
+#include <fstream>
+#include <expat.h>
+
+#include "Exception.h"
+
+using namespace std;
+using namespace paleo_latitude;
+
+const size_t XMLStreamParser::CHUNK_SIZE = 64 * 1024;
+
+XMLStreamParser::XMLStreamParser() {}
+
+XMLStreamParser::~XMLStreamParser() {
+	if (_parser != NULL) XML_ParserFree(_parser);
+	_parser = NULL;
+}
+
+void XMLStreamParser::parseFile(const string& filename) {
+	ifstream input(filename, ios::in | ios::binary);
+	if (!input.is_open()){
+		Exception ex;
+		ex << "Could not open XML file '" << filename << "'";
+		throw ex;
+	}
+
+	if (_parser != NULL) XML_ParserFree(_parser);
+	_parser = XML_ParserCreate(NULL);
+	if (_parser == NULL) throw Exception("Could not create XML parser");
+
+	XML_SetUserData(_parser, this);
+	XML_SetElementHandler(_parser, &XMLStreamParser::_handleStartElement, &XMLStreamParser::_handleEndElement);
+	XML_SetCharacterDataHandler(_parser, &XMLStreamParser::_handleCharacterData);
+	_handler_exception = nullptr;
+
+	bool done = false;
+	while (!done){
+		void* buffer = XML_GetBuffer(_parser, CHUNK_SIZE);
+		if (buffer == NULL) throw Exception("Could not allocate XML parser buffer");
+
+		input.read(static_cast<char*>(buffer), CHUNK_SIZE);
+		const streamsize num_read = input.gcount();
+		if (input.bad()){
+			Exception ex;
+			ex << "Error reading XML file '" << filename << "'";
+			throw ex;
+		}
+		done = (num_read == 0 || input.eof());
+
+		if (XML_ParseBuffer(_parser, num_read, done) == XML_STATUS_ERROR){
+			if (_handler_exception) rethrow_exception(_handler_exception);
+
+			Exception ex;
+			ex << "XML parse error on line " << XML_GetCurrentLineNumber(_parser) << " of '" << filename << "': " << XML_ErrorString(XML_GetErrorCode(_parser));
+			throw ex;
+		}
+	}
+}
+
+unsigned long XMLStreamParser::getLineNumber() const {
+	return (_parser != NULL) ? XML_GetCurrentLineNumber(_parser) : 0;
+}
+
+const char* XMLStreamParser::getAttribute(const char** attributes, const char* name) {
+	for (unsigned int i = 0; attributes[i] != NULL; i += 2){
+		if (strcmp(attributes[i], name) == 0) return attributes[i + 1];
+	}
+	return NULL;
+}
+
+void XMLStreamParser::_stop() {
+	_handler_exception = current_exception();
+	XML_StopParser(_parser, XML_FALSE);
+}
+
+void XMLStreamParser::_handleStartElement(void* user_data, const char* name, const char** attributes) {
+	XMLStreamParser* parser = static_cast<XMLStreamParser*>(user_data);
+	try {
+		parser->startElement(name, attributes);
+	} catch (...){
+		parser->_stop();
+	}
+}
+
+void XMLStreamParser::_handleEndElement(void* user_data, const char* name) {
+	XMLStreamParser* parser = static_cast<XMLStreamParser*>(user_data);
+	try {
+		parser->endElement(name);
+	} catch (...){
+		parser->_stop();
+	}
+}
+
+void XMLStreamParser::_handleCharacterData(void* user_data, const char* data, int length) {
+	XMLStreamParser* parser = static_cast<XMLStreamParser*>(user_data);
+	try {
+		parser->characterData(data, length);
+	} catch (...){
+		parser->_stop();
+	}
+}
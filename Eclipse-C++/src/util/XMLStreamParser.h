@@ -0,0 +1,74 @@
+/*
+ * XMLStreamParser.h
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: Sebastiaan J. van Schaik
+ */
+
+#ifndef XMLSTREAMPARSER_H_
+#define XMLSTREAMPARSER_H_
+
+#include <cstddef>
+#include <exception>
+#include <string>
+
+using namespace std;
+
+struct XML_ParserStruct;
+
+namespace paleo_latitude {
+
+/**
+ * Event-based (SAX-style) XML reader built on expat. The file is read in fixed-size chunks
+ * and never held in memory as a whole; subclasses handle the elements as they are encountered.
+ * Element names are reported as they appear in the file (i.e. including namespace prefixes,
+ * such as 'gml:posList'). Character data of an element may be reported in several parts.
+ */
+class XMLStreamParser {
+public:
+	XMLStreamParser();
+	XMLStreamParser(const XMLStreamParser& other) = delete;
+	virtual ~XMLStreamParser();
+
+	/**
+	 * Parses the given file. Throws an Exception if the file cannot be read or is not well-formed
+	 * (and rethrows exceptions thrown by the handlers).
+	 */
+	void parseFile(const string& filename);
+
+protected:
+	virtual void startElement(const char* name, const char** attributes) = 0;
+	virtual void endElement(const char* name) = 0;
+	virtual void characterData(const char* data, size_t length) {}
+
+	/**
+	 * Returns the line number of the current event (for error messages)
+	 */
+	unsigned long getLineNumber() const;
+
+	/**
+	 * Returns the value of an attribute in the attributes array passed to startElement(), or
+	 * NULL if there is no such attribute
+	 */
+	static const char* getAttribute(const char** attributes, const char* name);
+
+private:
+	static void _handleStartElement(void* user_data, const char* name, const char** attributes);
+	static void _handleEndElement(void* user_data, const char* name);
+	static void _handleCharacterData(void* user_data, const char* data, int length);
+	void _stop();
+
+	XML_ParserStruct* _parser = NULL;
+
+	/**
+	 * Exception thrown by a handler. Exceptions are not propagated through expat (which is C
+	 * code): parsing is stopped instead, and the exception is rethrown by parseFile().
+	 */
+	exception_ptr _handler_exception;
+
+	const static size_t CHUNK_SIZE;
+};
+
+};
+
+#endif /* XMLSTREAMPARSER_H_ */
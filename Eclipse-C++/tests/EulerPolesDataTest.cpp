@@ -12,6 +12,7 @@
 #include <set>
 
 #include "../src/paleo_latitude/PLPlate.h"
+#include "../src/util/Exception.h"
 using namespace std;
 using namespace paleo_latitude;
 
@@ -94,7 +95,7 @@ TEST_F(EulerPolesDataTest, TestRelevantAges1){
 	vector<Coordinate>* dummy_vec = new vector<Coordinate>();
 	PLPlate* plate = new PLPlate(101, "North America", dummy_vec);
 
-	vector<unsigned int> rel_ages = ep->getRelevantAges(plate, 15, 55);
+	const ArrayView<unsigned int> rel_ages = ep->getRelevantAges(plate, 15, 55);
 	vector<unsigned int> expected = {10, 20, 30, 40, 50, 60};
 
 	ASSERT_EQ(expected.size(), rel_ages.size());
@@ -110,7 +111,7 @@ TEST_F(EulerPolesDataTest, TestRelevantAges2){
 	vector<Coordinate>* dummy_vec = new vector<Coordinate>();
 	PLPlate* plate = new PLPlate(101, "North America", dummy_vec);
 
-	vector<unsigned int> rel_ages = ep->getRelevantAges(plate, 40, 60);
+	const ArrayView<unsigned int> rel_ages = ep->getRelevantAges(plate, 40, 60);
 	vector<unsigned int> expected = {40,50,60};
 
 	ASSERT_EQ(expected.size(), rel_ages.size());
@@ -128,7 +129,7 @@ TEST_F(EulerPolesDataTest, TestRelevantAges3){
 	vector<Coordinate>* dummy_vec = new vector<Coordinate>();
 	PLPlate* plate = new PLPlate(101, "North America", dummy_vec);
 
-	vector<unsigned int> rel_ages = ep->getRelevantAges(plate, 50,50);
+	const ArrayView<unsigned int> rel_ages = ep->getRelevantAges(plate, 50,50);
 	vector<unsigned int> expected = {50};
 
 	ASSERT_EQ(expected.size(), rel_ages.size());
@@ -137,3 +138,63 @@ TEST_F(EulerPolesDataTest, TestRelevantAges3){
 	delete plate;
 	delete ep;
 }
+
+/**
+ * Compares the indexed lookups (plate IDs, entries per plate and age, relevant ages) with a
+ * linear scan over all entries
+ */
+TEST_F(EulerPolesDataTest, TestIndexedLookups){
+	for (string csvfile : EulerPolesDataTest::CSV_FILES){
+		PLEulerPolesReconstructions* ep = PLEulerPolesReconstructions::readFromFile(csvfile);
+		const vector<PLEulerPolesReconstructions::EPEntry>& all_entries = ep->getAllEntries();
+
+		set<unsigned int> expected_plate_ids;
+		for (const PLEulerPolesReconstructions::EPEntry& entry : all_entries) expected_plate_ids.insert(entry.plate_id);
+		ASSERT_TRUE(expected_plate_ids == ep->getPlateIds());
+
+		for (unsigned int plate_id : expected_plate_ids){
+			set<unsigned int> ages;
+			for (const PLEulerPolesReconstructions::EPEntry& entry : all_entries){
+				if (entry.plate_id == plate_id) ages.insert(entry.age);
+			}
+
+			// Entries for every age, in the order of the CSV file
+			for (unsigned int age : ages){
+				vector<const PLEulerPolesReconstructions::EPEntry*> expected;
+				for (const PLEulerPolesReconstructions::EPEntry& entry : all_entries){
+					if (entry.plate_id == plate_id && entry.age == age) expected.push_back(&entry);
+				}
+
+				const ArrayView<const PLEulerPolesReconstructions::EPEntry*> entries = ep->getEntries(plate_id, age);
+				ASSERT_EQ(expected.size(), entries.size());
+				for (unsigned int i = 0; i < expected.size(); i++) ASSERT_EQ(expected[i], entries[i]);
+			}
+			ASSERT_THROW(ep->getEntries(plate_id, *ages.rbegin() + 1), Exception);
+
+			// Relevant ages for a range of windows: ages within the window, and the nearest age
+			// on either side of the window (unless the window border itself is available)
+			vector<Coordinate>* dummy_vec = new vector<Coordinate>();
+			PLPlate* plate = new PLPlate(plate_id, "Plate", dummy_vec);
+
+			for (unsigned int min = 0; min <= 600; min += 15){
+				for (unsigned int max = min; max <= min + 100; max += 25){
+					vector<unsigned int> expected;
+					for (unsigned int age : ages){
+						if (age >= min && age <= max) expected.push_back(age);
+					}
+					auto left = ages.upper_bound(min);
+					if (left != ages.begin() && *(--left) < min) expected.insert(expected.begin(), *left);
+					auto right = ages.lower_bound(max);
+					if (right != ages.end() && *right > max) expected.push_back(*right);
+
+					const ArrayView<unsigned int> rel_ages = ep->getRelevantAges(plate, min, max);
+					ASSERT_EQ(expected, rel_ages.to_vector()) << "plate " << plate_id << ", window [" << min << "," << max << "]";
+				}
+			}
+
+			delete plate;
+		}
+
+		delete ep;
+	}
+}
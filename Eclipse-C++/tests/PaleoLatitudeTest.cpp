@@ -10,11 +10,30 @@
 #include "PlateDataTest.h"
 #include "PolarWanderPathsDataTest.h"
 #include "../src/paleo_latitude/PLParameters.h"
+#include "../src/paleo_latitude/PLDataset.h"
+#include "../src/paleo_latitude/PLServer.h"
+#include "../src/paleo_latitude/PLSitesBatch.h"
+#include "../src/paleo_latitude/PLPaleolatitudeKernel.h"
+#include "../src/paleo_latitude/PLPlates.h"
 #include "../src/paleo_latitude/PaleoLatitude.h"
+#include "../src/paleo_latitude/exceptions/PLFileParseException.h"
 
 #include <utility>
+#include <chrono>
+#include <cstring>
+#include <thread>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <boost/algorithm/string.hpp>
+#include <boost/property_tree/ptree.hpp>
+#include <boost/property_tree/json_parser.hpp>
 
 #include "../src/util/Logger.h"
+#include "../src/util/Stats.h"
 
 using namespace std;
 using namespace paleo_latitude;
@@ -108,11 +127,698 @@ TEST_F(PaleoLatitudeTest, TestDateOrder){
 	delete params;
 }
 
+/**
+ * Verifies that PaleoLatitude objects sharing a single dataset yield the same results as
+ * PaleoLatitude objects that read the input data themselves.
+ */
+TEST_F(PaleoLatitudeTest, TestSharedDataset){
+	PLParameters* params = new PLParameters();
+	const PLDataset* dataset = PLDataset::readFromFiles(params);
+
+	const vector<pair<double,double> > sites = { make_pair(53.5, 73.5), make_pair(-33.8, 151.2), make_pair(51.5, -0.1) };
+	for (const pair<double,double>& site : sites){
+		params->site_latitude = site.first;
+		params->site_longitude = site.second;
+		params->age = 50;
+
+		PaleoLatitude pl_own(params);
+		PaleoLatitude pl_shared(params, dataset);
+		ASSERT_TRUE(pl_own.compute());
+		ASSERT_TRUE(pl_shared.compute());
+
+		ASSERT_EQ(pl_own.getPlate()->getId(), pl_shared.getPlate()->getId());
+		ASSERT_EQ(pl_own.getPaleoLatitude().palat, pl_shared.getPaleoLatitude().palat) << "Different paleolatitude for site " << site.first << "," << site.second << " when using a shared dataset";
+		ASSERT_EQ(pl_own.getPaleoLatitude().palat_min, pl_shared.getPaleoLatitude().palat_min);
+		ASSERT_EQ(pl_own.getPaleoLatitude().palat_max, pl_shared.getPaleoLatitude().palat_max);
+	}
+
+	delete dataset;
+	delete params;
+}
+
+/**
+ * Verifies that a dataset restored from a dataset bundle contains the same data as the dataset
+ * the bundle was written from (including the derived data, such as the plate raster), yields the
+ * same results, and that damaged bundles are rejected.
+ */
+TEST_F(PaleoLatitudeTest, TestDatasetBundle){
+	PLParameters* params = new PLParameters();
+	params->plates_raster_resolution = 5;
+	const PLDataset* dataset = PLDataset::readFromFiles(params);
+
+	const string bundle_file = "dataset-bundle-test.bin";
+	dataset->writeBundle(bundle_file);
+
+	PLParameters* bundle_params = new PLParameters();
+	bundle_params->input_apwp_csv = "does-not-exist.csv";
+	bundle_params->input_euler_rotation_csv = "does-not-exist.csv";
+	bundle_params->input_plates_file = "does-not-exist.gpml";
+	bundle_params->input_dataset_bundle = bundle_file;
+	const PLDataset* bundle = PLDataset::readFromFiles(bundle_params);
+
+	// Polar wander paths
+	const vector<PLPolarWanderPaths::PWPEntry>& pwp_entries = dataset->getPolarWanderPaths()->getAllEntries();
+	const vector<PLPolarWanderPaths::PWPEntry>& bundle_pwp_entries = bundle->getPolarWanderPaths()->getAllEntries();
+	ASSERT_EQ(pwp_entries.size(), bundle_pwp_entries.size());
+	for (size_t i = 0; i < pwp_entries.size(); i++){
+		ASSERT_EQ(pwp_entries[i].plate_id, bundle_pwp_entries[i].plate_id);
+		ASSERT_EQ(pwp_entries[i].age, bundle_pwp_entries[i].age);
+		ASSERT_EQ(pwp_entries[i].a95, bundle_pwp_entries[i].a95);
+		ASSERT_EQ(pwp_entries[i].latitude, bundle_pwp_entries[i].latitude);
+		ASSERT_EQ(pwp_entries[i].longitude, bundle_pwp_entries[i].longitude);
+		ASSERT_EQ(pwp_entries[i].getLineNo(), bundle_pwp_entries[i].getLineNo());
+		ASSERT_EQ(&bundle_pwp_entries[i], bundle->getPolarWanderPaths()->findEntry(pwp_entries[i].plate_id, pwp_entries[i].age));
+	}
+
+	// Euler poles and their paleopoles
+	const PLEulerPolesReconstructions* euler = dataset->getEulerPolesReconstructions();
+	const PLEulerPolesReconstructions* bundle_euler = bundle->getEulerPolesReconstructions();
+	ASSERT_EQ(euler->getAllEntries().size(), bundle_euler->getAllEntries().size());
+	ASSERT_EQ(euler->getPlateIds(), bundle_euler->getPlateIds());
+	for (size_t i = 0; i < euler->getAllEntries().size(); i++){
+		const PLEulerPolesReconstructions::EPEntry& entry = euler->getAllEntries()[i];
+		const PLEulerPolesReconstructions::EPEntry& bundle_entry = bundle_euler->getAllEntries()[i];
+		ASSERT_EQ(entry.plate_id, bundle_entry.plate_id);
+		ASSERT_EQ(entry.age, bundle_entry.age);
+		ASSERT_EQ(entry.rotation_rel_to_plate_id, bundle_entry.rotation_rel_to_plate_id);
+		ASSERT_EQ(entry.latitude, bundle_entry.latitude);
+		ASSERT_EQ(entry.longitude, bundle_entry.longitude);
+		ASSERT_EQ(entry.rotation, bundle_entry.rotation);
+
+		const PLEulerPolesReconstructions::Paleopole* paleopole = euler->getPaleopole(&entry);
+		const PLEulerPolesReconstructions::Paleopole* bundle_paleopole = bundle_euler->getPaleopole(&bundle_entry);
+		ASSERT_EQ(paleopole == NULL, bundle_paleopole == NULL);
+		if (paleopole != NULL){
+			ASSERT_EQ(paleopole->pole.x, bundle_paleopole->pole.x);
+			ASSERT_EQ(paleopole->pole.y, bundle_paleopole->pole.y);
+			ASSERT_EQ(paleopole->pole.z, bundle_paleopole->pole.z);
+			ASSERT_EQ(paleopole->a95, bundle_paleopole->a95);
+		}
+	}
+
+	// Plates
+	const vector<const PLPlate*> plates = dataset->getPlates()->getPlates();
+	const vector<const PLPlate*> bundle_plates = bundle->getPlates()->getPlates();
+	ASSERT_TRUE(bundle->getPlates()->hasRaster());
+	ASSERT_EQ(plates.size(), bundle_plates.size());
+	for (size_t i = 0; i < plates.size(); i++){
+		ASSERT_EQ(plates[i]->getId(), bundle_plates[i]->getId());
+		ASSERT_EQ(plates[i]->getName(), bundle_plates[i]->getName());
+		ASSERT_EQ(plates[i]->getBoundingBox().to_string(), bundle_plates[i]->getBoundingBox().to_string());
+		ASSERT_EQ(plates[i]->getCoordinates()->size(), bundle_plates[i]->getCoordinates()->size());
+		ASSERT_EQ(plates[i]->_ppCoordinates(), bundle_plates[i]->_ppCoordinates());
+	}
+
+	mt19937 rng(20261017);
+	uniform_real_distribution<double> dist_lat(-90, 90);
+	uniform_real_distribution<double> dist_lon(-180, 180);
+	for (unsigned int i = 0; i < 200; i++){
+		const Coordinate site(dist_lat(rng), dist_lon(rng));
+
+		string error, bundle_error;
+		const PLPlate* plate = NULL;
+		const PLPlate* bundle_plate = NULL;
+		try { plate = dataset->getPlates()->findPlate(site); } catch (Exception& ex){ error = ex.what(); }
+		try { bundle_plate = bundle->getPlates()->findPlate(site); } catch (Exception& ex){ bundle_error = ex.what(); }
+
+		ASSERT_EQ(error, bundle_error) << "Different outcome for site " << site.to_string();
+		if (plate != NULL){
+			ASSERT_EQ(plate->getId(), bundle_plate->getId()) << "Different plate for site " << site.to_string();
+		}
+	}
+
+	// Paleolatitudes
+	const vector<pair<double,double> > sites = { make_pair(53.5, 73.5), make_pair(-33.8, 151.2), make_pair(51.5, -0.1) };
+	for (const pair<double,double>& site : sites){
+		params->site_latitude = site.first;
+		params->site_longitude = site.second;
+		params->all_ages = true;
+
+		PaleoLatitude pl(params, dataset);
+		PaleoLatitude pl_bundle(params, bundle);
+		ASSERT_TRUE(pl.compute());
+		ASSERT_TRUE(pl_bundle.compute());
+
+		const auto entries = pl.getRelevantPaleolatitudeEntries();
+		const auto bundle_entries = pl_bundle.getRelevantPaleolatitudeEntries();
+		ASSERT_EQ(entries.size(), bundle_entries.size());
+		for (size_t i = 0; i < entries.size(); i++){
+			ASSERT_EQ(entries[i].age_years, bundle_entries[i].age_years);
+			ASSERT_EQ(entries[i].palat, bundle_entries[i].palat) << "Different paleolatitude for site " << site.first << "," << site.second << " when using a dataset bundle";
+			ASSERT_EQ(entries[i].palat_min, bundle_entries[i].palat_min);
+			ASSERT_EQ(entries[i].palat_max, bundle_entries[i].palat_max);
+		}
+	}
+
+	// Bundles contain no uninitialised bytes: writing the restored dataset yields the same file
+	const string rewritten_bundle_file = "dataset-bundle-test-rewritten.bin";
+	bundle->writeBundle(rewritten_bundle_file);
+	{
+		ifstream original(bundle_file, ios::binary), rewritten(rewritten_bundle_file, ios::binary);
+		const string original_data((istreambuf_iterator<char>(original)), istreambuf_iterator<char>());
+		const string rewritten_data((istreambuf_iterator<char>(rewritten)), istreambuf_iterator<char>());
+		ASSERT_TRUE(original_data == rewritten_data) << "Dataset bundle is not reproducible";
+	}
+	remove(rewritten_bundle_file.c_str());
+
+	// Damaged bundles and other files
+	{
+		fstream damaged(bundle_file, ios::in | ios::out | ios::binary);
+		damaged.seekg(1000);
+		const char byte = damaged.get();
+		damaged.seekp(1000);
+		damaged.put(~byte);
+	}
+	ASSERT_THROW(PLDataset::readFromBundle(bundle_file), PLFileParseException) << "Damaged dataset bundle not detected";
+	ASSERT_THROW(PLDataset::readFromBundle(params->input_apwp_csv), PLFileParseException);
+	ASSERT_THROW(PLDataset::readFromBundle("does-not-exist.bin"), Exception);
+	remove(bundle_file.c_str());
+
+	delete bundle;
+	delete bundle_params;
+	delete dataset;
+	delete params;
+}
+
+/**
+ * Verifies that the server yields the same output as --machine-readable, selects the requested
+ * model, reports invalid requests, and answers requests sent over its socket.
+ */
+TEST_F(PaleoLatitudeTest, TestServer){
+	PLParameters* params = new PLParameters();
+	PLParameters* model_params = new PLParameters();
+	model_params->input_apwp_csv = "data/apwp-besse-courtillot-2002-vandervoo-2015.csv";
+	model_params->input_euler_rotation_csv = "data/euler-besse-courtillot-2002.csv";
+
+	PLServer server(*params, 2);
+	server.addModel("default", PLDataset::readFromFiles(params));
+	server.addModel("besse-courtillot", PLDataset::readFromFiles(model_params));
+	ASSERT_THROW(server.addModel("default", PLDataset::readFromFiles(params)), Exception);
+
+	const string end_of_response = PLServer::END_OF_RESPONSE + "\n";
+	auto expected_response = [&](PLParameters* site_params, bool include_kml){
+		PaleoLatitude pl(site_params);
+		EXPECT_TRUE(pl.compute());
+
+		stringstream output;
+		pl.writeMachineReadable(output, include_kml);
+		return output.str() + end_of_response;
+	};
+
+	params->site_latitude = 52.5;
+	params->site_longitude = 5.1;
+	params->age = 50;
+	params->age_pm = 5;
+	const string response_age = server.handleRequest("site-lat=52.5 site-lon=5.1 age=50 age-pm=5");
+	ASSERT_EQ(expected_response(params, true), response_age);
+
+	model_params->site_latitude = -33.8;
+	model_params->site_longitude = 151.2;
+	model_params->all_ages = true;
+	const string response_model = server.handleRequest("  site-lat=-33.8\tsite-lon=151.2 all-ages model=besse-courtillot kml=0 ");
+	ASSERT_EQ(expected_response(model_params, false), response_model);
+	ASSERT_EQ(string::npos, response_model.find("#KML"));
+
+	const vector<string> invalid_requests = { "site-lat=52.5 site-lon=5.1", "site-lat=52.5 site-lon=5.1 age=50 age-pm=5 model=unknown",
+			"site-lat=abc site-lon=5.1 age=50 age-pm=5", "site-lat=52.5 site-lon=5.1 age=50 colour=red", "site-lat=95 site-lon=5.1 all-ages" };
+	for (const string& request : invalid_requests){
+		const string response = server.handleRequest(request);
+		ASSERT_EQ(0u, response.find("#error:")) << "No error for invalid request '" << request << "'";
+		ASSERT_EQ(response.find('\n') + 1, response.size() - end_of_response.size()) << "Expecting a single error line for '" << request << "'";
+		ASSERT_EQ(end_of_response, response.substr(response.size() - end_of_response.size()));
+	}
+
+	// Requests over the socket: two requests in a single message, and one without a newline
+	// at the end of the input
+	const string socket_path = "paleolatitude-server-test.sock";
+	thread server_thread([&](){ server.serve(socket_path); });
+
+	const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	ASSERT_GE(fd, 0);
+	sockaddr_un address;
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	strncpy(address.sun_path, socket_path.c_str(), sizeof(address.sun_path) - 1);
+
+	bool connected = false;
+	for (unsigned int attempt = 0; attempt < 500 && !connected; attempt++){
+		connected = (connect(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) == 0);
+		if (!connected) this_thread::sleep_for(chrono::milliseconds(10));
+	}
+	ASSERT_TRUE(connected) << "Could not connect to server";
+
+	const string requests = "site-lat=52.5 site-lon=5.1 age=50 age-pm=5\n\nsite-lat=52.5 site-lon=5.1 model=unknown\nsite-lat=-33.8 site-lon=151.2 all-ages model=besse-courtillot kml=0";
+	ASSERT_EQ((ssize_t) requests.size(), send(fd, requests.data(), requests.size(), 0));
+	shutdown(fd, SHUT_WR);
+
+	string received;
+	char buffer[4096];
+	ssize_t num_read;
+	while ((num_read = recv(fd, buffer, sizeof(buffer), 0)) > 0) received.append(buffer, num_read);
+	close(fd);
+
+	server.stop();
+	server_thread.join();
+
+	ASSERT_EQ(response_age + server.handleRequest("site-lat=52.5 site-lon=5.1 model=unknown") + response_model, received);
+
+	delete model_params;
+	delete params;
+}
+
+/**
+ * Idle connections, and connections on which a request arrives slowly, should not occupy the
+ * workers of the server: other clients should still receive responses
+ */
+TEST_F(PaleoLatitudeTest, TestServerIdleConnections){
+	PLParameters* params = new PLParameters();
+	const unsigned int num_workers = 2;
+	PLServer server(*params, num_workers);
+	server.addModel("default", PLDataset::readFromFiles(params));
+
+	const string socket_path = "paleolatitude-server-idle-test.sock";
+	thread server_thread([&](){ server.serve(socket_path); });
+
+	auto connect_client = [&socket_path](){
+		const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+		sockaddr_un address;
+		memset(&address, 0, sizeof(address));
+		address.sun_family = AF_UNIX;
+		strncpy(address.sun_path, socket_path.c_str(), sizeof(address.sun_path) - 1);
+
+		bool connected = false;
+		for (unsigned int attempt = 0; attempt < 500 && !connected; attempt++){
+			connected = (connect(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) == 0);
+			if (!connected) this_thread::sleep_for(chrono::milliseconds(10));
+		}
+
+		// Fail rather than hang if the server does not respond
+		const timeval timeout = { 10, 0 };
+		setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+		return connected ? fd : -1;
+	};
+
+	auto receive_response = [](int fd){
+		string received;
+		char buffer[4096];
+		ssize_t num_read;
+		while (received.find("\n" + PLServer::END_OF_RESPONSE + "\n") == string::npos && (num_read = recv(fd, buffer, sizeof(buffer), 0)) > 0){
+			received.append(buffer, num_read);
+		}
+		return received;
+	};
+
+	// Idle connections, and connections with an incomplete request
+	vector<int> idle_fds;
+	const string partial_request = "site-lat=52.5 site-lon=5.1 ";
+	for (unsigned int i = 0; i < 2 * num_workers; i++){
+		const int fd = connect_client();
+		ASSERT_GE(fd, 0) << "Could not connect to server";
+		if (i % 2 == 0){
+			ASSERT_EQ((ssize_t) partial_request.size(), send(fd, partial_request.data(), partial_request.size(), 0));
+		}
+		idle_fds.push_back(fd);
+	}
+
+	const string request = "site-lat=52.5 site-lon=5.1 age=50\n";
+	const string expected_response = server.handleRequest(request);
+
+	const int fd = connect_client();
+	ASSERT_GE(fd, 0) << "Could not connect to server";
+	ASSERT_EQ((ssize_t) request.size(), send(fd, request.data(), request.size(), 0));
+	ASSERT_EQ(expected_response, receive_response(fd)) << "No response while other connections are idle";
+	close(fd);
+
+	// The remainder of an incomplete request
+	const string remainder = "age=50\n";
+	ASSERT_EQ((ssize_t) remainder.size(), send(idle_fds[0], remainder.data(), remainder.size(), 0));
+	ASSERT_EQ(expected_response, receive_response(idle_fds[0]));
+
+	server.stop();
+	server_thread.join();
+	for (int idle_fd : idle_fds) close(idle_fd);
+
+	delete params;
+}
+
+/**
+ * Verifies that computing all ages in a single pass over the time series of the plate yields the
+ * same entries as computing every age separately
+ */
+TEST_F(PaleoLatitudeTest, TestAllAgesTimeSeries){
+	PLParameters* params = new PLParameters();
+	const PLDataset* dataset = PLDataset::readFromFiles(params);
+
+	params->site_latitude = 53.5;
+	params->site_longitude = 73.5;
+	params->all_ages = true;
+
+	PaleoLatitude pl_all(params, dataset);
+	ASSERT_TRUE(pl_all.compute());
+
+	const auto all_entries = pl_all.getRelevantPaleolatitudeEntries();
+	const PLEulerPolesReconstructions::TimeSeries series = dataset->getEulerPolesReconstructions()->getTimeSeries(pl_all.getPlate());
+	ASSERT_EQ(series.entries.size(), all_entries.size()) << "Expected one entry per Euler pole of the plate";
+	ASSERT_EQ(series.entries.size(), series.paleopoles.size());
+
+	params->all_ages = false;
+	for (const PaleoLatitude::PaleoLatitudeEntry& entry : all_entries){
+		ASSERT_FALSE(entry.is_interpolated);
+		params->age = entry.getAgeInMYR();
+
+		PaleoLatitude pl_age(params, dataset);
+		ASSERT_TRUE(pl_age.compute());
+
+		bool found = false;
+		for (const PaleoLatitude::PaleoLatitudeEntry& age_entry : pl_age.getRelevantPaleolatitudeEntries()){
+			if (age_entry.age_years != entry.age_years || age_entry.computed_using_plate_id != entry.computed_using_plate_id) continue;
+
+			found = true;
+			ASSERT_EQ(age_entry.palat, entry.palat) << "Different paleolatitude for age " << params->age;
+			ASSERT_EQ(age_entry.palat_min, entry.palat_min);
+			ASSERT_EQ(age_entry.palat_max, entry.palat_max);
+		}
+		ASSERT_TRUE(found) << "No entry for age " << params->age << " relative to plate " << entry.computed_using_plate_id;
+	}
+
+	delete dataset;
+	delete params;
+}
+
+/**
+ * Verifies that a batch of sites yields one line per site, that invalid sites yield the
+ * right error codes without affecting other sites, and that results match the results of
+ * individual computations.
+ */
+TEST_F(PaleoLatitudeTest, TestSitesBatch){
+	PLParameters* params = new PLParameters();
+	const PLDataset* dataset = PLDataset::readFromFiles(params);
+
+	stringstream input;
+	input << "id;latitude;longitude;age" << endl
+			<< "london;51.5;-0.1;50" << endl
+			<< "unconstrained;32;70;50" << endl
+			<< "invalid;95;0;50" << endl
+			<< "unparseable;abc;0;50" << endl
+			<< "sydney;-33.8;151.2;40;60" << endl;
+
+	stringstream output;
+	const PLSitesBatch batch(dataset, *params);
+	ASSERT_EQ(3u, batch.process(input, output)) << "Unexpected number of failed sites";
+
+	vector<vector<string> > rows;
+	string line;
+	while (getline(output, line)){
+		vector<string> values;
+		boost::split(values, line, boost::is_any_of(";"));
+		rows.push_back(values);
+	}
+
+	ASSERT_EQ(6u, rows.size()) << "Expecting a header and one line per site";
+	ASSERT_EQ(PLSitesBatch::getHeader(), output.str().substr(0, output.str().find('\n')));
+
+	const unsigned int error_code_col = 10;
+	ASSERT_EQ("london", rows[1][0]);
+	ASSERT_EQ("0", rows[1][error_code_col]);
+	ASSERT_EQ("4", rows[2][error_code_col]) << "Expecting unconstrained plate error";
+	ASSERT_EQ("2", rows[3][error_code_col]) << "Expecting invalid parameters error";
+	ASSERT_EQ("1", rows[4][error_code_col]) << "Expecting parse error";
+	ASSERT_EQ("0", rows[5][error_code_col]);
+	ASSERT_EQ("40.00", rows[5][5]);
+	ASSERT_EQ("60.00", rows[5][6]);
+
+	// Compare with individual computation
+	params->site_latitude = 51.5;
+	params->site_longitude = -0.1;
+	params->age = 50;
+	PaleoLatitude pl(params, dataset);
+	ASSERT_TRUE(pl.compute());
+
+	double batch_palat;
+	ASSERT_TRUE(Util::string_to_something(rows[1][7], batch_palat));
+	ASSERT_NEAR(pl.getPaleoLatitude().palat, batch_palat, 0.00001);
+	ASSERT_EQ(pl.getPlate()->getId(), (unsigned int) stoi(rows[1][3]));
+
+	// Processing the sites using multiple threads should yield exactly the same output
+	stringstream sites_csv;
+	sites_csv << input.str();
+	for (unsigned int i = 0; i < 50; i++) sites_csv << "site" << i << ";" << (i * 3.3 - 80) << ";" << (i * 7.1 - 175) << ";" << (i * 5) << endl;
+
+	stringstream input_st(sites_csv.str()), input_mt(sites_csv.str());
+	stringstream output_st, output_mt;
+	batch.process(input_st, output_st);
+	PLSitesBatch(dataset, *params, 4).process(input_mt, output_mt);
+	ASSERT_EQ(output_st.str(), output_mt.str()) << "Multi-threaded batch yields different output";
+
+	delete dataset;
+	delete params;
+}
+
+TEST_F(PaleoLatitudeTest, TestSitesStream){
+	PLParameters* params = new PLParameters();
+	const PLDataset* dataset = PLDataset::readFromFiles(params);
+	const PLSitesBatch batch(dataset, *params);
+
+	stringstream batch_input, batch_output;
+	batch_input << "london;51.5;-0.1;50" << endl << "sydney;-33.8;151.2;40;60" << endl;
+	batch.process(batch_input, batch_output);
+
+	stringstream input;
+	input << "london;51.5;-0.1;50" << endl
+			<< "{\"id\": \"sydney\", \"site-lat\": -33.8, \"site-lon\": 151.2, \"min-age\": 40, \"max-age\": 60}" << endl
+			<< "{\"id\": \"all\", \"site-lat\": 51.5, \"site-lon\": -0.1, \"all-ages\": true}" << endl
+			<< "{\"id\": \"unconstrained\", \"site-lat\": 32, \"site-lon\": 70, \"age\": 50}" << endl
+			<< "{\"id\": \"unknown\", \"site-lat\": 32, \"site-lon\": 70, \"colour\": \"red\"}" << endl
+			<< "{\"id\": \"broken\", " << endl
+			<< "sydney;-33.8;151.2;40;60" << endl;
+
+	for (size_t flush_interval : {1, 4}){
+		stringstream request_input(input.str());
+		stringstream output;
+		ASSERT_EQ(3u, batch.stream(request_input, output, flush_interval)) << "Unexpected number of failed requests";
+
+		vector<string> lines;
+		string line;
+		while (getline(output, line)) lines.push_back(line);
+		ASSERT_EQ(7u, lines.size()) << "Expecting one line per request";
+
+		// CSV requests yield the same output as a batch
+		const string batch_rows = batch_output.str().substr(batch_output.str().find('\n') + 1);
+		ASSERT_EQ(batch_rows, lines[0] + "\n" + lines[6] + "\n");
+
+		ASSERT_EQ(0u, lines[1].find("{\"id\":\"sydney\",\"plate_id\":")) << lines[1];
+		ASSERT_NE(string::npos, lines[1].find("\"error_code\":0,\"results\":[{\"age\":null,\"min_age\":40.00,\"max_age\":60.00,\"latitude\":null,")) << lines[1];
+		ASSERT_NE(string::npos, lines[2].find("},{\"age\":")) << "Expecting multiple ages in a single line";
+		ASSERT_EQ("{\"id\":\"unconstrained\",\"error_code\":4,\"error\":\"site is located on an unconstrained plate\"}", lines[3]);
+		ASSERT_EQ(0u, lines[4].find("{\"id\":\"unknown\",\"error_code\":1,")) << lines[4];
+		ASSERT_EQ(0u, lines[5].find("{\"id\":\"\",\"error_code\":1,")) << lines[5];
+	}
+
+	delete dataset;
+	delete params;
+}
+
+/**
+ * Input that arrives in parts, like a pipe: the next part only becomes available once the
+ * previous one has been read completely. Stores the output that has been written at the time
+ * the next part is requested.
+ */
+class PartialInputBuffer : public streambuf {
+public:
+	PartialInputBuffer(const vector<string>& parts, const stringstream& output) : _parts(parts), _output(output) {}
+
+	vector<string> output_before_part;
+
+protected:
+	int_type underflow() override {
+		if (_next_part == _parts.size()) return traits_type::eof();
+
+		output_before_part.push_back(_output.str());
+		string& part = _parts[_next_part++];
+		setg(&part[0], &part[0], &part[0] + part.size());
+		return traits_type::to_int_type(part[0]);
+	}
+
+private:
+	vector<string> _parts;
+	size_t _next_part = 0;
+	const stringstream& _output;
+};
+
+/**
+ * Requests that have only partially arrived must not delay the responses to the complete
+ * requests before them.
+ */
+TEST_F(PaleoLatitudeTest, TestSitesStreamPartialRequests){
+	PLParameters* params = new PLParameters();
+	const PLDataset* dataset = PLDataset::readFromFiles(params);
+	const PLSitesBatch batch(dataset, *params);
+
+	stringstream output;
+	PartialInputBuffer buffer({ "s1;52.5;5.1;50\ns2;52", ".5;5.1;50\ns3;52.5;5.1;50\n", "s4;52.5;5.1;50" }, output);
+	istream input(&buffer);
+	ASSERT_EQ(0u, batch.stream(input, output, 10));
+
+	ASSERT_EQ(3u, buffer.output_before_part.size());
+	ASSERT_EQ(0u, buffer.output_before_part[1].find("s1;52.5;5.1;")) << "Response to s1 delayed by partial request s2";
+	ASSERT_EQ(string::npos, buffer.output_before_part[1].find("s2;"));
+
+	vector<string> lines;
+	string line;
+	while (getline(output, line)) lines.push_back(line);
+	ASSERT_EQ(4u, lines.size()) << "Expecting one line per request";
+	for (size_t i = 0; i < lines.size(); i++){
+		ASSERT_EQ(0u, lines[i].find("s" + to_string(i + 1) + ";52.5;5.1;315;50.00;")) << lines[i];
+	}
+
+	delete dataset;
+	delete params;
+}
+
+/**
+ * A client waits for the response to every line it sends: empty lines, comments, and invalid
+ * requests (also on the first line) should all yield a single line of output
+ */
+TEST_F(PaleoLatitudeTest, TestSitesStreamMalformedLines){
+	PLParameters* params = new PLParameters();
+	const PLDataset* dataset = PLDataset::readFromFiles(params);
+	const PLSitesBatch batch(dataset, *params);
+
+	stringstream input;
+	input << "id;latitude;longitude;age" << endl
+			<< endl
+			<< "# comment" << endl
+			<< "london;51.5;-0.1;50" << endl
+			<< "london;51.5" << endl
+			<< "{\"id\": \"london\", \"site-lat\": 51.5, \"site-lon\": -0.1, \"age\": 50}" << endl
+			<< "{\"id\": " << endl;
+
+	for (size_t flush_interval : {1, 4}){
+		stringstream request_input(input.str());
+		stringstream output;
+		ASSERT_EQ(5u, batch.stream(request_input, output, flush_interval)) << "Unexpected number of failed requests";
+
+		vector<string> lines;
+		string line;
+		while (getline(output, line)) lines.push_back(line);
+		ASSERT_EQ(7u, lines.size()) << "Expecting one line per line of input";
+
+		for (size_t i : {0, 1, 2, 4}){
+			vector<string> columns;
+			boost::split(columns, lines[i], boost::is_any_of(";"));
+			ASSERT_EQ(12u, columns.size()) << lines[i];
+			ASSERT_EQ("1", columns[10]) << "Expecting ERROR_PARSE: " << lines[i];
+		}
+		ASSERT_EQ(0u, lines[3].find("london;51.5;-0.1;")) << lines[3];
+		ASSERT_EQ(0u, lines[5].find("{\"id\":\"london\",\"plate_id\":")) << lines[5];
+		ASSERT_EQ(0u, lines[6].find("{\"id\":\"\",\"error_code\":1,")) << lines[6];
+	}
+
+	delete dataset;
+	delete params;
+}
+
+TEST_F(PaleoLatitudeTest, TestWriteCSV){
+	PLParameters* params = new PLParameters();
+	params->site_latitude = 51.5;
+	params->site_longitude = -0.1;
+	params->age = 55;
+	params->age_pm = 5;
+
+	PaleoLatitude pl(params);
+	ASSERT_TRUE(pl.compute());
+
+	stringstream csv;
+	const ios::fmtflags flags = csv.flags();
+	pl.writeCSV(csv);
+
+	// Writing the CSV data should not change the state of the stream (e.g. for the KML data
+	// written after it by writeMachineReadable)
+	ASSERT_EQ(flags, csv.flags());
+	ASSERT_EQ(6, csv.precision());
+
+	vector<string> lines;
+	boost::split(lines, csv.str(), boost::is_any_of("\n"));
+	ASSERT_EQ(5u, lines.size()) << "Expecting a header, three ages and an empty last line: " << csv.str();
+	ASSERT_EQ("age;latitude;lower bound;upper bound;interpolated;relative_to", lines[0]);
+	ASSERT_EQ("", lines[4]);
+
+	for (unsigned int i = 1; i <= 3; i++){
+		vector<string> values;
+		boost::split(values, lines[i], boost::is_any_of(";"));
+		ASSERT_EQ(6u, values.size()) << lines[i];
+		ASSERT_EQ((i == 2) ? "1" : "0", values[4]) << "Only 55 Myr should be interpolated";
+		ASSERT_NE(string::npos, values[5].find(" (")) << "Expecting the name and ID of the reference plate: " << lines[i];
+	}
+
+	const PaleoLatitude::PaleoLatitudeEntry interpolated = pl.getRelevantPaleolatitudeEntries().at(1);
+	stringstream expected;
+	expected.setf(ios::fixed, ios::floatfield);
+	expected.precision(5);
+	expected << "55.00;" << interpolated.palat << ";" << interpolated.palat_min << ";" << interpolated.palat_max << ";1;";
+	ASSERT_EQ(0u, lines[2].find(expected.str())) << lines[2];
+
+	delete params;
+}
+
+TEST_F(PaleoLatitudeTest, TestStats){
+	PLParameters* params = new PLParameters();
+	params->site_latitude = 51.5;
+	params->site_longitude = -0.1;
+	params->age = 55;
+
+	// Nothing is recorded unless enabled
+	Stats::reset();
+	const PLDataset* dataset = PLDataset::readFromFiles(params);
+	ASSERT_EQ(0u, Stats::get(Stats::LOAD_DATASET).calls);
+
+	Stats::enable();
+	PaleoLatitude pl(params, dataset);
+	ASSERT_TRUE(pl.compute());
+	stringstream csv;
+	pl.writeCSV(csv);
+	Stats::disable();
+
+	ASSERT_EQ(1u, Stats::get(Stats::FIND_PLATE).calls);
+	ASSERT_LE(1u, Stats::get(Stats::PLATE_CONTAINS).calls);
+	ASSERT_LE(2u, Stats::get(Stats::ROTATION).calls) << "Expecting the ages before and after 55 Myr";
+	ASSERT_LE(1u, Stats::get(Stats::INTERPOLATION).calls);
+	ASSERT_EQ(1u, Stats::get(Stats::WRITE_OUTPUT).calls);
+	ASSERT_LT(0u, Stats::get(Stats::FIND_PLATE).nanoseconds);
+	ASSERT_EQ(0u, Stats::get(Stats::PARSE_CSV).calls);
+
+	// The summary should be valid JSON, with all stages
+	stringstream json;
+	Stats::writeJSON(json);
+	boost::property_tree::ptree summary;
+	ASSERT_NO_THROW(boost::property_tree::read_json(json, summary)) << json.str();
+	ASSERT_EQ((size_t) Stats::NUM_STAGES, summary.size());
+	ASSERT_EQ(1u, summary.get<unsigned int>("find_plate.calls"));
+
+	// Point-in-polygon tests while reading the data (nested plates, raster) are not plate lookups
+	Stats::reset();
+	Stats::enable();
+	PLParameters raster_params;
+	raster_params.plates_raster_resolution = 2;
+	const PLDataset* raster_dataset = PLDataset::readFromFiles(&raster_params);
+	Stats::disable();
+	ASSERT_EQ(1u, Stats::get(Stats::LOAD_DATASET).calls);
+	ASSERT_EQ(0u, Stats::get(Stats::FIND_PLATE).calls);
+	ASSERT_EQ(0u, Stats::get(Stats::PLATE_CONTAINS).calls);
+	delete raster_dataset;
+
+	Stats::reset();
+	ASSERT_EQ(0u, Stats::get(Stats::ROTATION).calls);
+
+	delete dataset;
+	delete params;
+}
+
 size_t PaleoLatitudeTest::TestEntry::numColumns() const {
 	return 13;
 }
 
-void PaleoLatitudeTest::TestEntry::set(unsigned int column, string value, string filename, unsigned int line_no){
+void PaleoLatitudeTest::TestEntry::set(unsigned int column, string_view value, const string& filename, unsigned int line_no){
 	CSVFileData<TestEntry>::StringEntry::set(column, value, filename, line_no);
 
 	if (value.empty()) return;
@@ -131,6 +837,91 @@ void PaleoLatitudeTest::TestEntry::set(unsigned int column, string value, string
 	if (column == EXPECTED_PALEOLATITUDE_UPPERBOUND) this->parseString(value, expected_paleolatitude_upperbound);
 }
 
+/**
+ * Verifies that the batched paleolatitude kernel (all implementations) yields the same results
+ * as PaleoLatitude for sites on a single plate
+ */
+TEST_F(PaleoLatitudeTest, TestPaleolatitudeKernel){
+	PLParameters* params = new PLParameters();
+	const PLDataset* dataset = PLDataset::readFromFiles(params);
+	const PLEulerPolesReconstructions* euler = dataset->getEulerPolesReconstructions();
+
+	// Sites on the Eurasian plate (odd number of sites, to exercise the tail of the SIMD kernels)
+	vector<Coordinate> candidates;
+	for (double lat = 20; lat <= 80; lat += 7.5){
+		for (double lon = -10; lon <= 140; lon += 12.5) candidates.push_back(Coordinate(lat, lon));
+	}
+	vector<const PLPlate*> plates;
+	dataset->getPlates()->findPlates(candidates, plates);
+
+	const PLPlate* plate = dataset->getPlates()->findPlate(53.5, 73.5);
+	vector<Coordinate> sites;
+	PLPaleolatitudeKernel::Sites kernel_sites;
+	for (size_t i = 0; i < candidates.size(); i++){
+		if (plates[i] != plate) continue;
+		sites.push_back(candidates[i]);
+		kernel_sites.add(candidates[i].latitude, candidates[i].longitude);
+	}
+	if (sites.size() % 2 == 0){
+		sites.pop_back();
+		kernel_sites.x.pop_back();
+		kernel_sites.y.pop_back();
+		kernel_sites.z.pop_back();
+	}
+	ASSERT_LE(15u, sites.size());
+
+	for (unsigned int age : { 10, 50, 100, 200, 300 }){
+		const ArrayView<const PLEulerPolesReconstructions::EPEntry*> entries = euler->getEntries(plate, age);
+		ASSERT_EQ(1u, entries.size());
+		const PLEulerPolesReconstructions::Paleopole* paleopole = euler->getPaleopole(entries[0]);
+		ASSERT_TRUE(paleopole != NULL);
+
+		PLPaleolatitudeKernel::Result expected;
+		PLPaleolatitudeKernel::compute(PLPaleolatitudeKernel::SCALAR, *paleopole, kernel_sites, expected);
+		ASSERT_EQ(sites.size(), expected.palat.size());
+
+		for (size_t i = 0; i < sites.size(); i++){
+			params->site_latitude = sites[i].latitude;
+			params->site_longitude = sites[i].longitude;
+			params->age = age;
+
+			PaleoLatitude pl(params, dataset);
+			ASSERT_TRUE(pl.compute());
+			const PaleoLatitude::PaleoLatitudeEntry entry = pl.getPaleoLatitude();
+
+			ASSERT_NEAR(entry.palat, expected.palat[i], 1e-9) << "site " << sites[i].to_string() << ", age " << age;
+			ASSERT_NEAR(entry.palat_min, expected.palat_min[i], 1e-9) << "site " << sites[i].to_string() << ", age " << age;
+			ASSERT_NEAR(entry.palat_max, expected.palat_max[i], 1e-9) << "site " << sites[i].to_string() << ", age " << age;
+		}
+
+		for (PLPaleolatitudeKernel::Implementation impl : { PLPaleolatitudeKernel::SSE2, PLPaleolatitudeKernel::AVX2 }){
+			if (!PLPaleolatitudeKernel::isAvailable(impl)) continue;
+
+			PLPaleolatitudeKernel::Result actual;
+			PLPaleolatitudeKernel::compute(impl, *paleopole, kernel_sites, actual);
+			for (size_t i = 0; i < sites.size(); i++){
+				ASSERT_NEAR(expected.palat[i], actual.palat[i], 1e-12) << PLPaleolatitudeKernel::getImplementationName(impl) << " kernel disagrees with scalar kernel";
+				ASSERT_NEAR(expected.palat_min[i], actual.palat_min[i], 1e-12) << PLPaleolatitudeKernel::getImplementationName(impl) << " kernel disagrees with scalar kernel";
+				ASSERT_NEAR(expected.palat_max[i], actual.palat_max[i], 1e-12) << PLPaleolatitudeKernel::getImplementationName(impl) << " kernel disagrees with scalar kernel";
+			}
+		}
+	}
+
+	// Without A95, no bounds are available
+	PLEulerPolesReconstructions::Paleopole no_a95 = *euler->getPaleopole(euler->getEntries(plate, 50)[0]);
+	no_a95.a95 = 0;
+	PLPaleolatitudeKernel::Result result;
+	PLPaleolatitudeKernel::compute(no_a95, kernel_sites, result);
+	for (size_t i = 0; i < sites.size(); i++){
+		ASSERT_TRUE(PaleoLatitude::is_valid_latitude(result.palat[i]));
+		ASSERT_EQ(-99999, result.palat_min[i]);
+		ASSERT_EQ(-99999, result.palat_max[i]);
+	}
+
+	delete dataset;
+	delete params;
+}
+
 TEST_F(PaleoLatitudeTest, TestLocationsFromCSV){
 	// Open 'paleolatitude-test-data.csv': specifies a number of locations,
 	// their expected plates, and their expected paleolatitudes
@@ -20,7 +20,7 @@ public:
 		TestEntry(CSVFileData<TestEntry>* parent, unsigned int line_no) : CSVFileData<TestEntry>::StringEntry(parent, line_no){}
 
 		size_t numColumns() const;
-		void set(unsigned int column, const string value, const string filename, unsigned int lineno) override;
+		void set(unsigned int column, string_view value, const string& filename, unsigned int lineno) override;
 
 		string test_name;
 		double latitude = 0;
@@ -10,9 +10,13 @@
 #include "../src/paleo_latitude/PaleoLatitude.h"
 #include "../src/paleo_latitude/PLPlate.h"
 #include "../src/paleo_latitude/PLPlates.h"
+#include "../src/paleo_latitude/PLCrossingKernel.h"
+#include "../src/paleo_latitude/exceptions/PLFileParseException.h"
 #include <boost/algorithm/string.hpp>
 #include <iostream>
 #include <fstream>
+#include <random>
+#include <sstream>
 
 using namespace std;
 using namespace paleo_latitude;
@@ -52,6 +56,302 @@ TEST_F(PlateDataTest, TestExpectedPlatesInData){
 	delete plp_gpml;
 }
 
+/**
+ * Verifies that the bounding box of every plate covers all of its coordinates, and that
+ * sites found on a plate are always within that plate's bounding box (which is what the
+ * spatial index in PLPlates relies on).
+ */
+TEST_F(PlateDataTest, TestBoundingBoxes){
+	PLPlates* plates = PLPlates::readFromFile("data/plates.gpml");
+
+	for (const PLPlate* plate : plates->getPlates()){
+		const PLPlate::BoundingBox& bbox = plate->getBoundingBox();
+		for (const Coordinate& coord : *plate->getCoordinates()){
+			ASSERT_TRUE(bbox.contains(coord)) << "Coordinate " << coord.to_string() << " of plate '" << plate->getName() << "' (" << plate->getId() << ") outside bounding box " << bbox.to_string();
+		}
+	}
+
+	// Fixed set of pseudo-random sites, so that results are reproducible
+	mt19937 rng(20140629);
+	uniform_real_distribution<double> dist_lat(-90, 90);
+	uniform_real_distribution<double> dist_lon(-180, 180);
+
+	for (unsigned int i = 0; i < 40; i++){
+		const Coordinate site(dist_lat(rng), dist_lon(rng));
+
+		for (const PLPlate* plate : plates->getPlates()){
+			if (plate->contains(site)){
+				ASSERT_TRUE(plate->getBoundingBox().contains(site)) << "Site " << site.to_string() << " is located on plate '" << plate->getName() << "' (" << plate->getId() << "), but outside its bounding box " << plate->getBoundingBox().to_string();
+			}
+		}
+	}
+
+	delete plates;
+}
+
+/**
+ * Sites on the poles and on either side of the 180 degree meridian, which used to be
+ * problematic for the point-in-polygon test.
+ */
+TEST_F(PlateDataTest, TestPolesAndDateLine){
+	testLocation(90, 0, 101, "North America");
+	testLocation(-90, 0, 802, "East Antarctica");
+	testLocation(76.0828, 178.791, 409, "Northeast Siberia");
+	testLocation(0, 179.99, 901, "Pacific Plate");
+	testLocation(0, -179.99, 901, "Pacific Plate");
+}
+
+/**
+ * Plates larger than a hemisphere: the point opposite to the centre of the vertices may be
+ * located inside such a plate, and must hence not be used as reference point (expect a warning).
+ */
+TEST_F(PlateDataTest, TestLargePlate){
+	// Band around the equator, spanning all longitudes except 170E - 170W. The edges between
+	// the vertices at 0 and 170 degrees bulge towards the poles, and the centre of the
+	// vertices is located in the gap: the point opposite to it (0,0) is inside the plate.
+	vector<Coordinate>* coordinates = new vector<Coordinate>();
+	for (double lon : { -170, 0, 170 }) coordinates->push_back(Coordinate(-60, lon));
+	for (double lon : { 170, 0, -170 }) coordinates->push_back(Coordinate(60, lon));
+
+	const PLPlate plate(999, "Large plate", coordinates);
+	ASSERT_TRUE(plate.contains(Coordinate(0, 0)));
+	ASSERT_TRUE(plate.contains(Coordinate(30, 100)));
+	ASSERT_TRUE(plate.contains(Coordinate(-75, -90)));
+	ASSERT_FALSE(plate.contains(Coordinate(0, 180)));
+	ASSERT_FALSE(plate.contains(Coordinate(80, 0)));
+	ASSERT_FALSE(plate.contains(Coordinate(-75, 0)));
+}
+
+/**
+ * Sites on plates that are located within another plate should be attributed to the
+ * innermost plate.
+ */
+TEST_F(PlateDataTest, TestNestedPlates){
+	testLocation(41.246, -68.406, 199, "Alleghanian North America");
+	testLocation(58.627, 35.213, 301, "Baltica");
+	testLocation(70.644, 104.888, 401, "Siberia");
+}
+
+/**
+ * Verifies that all point-in-polygon kernels supported by this CPU yield exactly the same
+ * number of edge crossings as the scalar implementation.
+ */
+TEST_F(PlateDataTest, TestCrossingKernels){
+	PLPlates* plates = PLPlates::readFromFile("data/plates.gpml");
+
+	mt19937 rng(20141017);
+	uniform_real_distribution<double> dist_lat(-90, 90);
+	uniform_real_distribution<double> dist_lon(-180, 180);
+
+	for (const PLPlate* plate : plates->getPlates()){
+		vector<Vector3> vertices;
+		for (const Coordinate& coord : *plate->getCoordinates()){
+			vertices.push_back(Vector3::fromLatLon(coord.latitude, coord.longitude));
+		}
+		const PLCrossingKernel::Polygon polygon = PLCrossingKernel::Polygon::fromVertices(vertices);
+
+		for (unsigned int i = 0; i < 20; i++){
+			const Vector3 site = Vector3::fromLatLon(dist_lat(rng), dist_lon(rng));
+			const Vector3 reference = Vector3::fromLatLon(dist_lat(rng), dist_lon(rng));
+			const vector<uint8_t> reference_sides = polygon.edgeSides(reference);
+
+			const unsigned int expected = PLCrossingKernel::countCrossings(PLCrossingKernel::SCALAR, polygon, site, reference, reference_sides);
+
+			for (PLCrossingKernel::Implementation impl : { PLCrossingKernel::SSE2, PLCrossingKernel::AVX2 }){
+				if (!PLCrossingKernel::isAvailable(impl)) continue;
+				ASSERT_EQ(expected, PLCrossingKernel::countCrossings(impl, polygon, site, reference, reference_sides)) << PLCrossingKernel::getImplementationName(impl) << " kernel disagrees with scalar kernel for plate '" << plate->getName() << "' (" << plate->getId() << ")";
+			}
+		}
+	}
+
+	delete plates;
+}
+
+/**
+ * Verifies that batch lookups yield the same plates (in the same order) as individual
+ * lookups, for a mix of scattered and clustered (including duplicate) sites.
+ */
+TEST_F(PlateDataTest, TestBatchLookup){
+	PLPlates* plates = PLPlates::readFromFile("data/plates.gpml");
+
+	mt19937 rng(20141018);
+	uniform_real_distribution<double> dist_lat(-90, 90);
+	uniform_real_distribution<double> dist_lon(-180, 180);
+	normal_distribution<double> dist_cluster(0, 0.5);
+
+	vector<Coordinate> sites;
+	for (unsigned int i = 0; i < 20; i++){
+		const double lat = dist_lat(rng), lon = dist_lon(rng);
+		sites.push_back(Coordinate(lat, lon));
+		sites.push_back(Coordinate(max(-90.0, min(90.0, lat + dist_cluster(rng))), lon));
+		sites.push_back(Coordinate(lat, lon));
+	}
+
+	vector<const PLPlate*> result;
+	vector<string> errors;
+	plates->findPlates(sites, result, &errors);
+	ASSERT_EQ(sites.size(), result.size());
+	ASSERT_EQ(sites.size(), errors.size());
+
+	for (unsigned int i = 0; i < sites.size(); i++){
+		const PLPlate* expected = NULL;
+		try {
+			expected = plates->findPlate(sites[i]);
+		} catch (Exception& ex){
+			ASSERT_TRUE(result[i] == NULL) << "Batch lookup found a plate for site " << sites[i].to_string() << ", individual lookup failed";
+			ASSERT_EQ(string(ex.what()), errors[i]);
+			continue;
+		}
+
+		ASSERT_EQ(expected, result[i]) << "Batch lookup yields different plate for site " << sites[i].to_string();
+		ASSERT_TRUE(errors[i].empty());
+	}
+
+	delete plates;
+}
+
+/**
+ * Verifies that plate lookups using the plate raster yield the same plates as the exact
+ * point-in-polygon test, and that the raster survives a round trip to disk.
+ */
+TEST_F(PlateDataTest, TestRaster){
+	PLPlates* plates_exact = PLPlates::readFromFile("data/plates.gpml");
+	PLPlates* plates_raster = PLPlates::readFromFile("data/plates.gpml");
+	plates_raster->buildRaster(5);
+	ASSERT_TRUE(plates_raster->hasRaster());
+
+	// Invalid resolutions, and resolutions that yield far too many cells, are rejected
+	for (double resolution : { 0.0, -1.0, 91.0, 1e-6, nan("") }){
+		ASSERT_THROW(plates_raster->enableRaster(resolution), Exception) << "Resolution " << resolution << " not rejected";
+	}
+
+	const string raster_file = "plates-raster-test.bin";
+	plates_raster->writeRaster(raster_file);
+
+	PLPlates* plates_raster_read = PLPlates::readFromFile("data/plates.gpml");
+	ASSERT_TRUE(plates_raster_read->readRaster(raster_file)) << "Could not read plate raster written by writeRaster()";
+	remove(raster_file.c_str());
+
+	mt19937 rng(20140703);
+	uniform_real_distribution<double> dist_lat(-90, 90);
+	uniform_real_distribution<double> dist_lon(-180, 180);
+
+	for (unsigned int i = 0; i < 20; i++){
+		const Coordinate site(dist_lat(rng), dist_lon(rng));
+
+		const PLPlate* expected = NULL;
+		try {
+			expected = plates_exact->findPlate(site);
+		} catch (Exception& ex){
+			// Exact test cannot decide - the raster will defer to the exact test for this site
+			continue;
+		}
+
+		ASSERT_EQ(expected->getId(), plates_raster->findPlate(site)->getId()) << "Plate raster yields different plate for site " << site.to_string();
+		ASSERT_EQ(expected->getId(), plates_raster_read->findPlate(site)->getId()) << "Plate raster read from file yields different plate for site " << site.to_string();
+	}
+
+	delete plates_exact;
+	delete plates_raster;
+	delete plates_raster_read;
+}
+
+/**
+ * Verifies that the (streaming) KML and GPML readers find the plates, names and polygons in the
+ * places where they may occur in these files, and that they ignore incomplete plates.
+ */
+TEST_F(PlateDataTest, TestStreamingReaders){
+	const string kml_file = "plates-reader-test.kml";
+	const string gpml_file = "plates-reader-test.gpml";
+
+	ofstream kml(kml_file);
+	kml << "<?xml version=\"1.0\" encoding=\"utf-8\" ?>" << endl
+			<< "<kml xmlns=\"http://www.opengis.net/kml/2.2\"><Document><Folder>" << endl
+			<< "<Placemark><name>Eurasia</name>" << endl
+			<< " <ExtendedData><SchemaData><SimpleData name=\"NAME\">x</SimpleData><SimpleData name=\"PLATEID1\">301</SimpleData></SchemaData></ExtendedData>" << endl
+			<< " <MultiGeometry>" << endl
+			<< "  <Polygon><outerBoundaryIs><LinearRing><coordinates>10,50,0 20,50,0\n 20,60,0 10,50,0</coordinates></LinearRing></outerBoundaryIs></Polygon>" << endl
+			<< "  <Polygon><outerBoundaryIs><LinearRing><coordinates>30,50 40,50 40,60 30,50</coordinates></LinearRing></outerBoundaryIs>" << endl
+			<< "   <innerBoundaryIs><LinearRing><coordinates>31,51 32,51 32,52 31,51</coordinates></LinearRing></innerBoundaryIs></Polygon>" << endl
+			<< " </MultiGeometry>" << endl
+			<< "</Placemark>" << endl
+			<< "<Placemark><name>Greenland &amp; Ellesmere</name>" << endl
+			<< " <Polygon><outerBoundaryIs><LinearRing><coordinates>-50,70 -40,70 -40,80 -50,70</coordinates></LinearRing></outerBoundaryIs></Polygon>" << endl
+			<< " <ExtendedData><SchemaData><SimpleData name=\"PLATEID1\">102</SimpleData></SchemaData></ExtendedData>" << endl
+			<< "</Placemark>" << endl
+			<< "<Placemark><name>No plate ID</name>" << endl
+			<< " <Polygon><outerBoundaryIs><LinearRing><coordinates>0,0 1,0 1,1 0,0</coordinates></LinearRing></outerBoundaryIs></Polygon>" << endl
+			<< "</Placemark>" << endl
+			<< "<Polygon><outerBoundaryIs><LinearRing><coordinates>0,0 1,0 1,1 0,0</coordinates></LinearRing></outerBoundaryIs></Polygon>" << endl
+			<< "</Folder></Document></kml>" << endl;
+	kml.close();
+
+	ofstream gpml(gpml_file);
+	gpml << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>" << endl
+			<< "<gpml:FeatureCollection xmlns:gpml=\"http://www.gplates.org/gplates\" xmlns:gml=\"http://www.opengis.net/gml\">" << endl
+			<< "<gml:featureMember><gpml:UnclassifiedFeature>" << endl
+			<< " <gpml:reconstructionPlateId><gpml:ConstantValue><gpml:value>301</gpml:value><gpml:valueType>gpml:plateId</gpml:valueType></gpml:ConstantValue></gpml:reconstructionPlateId>" << endl
+			<< " <gpml:unclassifiedGeometry><gpml:ConstantValue><gpml:value><gml:Polygon><gml:exterior><gml:LinearRing>" << endl
+			<< "  <gml:posList gml:dimension=\"2\">50 10 50 20 60 20 50 10</gml:posList>" << endl
+			<< " </gml:LinearRing></gml:exterior></gml:Polygon></gpml:value></gpml:ConstantValue></gpml:unclassifiedGeometry>" << endl
+			<< " <gml:name>Eurasia</gml:name>" << endl
+			<< "</gpml:UnclassifiedFeature></gml:featureMember>" << endl
+			<< "<gml:featureMember><gpml:ContinentalFragment><gml:name>Greenland &amp; Ellesmere</gml:name>" << endl
+			<< " <gpml:reconstructionPlateId><gpml:ConstantValue><gpml:value>102</gpml:value><gpml:valueType>gpml:plateId</gpml:valueType></gpml:ConstantValue></gpml:reconstructionPlateId>" << endl
+			<< " <gpml:reconstructionPlateId><gpml:ConstantValue><gpml:value>999</gpml:value><gpml:valueType>gpml:somethingElse</gpml:valueType></gpml:ConstantValue></gpml:reconstructionPlateId>" << endl
+			<< " <gml:posList>70 -50 70 -40 80 -40 70 -50</gml:posList>" << endl
+			<< "</gpml:ContinentalFragment></gml:featureMember>" << endl
+			<< "<gml:featureMember><gpml:UnclassifiedFeature><gml:name>No polygon</gml:name>" << endl
+			<< " <gpml:reconstructionPlateId><gpml:ConstantValue><gpml:value>103</gpml:value><gpml:valueType>gpml:plateId</gpml:valueType></gpml:ConstantValue></gpml:reconstructionPlateId>" << endl
+			<< "</gpml:UnclassifiedFeature></gml:featureMember>" << endl
+			<< "</gpml:FeatureCollection>" << endl;
+	gpml.close();
+
+	PLPlates* plates_kml = PLPlates::readFromFile(kml_file);
+	PLPlates* plates_gpml = PLPlates::readFromFile(gpml_file);
+	remove(kml_file.c_str());
+	remove(gpml_file.c_str());
+
+	const vector<const PLPlate*> kml_plates = plates_kml->getPlates();
+	ASSERT_EQ(3u, kml_plates.size()) << "Expected two parts of plate 301 and one part of plate 102 in KML file";
+	ASSERT_EQ(301u, kml_plates[0]->getId());
+	ASSERT_EQ(301u, kml_plates[1]->getId());
+	ASSERT_EQ(102u, kml_plates[2]->getId());
+	ASSERT_EQ("Eurasia", kml_plates[1]->getName());
+	ASSERT_EQ("Greenland & Ellesmere", kml_plates[2]->getName());
+	ASSERT_EQ(4u, kml_plates[0]->getCoordinates()->size());
+	ASSERT_EQ(4u, kml_plates[1]->getCoordinates()->size()) << "Inner boundary should not be part of the plate polygon";
+	ASSERT_DOUBLE_EQ(60, kml_plates[0]->getCoordinates()->at(2).latitude);
+	ASSERT_DOUBLE_EQ(20, kml_plates[0]->getCoordinates()->at(2).longitude);
+
+	const vector<const PLPlate*> gpml_plates = plates_gpml->getPlates();
+	ASSERT_EQ(2u, gpml_plates.size()) << "Expected plates 301 and 102 in GPML file";
+	ASSERT_EQ(301u, gpml_plates[0]->getId());
+	ASSERT_EQ("Eurasia", gpml_plates[0]->getName()) << "Name following the polygon definition not found";
+	ASSERT_EQ(102u, gpml_plates[1]->getId());
+	ASSERT_EQ("Greenland & Ellesmere", gpml_plates[1]->getName());
+
+	// Same polygons in both files (KML: longitude first, GPML: latitude first)
+	for (const unsigned int p : {0u, 2u}){
+		const vector<Coordinate>* kml_coords = kml_plates[p]->getCoordinates();
+		const vector<Coordinate>* gpml_coords = gpml_plates[p / 2]->getCoordinates();
+		ASSERT_EQ(kml_coords->size(), gpml_coords->size());
+		for (unsigned int i = 0; i < kml_coords->size(); i++){
+			ASSERT_DOUBLE_EQ(kml_coords->at(i).latitude, gpml_coords->at(i).latitude);
+			ASSERT_DOUBLE_EQ(kml_coords->at(i).longitude, gpml_coords->at(i).longitude);
+		}
+	}
+
+	delete plates_kml;
+	delete plates_gpml;
+
+	ofstream malformed(gpml_file);
+	malformed << "<gpml:FeatureCollection><gml:featureMember></gpml:FeatureCollection>" << endl;
+	malformed.close();
+	ASSERT_THROW(PLPlates::readFromFile(gpml_file), PLFileParseException) << "Malformed GPML file should not be accepted";
+	remove(gpml_file.c_str());
+}
+
 void PlateDataTest::_verifyPlates(const PLPlates* plplates, const string plates_file, const CSVFileData<ExpectedPlatesEntry>& expected_plates){
 	const vector<const PLPlate*> plates = plplates->getPlates();
 
@@ -186,7 +486,7 @@ void PlateDataTest::testLocation(double lat, double lon, unsigned int expected_p
 }
 
 
-void PlateDataTest::ExpectedPlatesEntry::set(unsigned int col_index, const string value, const string filename, unsigned int lineno){
+void PlateDataTest::ExpectedPlatesEntry::set(unsigned int col_index, string_view value, const string& filename, unsigned int lineno){
 	// Column index 0: plate ID (uint)
 	// Column index 1: plate name
 	auto entries = _container->getEntries();
@@ -199,3 +499,61 @@ size_t PlateDataTest::ExpectedPlatesEntry::numColumns() const {
 	return 2;
 }
 
+
+namespace {
+
+/**
+ * Placemark as written by PLPlate::writeKMLPlacemark before placemarks were cached
+ */
+string expected_kml_placemark(const PLPlate* plate, const string& linecolor, ios::fmtflags floatfield, streamsize precision){
+	stringstream ss;
+	ss.setf(floatfield, ios::floatfield);
+	ss.precision(precision);
+
+	ss << "<Placemark>" << endl
+		<< " <name>" << plate->getName() << " (" << plate->getId() << ")</name>" << endl
+		<< " <Style><LineStyle><color>" << linecolor << "</color></LineStyle><PolyStyle><fill>0</fill></PolyStyle></Style>" << endl
+		<< " <Polygon><outerBoundaryIs><LinearRing><coordinates>" << endl;
+
+	for (const Coordinate& coord : *plate->getCoordinates()){
+		ss << coord.longitude << "," << coord.latitude << " ";
+	}
+	ss << endl;
+
+	ss << " </coordinates></LinearRing></outerBoundaryIs></Polygon>" << endl;
+	ss << "</Placemark>" << endl;
+
+	return ss.str();
+}
+
+};
+
+/**
+ * The cached KML placemarks should be identical to placemarks serialised using the format of
+ * the output stream, also for formats that are not cached
+ */
+TEST_F(PlateDataTest, TestKMLPlacemarks){
+	PLPlates* plates = PLPlates::readFromFile("data/plates.gpml");
+
+	for (const PLPlate* plate : plates->getPlates()){
+		for (const string linecolor : { "440000ff", "ff0000ff" }){
+			stringstream output_default;
+			plate->writeKMLPlacemark(output_default, linecolor);
+			ASSERT_EQ(expected_kml_placemark(plate, linecolor, ios::fmtflags(), 6), output_default.str()) << "Plate " << plate->getId();
+
+			stringstream output_fixed;
+			output_fixed.setf(ios::fixed, ios::floatfield);
+			output_fixed.precision(5);
+			plate->writeKMLPlacemark(output_fixed, linecolor);
+			ASSERT_EQ(expected_kml_placemark(plate, linecolor, ios::fixed, 5), output_fixed.str()) << "Plate " << plate->getId();
+
+			stringstream output_scientific;
+			output_scientific.setf(ios::scientific, ios::floatfield);
+			output_scientific.precision(3);
+			plate->writeKMLPlacemark(output_scientific, linecolor);
+			ASSERT_EQ(expected_kml_placemark(plate, linecolor, ios::scientific, 3), output_scientific.str()) << "Plate " << plate->getId();
+		}
+	}
+
+	delete plates;
+}
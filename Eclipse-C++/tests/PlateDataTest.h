@@ -25,7 +25,7 @@ public:
 protected:
 	struct ExpectedPlatesEntry : public CSVFileData<ExpectedPlatesEntry>::Entry {
 		ExpectedPlatesEntry(CSVFileData<ExpectedPlatesEntry>* parent, unsigned int line_no) : CSVFileData<ExpectedPlatesEntry>::Entry(parent, line_no){}
-		void set(unsigned int col_index, const string value, const string filename, unsigned int lineno) override;
+		void set(unsigned int col_index, string_view value, const string& filename, unsigned int lineno) override;
 		size_t numColumns() const override;
 
 		unsigned int plate_id = 0;
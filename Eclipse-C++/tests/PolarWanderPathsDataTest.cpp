@@ -12,7 +12,9 @@
 #include "../src/util/Exception.h"
 #include <vector>
 #include <array>
+#include <fstream>
 #include <sstream>
+#include <set>
 
 using namespace std;
 using namespace paleo_latitude;
@@ -121,3 +123,118 @@ TEST_F(PolarWanderPathsDataTest, TestValueBounds){
 }
 
 
+
+/**
+ * Verifies the precomputed paleopoles (rotated reference poles) of the Euler entries, and
+ * checks that the paleolatitude obtained from them (arcsine of the inner product with the
+ * site) matches the original spherical trigonometry of the model
+ */
+TEST_F(PolarWanderPathsDataTest, TestPaleopoles){
+	for (unsigned int i = 0; i < PolarWanderPathsDataTest::CSV_FILES.size(); i++){
+		PLEulerPolesReconstructions* epr = PLEulerPolesReconstructions::readFromFile(EulerPolesDataTest::CSV_FILES[i]);
+		PLPolarWanderPaths* apwp = PLPolarWanderPaths::readFromFile(PolarWanderPathsDataTest::CSV_FILES[i]);
+
+		ASSERT_TRUE(epr->getPaleopole(&epr->getAllEntries().front()) == NULL) << "paleopole available before building the table";
+		epr->buildPaleopoles(apwp);
+
+		for (const PLEulerPolesReconstructions::EPEntry& euler_entry : epr->getAllEntries()){
+			const PLEulerPolesReconstructions::Paleopole* paleopole = epr->getPaleopole(&euler_entry);
+
+			const PLPolarWanderPaths::PWPEntry* pwp_entry = NULL;
+			try {
+				pwp_entry = apwp->getEntry(euler_entry.rotation_rel_to_plate_id, euler_entry.age);
+			} catch (Exception& ex){
+				ASSERT_TRUE(paleopole == NULL) << "paleopole available without APWP data";
+				continue;
+			}
+
+			ASSERT_TRUE(paleopole != NULL);
+			ASSERT_NEAR(1.0, paleopole->pole.norm(), 1e-12);
+			ASSERT_EQ(pwp_entry->a95, paleopole->a95);
+
+			// Original computation: rotated pole to spherical coordinates, followed by the
+			// spherical law of cosines
+			const double x_p_rot = paleopole->pole.x, y_p_rot = paleopole->pole.y, z_p_rot = paleopole->pole.z;
+			double phi_p_rot_rad = atan(y_p_rot / x_p_rot);
+			if (x_p_rot < 0) phi_p_rot_rad += M_PI;
+			if (x_p_rot >= 0 and y_p_rot <= 0) phi_p_rot_rad += 2 * M_PI;
+			const double lambda_p_rot_rad = 0.5 * M_PI - acos(z_p_rot);
+
+			for (double site_lat = -80; site_lat <= 80; site_lat += 40){
+				for (double site_lon = -150; site_lon <= 150; site_lon += 75){
+					const double lambda_s_rad = site_lat * M_PI / 180.0;
+					const double phi_s_rad = site_lon * M_PI / 180.0;
+					const double numerator = sin(lambda_p_rot_rad) * sin(lambda_s_rad) + cos(lambda_p_rot_rad) * cos(lambda_s_rad) * cos(phi_p_rot_rad - phi_s_rad);
+					const double expected = atan(numerator / sqrt(1 - pow(numerator, 2.0)));
+
+					const double actual = asin(Vector3::fromLatLon(site_lat, site_lon).dot(paleopole->pole));
+					ASSERT_NEAR(expected, actual, 1e-9) << "paleolatitude mismatch for plate " << euler_entry.plate_id << " at " << euler_entry.age << " Ma";
+				}
+			}
+		}
+
+		delete epr;
+		delete apwp;
+	}
+}
+
+/**
+ * Compares lookups in the APWP table (including irregular ages, such as 537 Ma in Torsvik)
+ * with a linear scan over all entries
+ */
+TEST_F(PolarWanderPathsDataTest, TestTableLookups){
+	for (string apwp_file : PolarWanderPathsDataTest::CSV_FILES){
+		PLPolarWanderPaths* apwp = PLPolarWanderPaths::readFromFile(apwp_file);
+
+		set<unsigned int> plate_ids = {0, 1, 99999, 4000000000u};
+		for (const PLPolarWanderPaths::PWPEntry& entry : apwp->getAllEntries()) plate_ids.insert(entry.plate_id);
+
+		for (unsigned int plate_id : plate_ids){
+			for (unsigned int age = 0; age <= 1000; age++){
+				const PLPolarWanderPaths::PWPEntry* expected = NULL;
+				for (const PLPolarWanderPaths::PWPEntry& entry : apwp->getAllEntries()){
+					if (entry.plate_id == plate_id && entry.age == age){
+						expected = &entry;
+						break;
+					}
+				}
+
+				ASSERT_EQ(expected, apwp->findEntry(plate_id, age)) << "plate " << plate_id << ", age " << age;
+				if (expected != NULL){
+					ASSERT_EQ(expected, apwp->getEntry(plate_id, age));
+				} else {
+					ASSERT_THROW(apwp->getEntry(plate_id, age), Exception);
+				}
+			}
+		}
+
+		delete apwp;
+	}
+}
+
+/**
+ * Very large ages must not make the lookup table huge (which would take gigabytes)
+ */
+TEST_F(PolarWanderPathsDataTest, TestLargeAges){
+	const string apwp_file = "apwp-large-ages-test.csv";
+	{
+		ofstream out(apwp_file);
+		out << "Apparent Polar Wander Paths - test data with very large ages,,,," << endl
+				<< "Plate ID,Age,A95,Plat,Plon" << endl
+				<< "701,0,1.9,88.5,173.9" << endl
+				<< "701,4600,3,-45,12" << endl
+				<< "701,4000000000,2,30,60" << endl;
+	}
+
+	PLPolarWanderPaths* apwp = PLPolarWanderPaths::readFromFile(apwp_file);
+	remove(apwp_file.c_str());
+
+	ASSERT_EQ(3u, apwp->getAllEntries().size());
+	ASSERT_EQ(&apwp->getAllEntries()[0], apwp->findEntry(701, 0));
+	ASSERT_EQ(&apwp->getAllEntries()[1], apwp->findEntry(701, 4600));
+	ASSERT_EQ(&apwp->getAllEntries()[2], apwp->findEntry(701, 4000000000u));
+	ASSERT_TRUE(apwp->findEntry(701, 4610) == NULL);
+	ASSERT_TRUE(apwp->findEntry(701, 3999999990u) == NULL);
+
+	delete apwp;
+}
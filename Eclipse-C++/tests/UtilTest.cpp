@@ -7,12 +7,25 @@
 
 #include "UtilTest.h"
 #include "../src/util/Util.h"
+#include "../src/util/CSVFileData.h"
+#include "../src/util/ThreadPool.h"
+#include "../src/util/Exception.h"
+#include "../src/util/Matrix3.h"
+#include "../src/util/LogStream.h"
+#include "../src/util/TextBuffer.h"
+#include <atomic>
 #include <vector>
 #include <array>
+#include <random>
 #include <sstream>
+#include <fstream>
+#include <cstdio>
+#include <boost/numeric/ublas/matrix.hpp>
+#include <boost/numeric/ublas/vector.hpp>
 
 using namespace std;
 using namespace paleo_latitude;
+namespace bnu = boost::numeric::ublas;
 
 TEST_F(UtilTest, TestStringToSomething){
 	string input = "Something with a space";
@@ -25,3 +38,247 @@ TEST_F(UtilTest, TestStringToSomething){
 	Util::string_to_something(input, output_uint);
 	ASSERT_EQ(5, output_uint);
 }
+
+/**
+ * Verifies that numbers are parsed like operator>> would (leading whitespace skipped, trailing
+ * characters ignored), also from string views that are not null-terminated
+ */
+TEST_F(UtilTest, TestNumberParsing){
+	double d = -1;
+	ASSERT_TRUE(Util::string_to_something(" \t-12.5e1;rest", d));
+	ASSERT_DOUBLE_EQ(-125, d);
+	ASSERT_TRUE(Util::string_to_something("+0.25", d));
+	ASSERT_DOUBLE_EQ(0.25, d);
+	ASSERT_TRUE(Util::string_to_something(".5\r", d));
+	ASSERT_DOUBLE_EQ(0.5, d);
+
+	const string line = "12.75;34";
+	ASSERT_TRUE(Util::string_to_something(string_view(line.data(), 4), d));
+	ASSERT_DOUBLE_EQ(12.7, d) << "Parsing should stop at the end of the string view";
+
+	d = 42;
+	ASSERT_FALSE(Util::string_to_something("", d));
+	ASSERT_FALSE(Util::string_to_something("abc", d));
+	ASSERT_FALSE(Util::string_to_something("nan", d));
+	ASSERT_FALSE(Util::string_to_something("-inf", d));
+	ASSERT_FALSE(Util::string_to_something("1e999", d));
+	ASSERT_EQ(42, d) << "Result should be untouched if parsing fails";
+
+	unsigned int u = 7;
+	ASSERT_TRUE(Util::string_to_something("701 ", u));
+	ASSERT_EQ(701u, u);
+	ASSERT_FALSE(Util::string_to_something("-5", u));
+	ASSERT_FALSE(Util::string_to_something("99999999999", u));
+	ASSERT_FALSE(Util::string_to_something("+-5", u));
+	ASSERT_EQ(701u, u);
+
+	int i = 0;
+	ASSERT_TRUE(Util::string_to_something("-320", i));
+	ASSERT_EQ(-320, i);
+}
+
+namespace {
+
+struct TestCSVEntry : public CSVFileData<TestCSVEntry>::Entry {
+	TestCSVEntry(CSVFileData<TestCSVEntry>* parent, unsigned int line_no) : CSVFileData<TestCSVEntry>::Entry(parent, line_no){}
+	void set(unsigned int col_index, string_view value, const string& filename, unsigned int lineno) override {
+		if (col_index == 0) this->parseString(value, this->id);
+		if (col_index == 1) this->parseString(value, this->value);
+		if (col_index == 2) this->name = value;
+	}
+	size_t numColumns() const override { return 3; }
+
+	unsigned int id = 0;
+	double value = 0;
+	string name;
+};
+
+};
+
+/**
+ * Verifies that CSV files are split into the right values, that headers are skipped, and that
+ * parse errors report the right line
+ */
+TEST_F(UtilTest, TestCSVFileData){
+	const string csv_file = "csv-file-data-test.csv";
+	ofstream out(csv_file);
+	out << "id;value;name" << endl << "1;0.5;first" << endl << "2,1e3;" << endl << "3;-2;third;extra" << endl;
+	out.close();
+
+	CSVFileData<TestCSVEntry> csv;
+	try {
+		csv.parseFile(csv_file);
+		FAIL() << "Line with four values should not be accepted";
+	} catch (CSVFileData<TestCSVEntry>::CSVFileDataParseException& ex){
+		ASSERT_EQ(string("Parse error on line 4 of '") + csv_file + "': expecting 3 values, got 4", ex.what());
+	}
+
+	ASSERT_EQ(2u, csv.getEntries().size());
+	ASSERT_EQ(1u, csv.getEntries()[0].id);
+	ASSERT_DOUBLE_EQ(0.5, csv.getEntries()[0].value);
+	ASSERT_EQ("first", csv.getEntries()[0].name);
+	ASSERT_DOUBLE_EQ(1000, csv.getEntries()[1].value);
+	ASSERT_EQ("", csv.getEntries()[1].name);
+
+	out.open(csv_file);
+	out << "1;0.5;first" << endl << "2;x;second" << endl;
+	out.close();
+
+	CSVFileData<TestCSVEntry> csv_invalid;
+	try {
+		csv_invalid.parseFile(csv_file);
+		FAIL() << "Invalid number should not be accepted";
+	} catch (CSVFileData<TestCSVEntry>::CSVFileDataParseException& ex){
+		ASSERT_EQ(string("Parse exception on line 2 of '") + csv_file + "': unexpected string 'x'", ex.what());
+	}
+
+	remove(csv_file.c_str());
+}
+
+/**
+ * Verifies that the thread pool runs every task exactly once (also when the pool is reused),
+ * and that exceptions thrown by tasks are passed on to the caller.
+ */
+TEST_F(UtilTest, TestThreadPool){
+	ThreadPool pool(4);
+	ASSERT_EQ(4u, pool.getNumThreads());
+
+	for (unsigned int round = 0; round < 3; round++){
+		const size_t num_tasks = 1000 + round;
+		vector<atomic<unsigned int> > counts(num_tasks);
+		for (atomic<unsigned int>& count : counts) count = 0;
+
+		pool.run(num_tasks, [&counts](size_t task){
+			// Uneven task cost, to make workers steal tasks from each other
+			volatile double x = 0;
+			for (size_t i = 0; i < (task % 7) * 1000; i++) x += i;
+			counts[task]++;
+		});
+
+		for (size_t t = 0; t < num_tasks; t++){
+			ASSERT_EQ(1u, counts[t]) << "Task " << t << " was not run exactly once";
+		}
+	}
+
+	ASSERT_THROW(pool.run(100, [](size_t task){ if (task == 42) throw Exception("task failed"); }), Exception);
+}
+
+TEST_F(UtilTest, TestLogStream){
+	stringstream target;
+	LogStream log("TEST", target);
+
+	unsigned int num_evaluations = 0;
+	auto expensive = [&num_evaluations](){ num_evaluations++; return string("value"); };
+
+	__LOG(log) << "first " << expensive() << endl;
+	log.disable();
+	__LOG(log) << "second " << expensive() << endl;
+	log.enable();
+	ASSERT_EQ("TEST: first value\n", target.str());
+	ASSERT_EQ(1u, num_evaluations) << "Operands should not be evaluated when logging is disabled";
+
+	// Lines logged by different threads must not get mixed up
+	target.str("");
+	ThreadPool pool(4);
+	pool.run(400, [&log](size_t task){
+		log << "task " << task << " of " << 400 << endl;
+	});
+
+	string line;
+	unsigned int num_lines = 0;
+	while (getline(target, line)){
+		ASSERT_EQ(0u, line.find("TEST: task ")) << line;
+		ASSERT_EQ(line.size() - 7, line.find(" of 400")) << line;
+		num_lines++;
+	}
+	ASSERT_EQ(400u, num_lines);
+}
+
+/**
+ * TextBuffer should format numbers exactly like an output stream (with ios::fixed, or in its
+ * default state)
+ */
+TEST_F(UtilTest, TestTextBuffer){
+	mt19937 generator(42);
+	uniform_real_distribution<double> values(-500, 500);
+
+	vector<double> test_values = { 0, -0.0, 0.125, 2.675, -9999, 1e-7, 89.999995, 12345678.9 };
+	for (unsigned int i = 0; i < 1000; i++) test_values.push_back(values(generator));
+
+	for (const double value : test_values){
+		for (int precision : { 0, 2, 5 }){
+			stringstream expected;
+			expected.setf(ios::fixed, ios::floatfield);
+			expected.precision(precision);
+			expected << value;
+
+			TextBuffer buffer;
+			buffer.appendFixed(value, precision);
+			ASSERT_EQ(expected.str(), buffer.str()) << "Different formatting of " << value << " with precision " << precision;
+		}
+
+		stringstream expected;
+		expected << value;
+
+		TextBuffer buffer;
+		buffer.appendGeneral(value);
+		ASSERT_EQ(expected.str(), buffer.str()) << "Different default formatting of " << value;
+	}
+
+	TextBuffer buffer;
+	buffer.append("id").append(';').appendInteger(-42).append(';').appendInteger(4294967295u);
+	ASSERT_EQ("id;-42;4294967295", buffer.str());
+
+	stringstream output;
+	buffer.writeTo(output);
+	ASSERT_EQ("id;-42;4294967295", output.str());
+	ASSERT_EQ(0u, buffer.size());
+}
+
+/**
+ * Verifies that the rotation of a pole around an Euler pole using Matrix3 matches the original
+ * computation (using boost::ublas) of PaleoLatitude::_calculatePaleolatitudeRange()
+ */
+TEST_F(UtilTest, TestMatrix3EulerRotation){
+	for (double lambda_e = -90; lambda_e <= 90; lambda_e += 15){
+		for (double phi_e = -180; phi_e < 180; phi_e += 35){
+			for (double omega = -120; omega <= 120; omega += 17.5){
+				const double theta_e_rad = (90 - lambda_e) * M_PI / 180.0;
+				const double phi_e_rad = phi_e * M_PI / 180.0;
+				const double omega_rad = omega * M_PI / 180.0;
+
+				bnu::matrix<double> L(3, 3);
+				L(0,0) = cos(phi_e_rad) * cos(theta_e_rad);	L(0,1) = -sin(phi_e_rad);	L(0,2) = cos(phi_e_rad) * sin(theta_e_rad);
+				L(1,0) = sin(phi_e_rad) * cos(theta_e_rad);	L(1,1) = cos(phi_e_rad);	L(1,2) = sin(phi_e_rad) * sin(theta_e_rad);
+				L(2,0) = -sin(theta_e_rad);					L(2,1) = 0;					L(2,2) = cos(theta_e_rad);
+
+				bnu::matrix<double> rot_matrix(3, 3);
+				rot_matrix(0,0) = cos(-omega_rad);	rot_matrix(0,1) = -sin(-omega_rad);	rot_matrix(0,2) = 0;
+				rot_matrix(1,0) = sin(-omega_rad);	rot_matrix(1,1) = cos(-omega_rad);	rot_matrix(1,2) = 0;
+				rot_matrix(2,0) = 0;				rot_matrix(2,1) = 0;				rot_matrix(2,2) = 1;
+
+				const bnu::matrix<double> L_trans = trans(L);
+				const bnu::matrix<double> L_x_rot = prod(L, rot_matrix);
+				const Matrix3 rotation = Matrix3::eulerRotation(lambda_e * M_PI / 180.0, phi_e_rad, -omega_rad);
+
+				for (double lambda_p = -85; lambda_p <= 90; lambda_p += 25){
+					for (double phi_p = -170; phi_p < 180; phi_p += 50){
+						const Vector3 pole = Vector3::fromLatLon(lambda_p, phi_p);
+						bnu::vector<double> vec_xyz_p(3);
+						vec_xyz_p(0) = pole.x;
+						vec_xyz_p(1) = pole.y;
+						vec_xyz_p(2) = pole.z;
+
+						const bnu::vector<double> Lt_x_xyz = prod(L_trans, vec_xyz_p);
+						const bnu::vector<double> expected = prod(L_x_rot, Lt_x_xyz);
+						const Vector3 actual = rotation * pole;
+
+						ASSERT_NEAR(expected(0), actual.x, 1e-12);
+						ASSERT_NEAR(expected(1), actual.y, 1e-12);
+						ASSERT_NEAR(expected(2), actual.z, 1e-12);
+					}
+				}
+			}
+		}
+	}
+}